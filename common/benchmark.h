@@ -0,0 +1,137 @@
+/*
+ * Created by Maou Lim on 2019/7/27.
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+
+namespace tools {
+
+	/* keeps the optimizer from dropping the computation of value */
+	template <typename _Tp>
+	inline void keep(const _Tp& value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	struct benchmark_result {
+		std::string name;
+		size_t      items;        // items one repetition processes
+		size_t      repetitions;
+		double      median_ns;    // of a repetition
+		double      p99_ns;
+		double      min_ns;
+		double      mean_ns;
+
+		double items_per_second() const { return 0.0 < median_ns ? items * 1e9 / median_ns : 0.0; }
+	};
+
+	/**
+	 * @note Times op() a few times to warm caches and the allocator up,
+	 *       then `repetitions` more, and keeps the median, the 99th
+	 *       percentile (nearest rank, so the slowest repetition unless
+	 *       there are more than a hundred), the fastest and the mean.
+	 *
+	 *       Whatever op returns is destroyed after the clock stopped,
+	 *       so a benchmark building a container does not pay for
+	 *       tearing it down, and is kept so it cannot be optimized out.
+	 *
+	 *       Benchmarks whose name does not contain the filter are
+	 *       skipped; the results go to a table and to JSON.
+	 */
+	class benchmark_suite {
+	public:
+		explicit benchmark_suite(size_t warmup = 2, size_t repetitions = 15) :
+			m_warmup(warmup), m_repetitions(0 == repetitions ? 1 : repetitions) { }
+
+		void set_filter(const std::string& filter) { m_filter = filter; }
+
+		template <typename _Op>
+		void run(const std::string& name, size_t items, _Op op) {
+			typedef std::chrono::steady_clock clock_type;
+
+			if (!m_filter.empty() && std::string::npos == name.find(m_filter)) { return; }
+
+			for (size_t i = 0; i < m_warmup; ++i) { keep(op()); }
+
+			std::vector<double> samples(m_repetitions);
+			for (auto& each : samples) {
+				const auto start = clock_type::now();
+				const auto result = op();
+				each = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+				keep(result);
+			}
+
+			std::sort(samples.begin(), samples.end());
+			double total = 0.0;
+			for (auto each : samples) { total += each; }
+
+			const size_t n = samples.size();
+			const size_t rank = (99 * n + 99) / 100;
+
+			benchmark_result result;
+			result.name        = name;
+			result.items       = items;
+			result.repetitions = n;
+			result.median_ns   = 0 == n % 2 ? 0.5 * (samples[n / 2 - 1] + samples[n / 2]) : samples[n / 2];
+			result.p99_ns      = samples[std::min(n, std::max<size_t>(rank, 1)) - 1];
+			result.min_ns      = samples.front();
+			result.mean_ns     = total / n;
+			m_results.push_back(result);
+		}
+
+		const std::vector<benchmark_result>& results() const { return m_results; }
+
+		void print(std::ostream& stream) const {
+			char line[256];
+			std::snprintf(line, sizeof (line), "%-40s %12s %12s %14s\n", "benchmark", "median ms", "p99 ms", "items/s");
+			stream << line;
+			for (auto& each : m_results) {
+				std::snprintf(
+					line, sizeof (line), "%-40s %12.3f %12.3f %14.4g\n",
+					each.name.c_str(), each.median_ns * 1e-6, each.p99_ns * 1e-6, each.items_per_second()
+				);
+				stream << line;
+			}
+		}
+
+		void write_json(std::ostream& stream) const {
+			stream << "{\n  \"context\": {\"compiler\": \"" << _escape(__VERSION__) << "\", \"warmup\": " << m_warmup
+			       << ", \"repetitions\": " << m_repetitions << "},\n  \"benchmarks\": [";
+
+			for (size_t i = 0; i < m_results.size(); ++i) {
+				const auto& each = m_results[i];
+				stream << (0 == i ? "\n" : ",\n") << "    {\"name\": \"" << _escape(each.name) << "\", \"items\": " << each.items
+				       << ", \"repetitions\": " << each.repetitions << ", \"median_ns\": " << each.median_ns
+				       << ", \"p99_ns\": " << each.p99_ns << ", \"min_ns\": " << each.min_ns << ", \"mean_ns\": " << each.mean_ns
+				       << ", \"items_per_second\": " << each.items_per_second() << "}";
+			}
+			stream << "\n  ]\n}\n";
+		}
+
+	private:
+		static std::string _escape(const std::string& text) {
+			std::string result;
+			for (char c : text) {
+				if ('"' == c || '\\' == c) { result.push_back('\\'); }
+				result.push_back(c);
+			}
+			return result;
+		}
+
+		size_t                        m_warmup;
+		size_t                        m_repetitions;
+		std::string                   m_filter;
+		std::vector<benchmark_result> m_results;
+	};
+}
+
+#endif //_BENCHMARK_H_
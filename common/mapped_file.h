@@ -0,0 +1,96 @@
+/*
+ * Created by Maou Lim on 2019/7/8.
+ */
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "defines.h"
+#include "trace.h"
+
+namespace tools {
+
+	/**
+	 * @note Read-only memory mapping of a whole file. The pages are
+	 *       loaded lazily by the kernel, so parsers can walk the bytes
+	 *       in place without copying them into a buffer first. An
+	 *       empty file maps to an empty range.
+	 */
+	class mapped_file {
+	public:
+		mapped_file() = default;
+
+		explicit mapped_file(const std::string& path) { open(path); }
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		mapped_file(mapped_file&& other) noexcept :
+			m_data(other.m_data), m_size(other.m_size), m_mapped(other.m_mapped)
+		{
+			other.m_data = nullptr; other.m_size = 0; other.m_mapped = false;
+		}
+
+		mapped_file& operator=(mapped_file&& other) noexcept {
+			if (this == &other) { return *this; }
+			close();
+			m_data   = other.m_data;
+			m_size   = other.m_size;
+			m_mapped = other.m_mapped;
+			other.m_data = nullptr; other.m_size = 0; other.m_mapped = false;
+			return *this;
+		}
+
+		~mapped_file() { close(); }
+
+		bool open(const std::string& path) {
+			close();
+
+			TOOLS_TRACE_SCOPE("mapped_file::open");
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) { return false; }
+
+			struct stat info;
+			if (0 != ::fstat(fd, &info)) { ::close(fd); return false; }
+
+			m_size = (size_t) info.st_size;
+			if (0 == m_size) { ::close(fd); m_mapped = true; return true; }
+
+			void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+
+			if (MAP_FAILED == addr) { m_size = 0; return false; }
+
+			::madvise(addr, m_size, MADV_SEQUENTIAL);
+			m_data   = static_cast<const char*>(addr);
+			m_mapped = true;
+			return true;
+		}
+
+		void close() {
+			if (nullptr != m_data) { ::munmap(const_cast<char*>(m_data), m_size); }
+			m_data = nullptr; m_size = 0; m_mapped = false;
+		}
+
+		bool is_open() const { return m_mapped; }
+
+		const char* data()  const { return m_data; }
+		const char* begin() const { return m_data; }
+		const char* end()   const { return m_data + m_size; }
+		size_t      size()  const { return m_size; }
+
+	private:
+		const char* m_data   = nullptr;
+		size_t      m_size   = 0;
+		bool        m_mapped = false;
+	};
+}
+
+#endif //_MAPPED_FILE_H_
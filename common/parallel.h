@@ -0,0 +1,324 @@
+/*
+ * Created by Maou Lim on 2019/7/2.
+ */
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "defines.h"
+
+namespace tools {
+
+	inline size_t concurrency() {
+		const unsigned int n = std::thread::hardware_concurrency();
+		return 0 == n ? 1 : n;
+	}
+
+	/**
+	 * @note Splits [first, last) into contiguous chunks of at least
+	 *       `grain` indices and calls op(chunk_first, chunk_last) for
+	 *       each of them concurrently. The calling thread works on the
+	 *       first chunk and joins the others before returning, so the
+	 *       ranges never overlap and no synchronization is needed when
+	 *       op only writes to its own chunk.
+	 */
+	template <typename _RangeOp>
+	void parallel_for(size_t first, size_t last, size_t grain, _RangeOp op) {
+		if (last <= first) { return; }
+
+		const size_t total  = last - first;
+		const size_t min_sz = 0 == grain ? 1 : grain;
+
+		size_t chunks = total / min_sz;
+		if (concurrency() < chunks) { chunks = concurrency(); }
+
+		if (chunks < 2) { op(first, last); return; }
+
+		const size_t step = total / chunks, rest = total % chunks;
+
+		std::vector<std::thread> workers;
+		workers.reserve(chunks - 1);
+
+		size_t begin = first + step + (0 < rest ? 1 : 0);
+		for (size_t i = 1; i < chunks; ++i) {
+			const size_t end = begin + step + (i < rest ? 1 : 0);
+			workers.emplace_back([&op, begin, end]() { op(begin, end); });
+			begin = end;
+		}
+
+		op(first, first + step + (0 < rest ? 1 : 0));
+
+		for (auto& each : workers) { each.join(); }
+	}
+
+	/**
+	 * @note Fixed set of worker threads for fork-join jobs that are
+	 *       issued over and over (one per mini-batch, say), where
+	 *       starting threads every time as parallel_for does would cost
+	 *       more than the job. run() hands out task indices through an
+	 *       atomic counter, the calling thread takes tasks as well, and
+	 *       it returns once all of them are done. One run() at a time:
+	 *       it must not be called concurrently or from inside a task.
+	 */
+	class thread_pool {
+	public:
+		explicit thread_pool(size_t threads = concurrency()) :
+			m_invoke(nullptr), m_op(nullptr), m_tasks(0), m_next(0),
+			m_generation(0), m_active(0), m_stop(false)
+		{
+			const size_t workers = 0 == threads ? 0 : threads - 1;
+			m_workers.reserve(workers);
+			for (size_t i = 0; i < workers; ++i) {
+				m_workers.emplace_back([this]() { _work(); });
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		~thread_pool() {
+			{
+				std::lock_guard<std::mutex> guard(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& each : m_workers) { each.join(); }
+		}
+
+		/* threads taking part in a run, the caller included */
+		size_t size() const { return m_workers.size() + 1; }
+
+		template <typename _TaskOp>
+		void run(size_t tasks, _TaskOp op) {
+			if (0 == tasks) { return; }
+			if (m_workers.empty() || 1 == tasks) {
+				for (size_t i = 0; i < tasks; ++i) { op(i); }
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> guard(m_mutex);
+				m_invoke = [](void* target, size_t task) { (*static_cast<_TaskOp*>(target))(task); };
+				m_op     = &op;
+				m_tasks  = tasks;
+				m_next.store(0, std::memory_order_relaxed);
+				m_active = m_workers.size();
+				++m_generation;
+			}
+			m_wake.notify_all();
+
+			_drain();
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this]() { return 0 == m_active; });
+			m_op = nullptr;
+		}
+
+	private:
+		void _drain() {
+			size_t task;
+			while ((task = m_next.fetch_add(1, std::memory_order_relaxed)) < m_tasks) {
+				m_invoke(m_op, task);
+			}
+		}
+
+		void _work() {
+			size_t seen = 0;
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_wake.wait(lock, [this, seen]() { return m_stop || seen != m_generation; });
+					if (m_stop) { return; }
+					seen = m_generation;
+				}
+
+				_drain();
+
+				std::lock_guard<std::mutex> guard(m_mutex);
+				if (0 == --m_active) { m_done.notify_one(); }
+			}
+		}
+
+		void (*m_invoke)(void*, size_t);
+		void*               m_op;
+		size_t              m_tasks;
+		std::atomic<size_t> m_next;
+
+		size_t m_generation;
+		size_t m_active;
+		bool   m_stop;
+
+		std::mutex               m_mutex;
+		std::condition_variable  m_wake, m_done;
+		std::vector<std::thread> m_workers;
+	};
+
+	/* tasks of a work_stealing_pool that are waited for together */
+	class task_group {
+	public:
+		task_group() : m_pending(0) { }
+
+		task_group(const task_group&) = delete;
+		task_group& operator=(const task_group&) = delete;
+
+		bool done() const { return 0 == m_pending.load(std::memory_order_acquire); }
+
+	private:
+		friend class work_stealing_pool;
+		std::atomic<size_t> m_pending;
+	};
+
+	/**
+	 * @note Pool for recursive fork-join work (subtrees, quicksort
+	 *       halves, ...) where tasks spawn tasks. Each worker has its
+	 *       own deque: it pushes and pops its newest tasks at the back,
+	 *       depth first and cache warm, and when it runs dry it steals
+	 *       the oldest, largest tasks from the front of the others'.
+	 *
+	 *       wait(group) runs tasks on the calling thread until every
+	 *       task of the group is done, so it may be called from inside a
+	 *       task without starving the pool. Threads that are not
+	 *       workers (the one that made the pool) share one extra deque.
+	 */
+	class work_stealing_pool {
+	public:
+		explicit work_stealing_pool(size_t threads = concurrency()) :
+			m_queues(0 == threads ? 1 : threads), m_queued(0), m_stop(false)
+		{
+			for (auto& each : m_queues) { each.reset(new _queue()); }
+
+			/* queue 0 is the callers', workers own the others */
+			m_workers.reserve(m_queues.size() - 1);
+			for (size_t i = 1; i < m_queues.size(); ++i) {
+				m_workers.emplace_back([this, i]() { _work(i); });
+			}
+		}
+
+		work_stealing_pool(const work_stealing_pool&) = delete;
+		work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+		~work_stealing_pool() {
+			{
+				std::lock_guard<std::mutex> guard(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& each : m_workers) { each.join(); }
+		}
+
+		/* threads running tasks, a caller waiting included */
+		size_t size() const { return m_queues.size(); }
+
+		template <typename _Task>
+		void spawn(task_group& group, _Task task) {
+			group.m_pending.fetch_add(1, std::memory_order_relaxed);
+
+			_queue& queue = *m_queues[_self()];
+			{
+				std::lock_guard<std::mutex> guard(queue.mutex);
+				queue.tasks.push_back(_task { std::function<void()>(std::move(task)), &group });
+			}
+			m_queued.fetch_add(1, std::memory_order_release);
+
+			if (!m_workers.empty()) {
+				std::lock_guard<std::mutex> guard(m_mutex);
+				m_wake.notify_one();
+			}
+		}
+
+		void wait(task_group& group) {
+			const size_t self = _self();
+			while (!group.done()) {
+				if (!_run_one(self)) { std::this_thread::yield(); }
+			}
+		}
+
+	private:
+		struct _task {
+			std::function<void()> run;
+			task_group*           group;
+		};
+
+		struct _queue {
+			std::mutex         mutex;
+			std::deque<_task> tasks;
+		};
+
+		/* the deque of the calling thread */
+		size_t _self() const {
+			return this == _current_pool() ? _current_index() : 0;
+		}
+
+		static const work_stealing_pool*& _current_pool() {
+			static thread_local const work_stealing_pool* pool = nullptr;
+			return pool;
+		}
+
+		static size_t& _current_index() {
+			static thread_local size_t index = 0;
+			return index;
+		}
+
+		/* newest own task first, else the oldest one of another deque */
+		bool _run_one(size_t self) {
+			_task task;
+			bool found = false;
+
+			for (size_t k = 0; k < m_queues.size() && !found; ++k) {
+				_queue& queue = *m_queues[(self + k) % m_queues.size()];
+				std::lock_guard<std::mutex> guard(queue.mutex);
+				if (queue.tasks.empty()) { continue; }
+
+				if (0 == k) {
+					task = std::move(queue.tasks.back());
+					queue.tasks.pop_back();
+				}
+				else {
+					task = std::move(queue.tasks.front());
+					queue.tasks.pop_front();
+				}
+				found = true;
+			}
+			if (!found) { return false; }
+
+			m_queued.fetch_sub(1, std::memory_order_relaxed);
+			task.run();
+			task.group->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+
+		void _work(size_t index) {
+			_current_pool()  = this;
+			_current_index() = index;
+
+			while (true) {
+				if (_run_one(index)) { continue; }
+
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [this]() {
+					return m_stop || 0 != m_queued.load(std::memory_order_acquire);
+				});
+				if (m_stop) { return; }
+			}
+		}
+
+		std::vector<std::unique_ptr<_queue>> m_queues;
+		std::atomic<size_t>                  m_queued;
+		bool                                 m_stop;
+
+		std::mutex               m_mutex;
+		std::condition_variable  m_wake;
+		std::vector<std::thread> m_workers;
+	};
+}
+
+#endif //_PARALLEL_H_
@@ -0,0 +1,207 @@
+/*
+ * Created by Maou Lim on 2019/7/29.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "defines.h"
+
+/**
+ * @note TOOLS_TRACE_SCOPE("name") times the rest of the enclosing
+ *       scope when _TOOLS_TRACE_ is defined, and expands to nothing
+ *       otherwise. The name must outlive the trace, a string literal.
+ */
+#define _TOOLS_TRACE_CONCAT_(a, b) a##b
+#define _TOOLS_TRACE_CONCAT(a, b) _TOOLS_TRACE_CONCAT_(a, b)
+
+#ifdef _TOOLS_TRACE_
+#define TOOLS_TRACE_SCOPE(name) const tools::trace_scope _TOOLS_TRACE_CONCAT(_trace_scope_, __LINE__)(name)
+#else
+#define TOOLS_TRACE_SCOPE(name)
+#endif
+
+namespace tools {
+
+	/* the TSC on x86, assumed invariant, steady_clock ns elsewhere */
+	inline uint64_t trace_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count();
+#endif
+	}
+
+	struct trace_event {
+		const char* name;
+		uint64_t    start;    // ticks since the trace began
+		uint64_t    duration; // ticks
+	};
+
+	/**
+	 * @note The events of one thread, the latest `capacity` of them.
+	 *       Only the owning thread records; reading them back is meant
+	 *       for when the traced threads are idle, e.g. after a pool
+	 *       finished its run.
+	 */
+	class trace_buffer {
+	public:
+		static const size_t capacity = 1 << 16;
+
+		explicit trace_buffer(size_t id) : m_events(capacity), m_written(0), m_id(id) { }
+
+		void record(const char* name, uint64_t start, uint64_t duration) {
+			const uint64_t k = m_written.load(std::memory_order_relaxed);
+			m_events[k & (capacity - 1)] = trace_event { name, start, duration };
+			m_written.store(k + 1, std::memory_order_release);
+		}
+
+		size_t id() const { return m_id; }
+
+		/* op on every event still held, oldest first */
+		template <typename _Op>
+		void each(_Op op) const {
+			const uint64_t written = m_written.load(std::memory_order_acquire);
+			for (uint64_t k = capacity < written ? written - capacity : 0; k < written; ++k) {
+				op(m_events[k & (capacity - 1)]);
+			}
+		}
+
+		void clear() { m_written.store(0, std::memory_order_relaxed); }
+
+	private:
+		std::vector<trace_event> m_events;
+		std::atomic<uint64_t>    m_written;
+		size_t                   m_id;
+	};
+
+	/* the buffers of all threads that ever traced, kept after they exit */
+	class trace_registry {
+		typedef std::chrono::steady_clock clock_type;
+
+	public:
+		static trace_registry& instance() {
+			static trace_registry registry;
+			return registry;
+		}
+
+		uint64_t now() const { return trace_ticks() - m_epoch_ticks; }
+
+		trace_buffer& local() {
+			static thread_local trace_buffer* buffer = nullptr;
+			if (nullptr == buffer) {
+				std::lock_guard<std::mutex> guard(m_mutex);
+				m_buffers.emplace_back(new trace_buffer(m_buffers.size()));
+				buffer = m_buffers.back().get();
+			}
+			return *buffer;
+		}
+
+		/**
+		 * @note All events as complete ("X") events of the Chrome trace
+		 *       format, in us. Ticks become time at the rate they went
+		 *       at since the trace began, so nothing is calibrated up
+		 *       front.
+		 */
+		bool flush(const std::string& path) {
+			std::ofstream stream(path);
+			if (!stream) { return false; }
+
+			const double elapsed_ns = std::chrono::duration<double, std::nano>(clock_type::now() - m_epoch).count();
+			const uint64_t elapsed_ticks = now();
+			const double us_per_tick = 0 == elapsed_ticks ? 0.0 : elapsed_ns * 1e-3 / elapsed_ticks;
+
+			std::lock_guard<std::mutex> guard(m_mutex);
+			stream << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+			bool first = true;
+			char line[64];
+			for (auto& buffer : m_buffers) {
+				const size_t tid = buffer->id();
+				buffer->each([&](const trace_event& e) {
+					stream << (first ? "\n" : ",\n") << "{\"name\": \"" << _escape(e.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid;
+					std::snprintf(line, sizeof (line), ", \"ts\": %.3f, \"dur\": %.3f}", e.start * us_per_tick, e.duration * us_per_tick);
+					stream << line;
+					first = false;
+				});
+			}
+			stream << "\n]}\n";
+			return (bool) stream;
+		}
+
+		void clear() {
+			std::lock_guard<std::mutex> guard(m_mutex);
+			for (auto& buffer : m_buffers) { buffer->clear(); }
+		}
+
+	private:
+		trace_registry() : m_epoch(clock_type::now()), m_epoch_ticks(trace_ticks()) { }
+
+		static std::string _escape(const char* text) {
+			std::string result;
+			for (; '\0' != *text; ++text) {
+				if ('"' == *text || '\\' == *text) { result.push_back('\\'); }
+				result.push_back(*text);
+			}
+			return result;
+		}
+
+		std::mutex                                 m_mutex;
+		std::vector<std::unique_ptr<trace_buffer>> m_buffers;
+		clock_type::time_point                     m_epoch;
+		uint64_t                                   m_epoch_ticks;
+	};
+
+	/* records the time from its construction to its destruction into this thread's buffer */
+	class trace_scope {
+	public:
+		explicit trace_scope(const char* name) :
+			m_name(name), m_start(trace_registry::instance().now()) { }
+
+		trace_scope(const trace_scope&) = delete;
+		trace_scope& operator=(const trace_scope&) = delete;
+
+		~trace_scope() {
+			trace_registry& registry = trace_registry::instance();
+			registry.local().record(m_name, m_start, registry.now() - m_start);
+		}
+
+	private:
+		const char* m_name;
+		uint64_t    m_start;
+	};
+
+	/* drops what was traced so far */
+	inline void trace_clear() {
+#ifdef _TOOLS_TRACE_
+		trace_registry::instance().clear();
+#endif
+	}
+
+	/* writes what was traced to path, false when tracing is compiled out or the file fails */
+	inline bool trace_flush(const std::string& path) {
+#ifdef _TOOLS_TRACE_
+		return trace_registry::instance().flush(path);
+#else
+		(void) path;
+		return false;
+#endif
+	}
+}
+
+#endif //_TRACE_H_
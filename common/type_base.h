@@ -7,6 +7,8 @@
 
 #include <type_traits>
 
+#include "defines.h"
+
 namespace tools {
 
 	/* _true or _false */
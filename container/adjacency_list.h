@@ -24,15 +24,15 @@ namespace tools {
 		_link(const value_type& _val, link_type _to) : val(_val), link_to(_to) { }
 	};
 
-	template <typename _Val, _Val _Unreachable>
+	template <typename _Val, _Val _Unreachable, typename _Allocator>
 	class adjacency_list;
 
-	template <typename _Val, typename _LinkItr, _Val _Unreachable>
+	template <typename _Val, typename _LinkItr, _Val _Unreachable, typename _Allocator>
 	struct _adjacency_list_itr_base {
 	protected:
-		typedef adjacency_list<_Val, _Unreachable> list_type;
-		typedef typename list_type::iterator       vertex_iterator;
-		typedef _LinkItr                           link_iterator;
+		typedef adjacency_list<_Val, _Unreachable, _Allocator> list_type;
+		typedef typename list_type::iterator                   vertex_iterator;
+		typedef _LinkItr                                       link_iterator;
 	public:
 		typedef _Val                               value_type;
 		typedef std::forward_iterator_tag          iterator_category;
@@ -66,16 +66,16 @@ namespace tools {
 	};
 
 	template <
-	    typename _Val, typename _LinkItr, _Val _Unreachable
+	    typename _Val, typename _LinkItr, _Val _Unreachable, typename _Allocator
 	>
 	class _adjacency_list_itr :
-		public _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable> {
+		public _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable, _Allocator> {
 
-		typedef _adjacency_list_itr<_Val, _LinkItr, _Unreachable>      self_type;
-		typedef _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable> base_type;
-		typedef typename base_type::link_iterator                      link_iterator;
-		typedef typename base_type::vertex_iterator                    vertex_iterator;
-		typedef typename base_type::list_type                          list_type;
+		typedef _adjacency_list_itr<_Val, _LinkItr, _Unreachable, _Allocator>      self_type;
+		typedef _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable, _Allocator> base_type;
+		typedef typename base_type::link_iterator                                  link_iterator;
+		typedef typename base_type::vertex_iterator                                vertex_iterator;
+		typedef typename base_type::list_type                                      list_type;
 
 	public:
 		typedef typename base_type::iterator_category iterator_category;
@@ -104,15 +104,15 @@ namespace tools {
 		}
 	};
 
-	template <typename _Val, typename _LinkItr, _Val _Unreachable>
+	template <typename _Val, typename _LinkItr, _Val _Unreachable, typename _Allocator>
 	class _const_adjacency_list_itr :
-		public _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable> {
+		public _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable, _Allocator> {
 
-		typedef _const_adjacency_list_itr<_Val, _LinkItr, _Unreachable> self_type;
-		typedef _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable>  base_type;
-		typedef typename base_type::link_iterator                       link_iterator;
-		typedef typename base_type::vertex_iterator                     vertex_iterator;
-		typedef typename base_type::list_type                           list_type;
+		typedef _const_adjacency_list_itr<_Val, _LinkItr, _Unreachable, _Allocator> self_type;
+		typedef _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable, _Allocator>  base_type;
+		typedef typename base_type::link_iterator                                   link_iterator;
+		typedef typename base_type::vertex_iterator                                 vertex_iterator;
+		typedef typename base_type::list_type                                       list_type;
 
 	public:
 		typedef typename base_type::iterator_category iterator_category;
@@ -141,16 +141,18 @@ namespace tools {
 		}
 	};
 
-	template <typename _Val, typename _LinkItr, _Val _Unreachable>
+	template <typename _Val, typename _LinkItr, _Val _Unreachable, typename _Allocator>
 	bool operator==(
-		const _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable>& left,
-		const _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable>& right
+		const _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable, _Allocator>& left,
+		const _adjacency_list_itr_base<_Val, _LinkItr, _Unreachable, _Allocator>& right
 	) {
 		if (left.is_end() && right.is_end()) { return true; }
 		return left.current == right.current && left.start_with == right.start_with;
 	}
 
-	template <typename _Val, _Val _Unreachable = static_cast<_Val>(0)>
+	template <
+		typename _Val, _Val _Unreachable = static_cast<_Val>(0), typename _Allocator = std::allocator<_Val>
+	>
 	class adjacency_list {
 	public:
 		typedef _Val        value_type;
@@ -164,17 +166,17 @@ namespace tools {
 		static const value_type unreachable;
 
 	private:
-		typedef _link<_Val, size_type>               link_type;
-		typedef tools::bidirectional_list<link_type> element_type;
-		typedef tools::sequence<element_type>        rep_type;
-		typedef adjacency_list<_Val, _Unreachable>   self_type;
+		typedef _link<_Val, size_type>                           link_type;
+		typedef tools::bidirectional_list<link_type, _Allocator> element_type;
+		typedef tools::sequence<element_type, _Allocator>        rep_type;
+		typedef adjacency_list<_Val, _Unreachable, _Allocator>   self_type;
 
 		typedef _adjacency_list_itr<
-		    _Val, typename element_type::iterator, _Unreachable
+		    _Val, typename element_type::iterator, _Unreachable, _Allocator
 		> inner_iterator;
 
 		typedef _const_adjacency_list_itr<
-			_Val, typename element_type::iterator, _Unreachable
+			_Val, typename element_type::iterator, _Unreachable, _Allocator
 		> const_inner_iterator;
 
 	public:
@@ -183,6 +185,12 @@ namespace tools {
 
 		adjacency_list() : m_count_elements(0) { }
 
+		/* rank vertices without any link */
+		explicit adjacency_list(size_type rank) : m_count_elements(0) {
+			m_rep.reserve(rank);
+			for (size_type i = 0; i < rank; ++i) { m_rep.emplace_back(); }
+		}
+
 		reference operator()(size_type u, size_type v) {
 			return const_cast<reference>(((const self_type*) this)->operator()(u, v));
 		}
@@ -203,6 +211,13 @@ namespace tools {
 		size_type rank() const { return m_rep.size(); }
 		size_type size() const { return m_count_elements; }
 
+		/* bytes of the vertex array and of every link list */
+		size_type memory_usage() const {
+			size_type bytes = m_rep.memory_usage();
+			for (const auto& each : m_rep) { bytes += each.memory_usage(); }
+			return bytes;
+		}
+
 		iterator find_link(size_type u, size_type v) {
 			assert(u < m_rep.size() && v < m_rep.size());
 
@@ -234,6 +249,20 @@ namespace tools {
 			return tools::make_pair(hint, false);
 		}
 
+		/* the link u -> v set to val, true when it was not there before */
+		bool insert_or_replace_link(size_type u, size_type v, const value_type& val) {
+			assert(u < m_rep.size() && v < m_rep.size());
+
+			element_type& list = m_rep[u];
+			for (auto& each : list) {
+				if (v == each.link_to) { each.val = val; return false; }
+			}
+
+			list.push_back(link_type(val, v));
+			++m_count_elements;
+			return true;
+		}
+
 		tools::pair<iterator, bool> erase_link(const_iterator pos) {
 			if (end() == pos) { return tools::make_pair(end(), false); }
 			auto& start_with = pos.base().start_with;
@@ -278,8 +307,8 @@ namespace tools {
 		rep_type  m_rep;
 	};
 
-	template <typename _Val, _Val _Unreachable>
-	const _Val adjacency_list<_Val, _Unreachable>::unreachable = _Unreachable;
+	template <typename _Val, _Val _Unreachable, typename _Allocator>
+	const _Val adjacency_list<_Val, _Unreachable, _Allocator>::unreachable = _Unreachable;
 }
 
 #endif //_ADJACENCY_LIST_H_
@@ -212,7 +212,7 @@ namespace tools {
 	_ForwardIterator lower_bound(_ForwardIterator  first,
 	                             _ForwardIterator  last,
 	                             const _ValueType& value) {
-
+		return lower_bound(first, last, value, less<_ValueType>());
 	}
 
 	template <
@@ -224,7 +224,18 @@ namespace tools {
 	                             _ForwardIterator   last ,
 	                             const _ValueType&  value,
 	                             const _Comparator& comp) {
+		size_t count = 0;
+		for (_ForwardIterator cursor = first; cursor != last; ++cursor) { ++count; }
+
+		while (0 < count) {
+			const size_t half = count / 2;
+			_ForwardIterator middle = first;
+			for (size_t i = 0; i < half; ++i) { ++middle; }
 
+			if (comp(*middle, value)) { first = ++middle; count -= half + 1; }
+			else { count = half; }
+		}
+		return first;
 	}
 }
 
@@ -49,6 +49,7 @@ namespace tools {
 		/* size and capacity */
 		size_type size() const { return rep.size(); }
 		size_type max_size() const { return rep.max_size(); }
+		size_type memory_usage() const { return rep.memory_usage(); }
 
 		iterator find(const key_type& key) const { return rep.find(key); }
 		size_type count(const key_type& key) const { return rep.count(key); }
@@ -9,6 +9,7 @@
 #include "unidirectional_list.h"
 #include "sequence.h"
 #include "pair.h"
+#include "../common/trace.h"
 
 namespace tools {
 
@@ -55,6 +56,8 @@ namespace tools {
 	public:
 		explicit _hashtable_iterator_base(node_type* p, const hashtable_type* const table) :
 			current(p), hashtable(table) { }
+
+		const node_type* node() const { return current; }
 	};
 
 	template <
@@ -82,6 +85,10 @@ namespace tools {
 		typedef typename base_type::node_type      node_type;
 		typedef typename base_type::link_type      link_type;
 
+		using base_type::current;
+		using base_type::hashtable;
+		using base_type::next;
+
 	public:
 		typedef std::forward_iterator_tag      iterator_category;
 		typedef typename base_type::value_type value_type;
@@ -145,6 +152,10 @@ namespace tools {
 		typedef typename base_type::node_type      node_type;
 		typedef typename base_type::link_type      link_type;
 
+		using base_type::current;
+		using base_type::hashtable;
+		using base_type::next;
+
 	public:
 		typedef std::forward_iterator_tag      iterator_category;
 		typedef typename base_type::value_type value_type;
@@ -198,7 +209,7 @@ namespace tools {
 		    _Key, _Val, _Hash, _ExtractKey, _EqualKey, _Alloc
 	    >& right
 	) {
-		return left.current == right.current;
+		return left.node() == right.node();
 	}
 
 	template <
@@ -298,6 +309,9 @@ namespace tools {
 		size_type size() const { return count_elements; }
 		size_type max_size() const { return size_type(-1); }
 
+		/* bytes of the bucket array and the nodes */
+		size_type memory_usage() const { return buckets.memory_usage() + count_elements * allocator_type::bytes(1); }
+
 	protected:
 		link_type create_node(const value_type& val) {
 			link_type p = allocator_type::allocate();
@@ -475,6 +489,7 @@ namespace tools {
 		void resize(size_type hint) {
 			const size_type count_bkt = buckets.size();
 			if (count_bkt < hint) {
+				TOOLS_TRACE_SCOPE("hashtable::resize");
 				const size_type new_size = _next_size(hint);
 				if (count_bkt < new_size) {
 					buckets_type tmp(new_size, nullptr);
@@ -484,10 +499,10 @@ namespace tools {
 
 						while (nullptr != p) {
 							size_type new_index = bucket_index(p->val, new_size);
-							buckets[new_index] = p->next;
+							buckets[index] = p->get_next();
 							p->next = tmp[new_index];
 							tmp[new_index] = p;
-							p = buckets[new_index];
+							p = buckets[index];
 						}
 					}
 					buckets.swap(tmp);
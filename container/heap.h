@@ -80,6 +80,7 @@ namespace tools {
 	                         _Difference           length,
 	                         _ValueType            value ,
 							 _Comparator           comp  ) {
+		const _Difference top = hole;
 		_Difference child = hole * 2 + 2;
 
 		while (child < length) {
@@ -96,7 +97,8 @@ namespace tools {
 			hole = child - 1;
 		}
 
-		*(base + hole) = value;
+		/* the hole went down to a leaf, the value goes back up from there */
+		_push_heap(base, hole, top, value, comp);
 	};
 
 	template <typename _RandomAccessIterator, typename _Comparator>
@@ -175,6 +177,7 @@ namespace tools {
 		bool empty() const { return m_container.empty(); }
 		size_type size() const { return m_container.size(); }
 		size_type max_size() const { return m_container.max_size(); }
+		size_type memory_usage() const { return m_container.memory_usage(); }
 
 		void clear() { m_container.clear(); }
 		void swap(self_type& other) { m_container.swap(other.m_container); }
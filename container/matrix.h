@@ -301,7 +301,14 @@ namespace tools {
 					m_buff.resize(m_rows * m_cols, value_type(0));
 					break;
 				}
-				case matrix_init::identity : { break; } //todo
+				case matrix_init::identity : {
+					m_buff.resize(m_rows * m_cols, value_type(0));
+					const size_type rank = tools::min(m_rows, m_cols);
+					for (size_type i = 0; i < rank; ++i) {
+						m_buff[i * m_cols + i] = value_type(1);
+					}
+					break;
+				}
 				case matrix_init::random : { break; } //todo
 				default : { break; }
 			}
@@ -331,6 +338,7 @@ namespace tools {
 		size_type rows() const { return m_rows; }
 		size_type cols() const { return m_cols; }
 		size_type size() const { return m_rows * m_cols; }
+		size_type memory_usage() const { return m_buff.memory_usage(); }
 
 		bool squared()  const { return m_rows == m_cols; }
 		bool degraded() const { return 0 == m_rows || 0 == m_cols; }
@@ -398,7 +406,10 @@ namespace tools {
 		template <typename _InputIterator>
 		void push_bottom(_InputIterator first, _InputIterator last) {
 
-			m_buff.reserve((m_rows + 1) * m_cols);
+			/* grow geometrically, an exact reserve per row made select() quadratic */
+			if (m_buff.capacity() < (m_rows + 1) * m_cols) {
+				m_buff.reserve(2 * (m_rows + 1) * m_cols);
+			}
 
 			size_type i = 0;
 			while (first != last && i < m_cols) {
@@ -512,50 +523,101 @@ namespace tools {
 		container_type m_buff;
 	};
 
-	template <
-	    typename _Val,
-	    typename _Index             = size_t,
-	    typename _ContainerForVal   = tools::sequence<_Val>,
-	    typename _ContainerForIndex = tools::sequence<_Index>
-	>
-	class spare_matrix {
+	/**
+	 * @note Non-owning strided vector, a row or a column of a
+	 *       matrix_view.
+	 */
+	template <typename _Val>
+	class strided_view {
 	public:
-		typedef _Index     index_type;
-		typedef index_type size_type;
-
 		typedef _Val        value_type;
-		typedef _Val*       pointer;
+		typedef const _Val& const_reference;
 		typedef const _Val* const_pointer;
-		typedef _Val&       reference;
+		typedef size_t      size_type;
+
+		strided_view() : m_data(nullptr), m_size(0), m_stride(0) { }
+
+		strided_view(const_pointer data, size_type size, size_type stride) :
+			m_data(data), m_size(size), m_stride(stride) { }
+
+		size_type size()   const { return m_size; }
+		size_type stride() const { return m_stride; }
+
+		const_pointer data() const { return m_data; }
+
+		const_reference operator[](size_type i) const {
+			assert(i < m_size);
+			return m_data[i * m_stride];
+		}
+
+	private:
+		const_pointer m_data;
+		size_type     m_size, m_stride;
+	};
+
+	/**
+	 * @note Read-only matrix over memory owned by someone else (a
+	 *       tools::matrix, a memory mapped file, ...). The strides let
+	 *       it describe row-major and column-major storage alike, so
+	 *       nothing has to be copied to look at columnar data row-wise.
+	 */
+	template <typename _Val>
+	class matrix_view {
+	public:
+		typedef _Val        value_type;
 		typedef const _Val& const_reference;
+		typedef const _Val* const_pointer;
+		typedef size_t      size_type;
 
-	protected:
-		typedef spare_matrix<
-		    _Val, _Index, _ContainerForVal, _ContainerForIndex
-		> self_type;
-
-		typedef _ContainerForIndex index_vec;
-		typedef _ContainerForVal   value_vec;
-
-//		spare_matrix(dim_type dim, mat_type type) : m_dim(dim) {
-//			if (mat_type::ZERO == type) {
-//				m_row_index.resize(m_dim + 1, index_type(0));
-//				return;
-//			}
-//
-//			m_row_index.reserve(dim + 1);
-//			m_col_index.reserve(dim);
-//			m_values.reserve(dim);
-//
-//			for (index_type i = 0; i < m_dim; ++i) {
-//				m_row_index.push_back(i);
-//				m_col_index.push_back(i);
-//				m_values.push_back(one);
-//			}
-//
-//			m_row_index.push_back(dim);
-//		}
-		// todo
+		typedef strided_view<_Val> vector_view;
+
+		matrix_view() :
+			m_data(nullptr), m_rows(0), m_cols(0), m_row_stride(0), m_col_stride(0) { }
+
+		matrix_view(
+			const_pointer data,
+			size_type     rows,
+			size_type     cols,
+			size_type     row_stride,
+			size_type     col_stride
+		) : m_data(data), m_rows(rows), m_cols(cols),
+		    m_row_stride(row_stride), m_col_stride(col_stride) { }
+
+		template <typename _Container>
+		matrix_view(const matrix<_Val, _Container>& mat) :
+			m_data(mat.data()), m_rows(mat.rows()), m_cols(mat.cols()),
+			m_row_stride(mat.cols()), m_col_stride(1) { }
+
+		size_type rows() const { return m_rows; }
+		size_type cols() const { return m_cols; }
+		size_type size() const { return m_rows * m_cols; }
+
+		size_type row_stride() const { return m_row_stride; }
+		size_type col_stride() const { return m_col_stride; }
+
+		bool degraded() const { return 0 == m_rows || 0 == m_cols; }
+
+		const_pointer data() const { return m_data; }
+
+		const_reference operator()(size_type row, size_type col) const {
+			assert(row < m_rows && col < m_cols);
+			return m_data[row * m_row_stride + col * m_col_stride];
+		}
+
+		vector_view row(size_type r) const {
+			assert(r < m_rows);
+			return vector_view(m_data + r * m_row_stride, m_cols, m_col_stride);
+		}
+
+		vector_view column(size_type c) const {
+			assert(c < m_cols);
+			return vector_view(m_data + c * m_col_stride, m_rows, m_row_stride);
+		}
+
+	private:
+		const_pointer m_data;
+		size_type     m_rows, m_cols;
+		size_type     m_row_stride, m_col_stride;
 	};
 };
 
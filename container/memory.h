@@ -5,6 +5,7 @@
 #ifndef _MEMORY_H_
 #define _MEMORY_H_
 
+#include <atomic>
 #include <utility>
 
 #include "../common/defines.h"
@@ -45,26 +46,42 @@ namespace tools {
 		}
 	}
 
+	/**
+	 * @note Storage for n objects of _T from an allocator of any value
+	 *       type, which is asked for as many of its own units as the
+	 *       objects take, a byte allocator for the bytes.
+	 */
 	template <typename _T, typename _Alloc>
 	class standard_alloc {
+		typedef typename _Alloc::value_type unit_type;
+
+		static size_t _units(size_t n) {
+			return (n * sizeof (_T) + sizeof (unit_type) - 1) / sizeof (unit_type);
+		}
+
 	public:
 		static _T* allocate(size_t n) {
-			return 0 == n ? nullptr : (_T*) alloc.allocate(n * sizeof (_T));
+			return 0 == n ? nullptr : (_T*) alloc.allocate(_units(n));
 		}
 
 		static _T* allocate() {
-			return (_T*) alloc.allocate(sizeof (_T));
+			return (_T*) alloc.allocate(_units(1));
 		}
 
 		static void deallocate(_T* p, size_t n) {
 			if (0 == n) {
 				return;
 			}
-			alloc.deallocate(p, n * sizeof (_T));
+			alloc.deallocate((unit_type*) p, _units(n));
 		}
 
 		static void deallocate(_T* p) {
-			alloc.deallocate( p, sizeof (_T));
+			alloc.deallocate((unit_type*) p, _units(1));
+		}
+
+		/* bytes n objects actually take from the allocator */
+		static size_t bytes(size_t n) {
+			return _units(n) * sizeof (unit_type);
 		}
 
 	private:
@@ -73,6 +90,95 @@ namespace tools {
 
 	template <typename _T, typename _Alloc>
 	_Alloc standard_alloc<_T, _Alloc>::alloc = _Alloc();
+
+	struct alloc_usage {
+		size_t live_bytes;
+		size_t peak_bytes;
+		size_t allocations;
+		size_t deallocations;
+	};
+
+	/* what the allocators counting under _Tag have handed out, shared by all threads */
+	template <typename _Tag>
+	class alloc_counter {
+	public:
+		static void on_allocate(size_t bytes) {
+			const size_t now = live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			size_t highest = peak.load(std::memory_order_relaxed);
+			while (highest < now && !peak.compare_exchange_weak(highest, now, std::memory_order_relaxed)) { }
+			allocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		static void on_deallocate(size_t bytes) {
+			live.fetch_sub(bytes, std::memory_order_relaxed);
+			deallocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		static alloc_usage usage() {
+			return alloc_usage {
+				live.load(std::memory_order_relaxed),
+				peak.load(std::memory_order_relaxed),
+				allocations.load(std::memory_order_relaxed),
+				deallocations.load(std::memory_order_relaxed)
+			};
+		}
+
+		/* the counts start over, the peak from what is live now */
+		static void reset() {
+			peak.store(live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			allocations.store(0, std::memory_order_relaxed);
+			deallocations.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static std::atomic<size_t> live;
+		static std::atomic<size_t> peak;
+		static std::atomic<size_t> allocations;
+		static std::atomic<size_t> deallocations;
+	};
+
+	template <typename _Tag>
+	std::atomic<size_t> alloc_counter<_Tag>::live(0);
+
+	template <typename _Tag>
+	std::atomic<size_t> alloc_counter<_Tag>::peak(0);
+
+	template <typename _Tag>
+	std::atomic<size_t> alloc_counter<_Tag>::allocations(0);
+
+	template <typename _Tag>
+	std::atomic<size_t> alloc_counter<_Tag>::deallocations(0);
+
+	/**
+	 * @note An allocator passing everything on to _Alloc and counting
+	 *       the bytes and calls in alloc_counter<_Tag>. Given as the
+	 *       allocator of a container, standard_alloc draws from it, so
+	 *       the counter sees every node and buffer of that container
+	 *       type; containers sharing a tag are counted together.
+	 */
+	template <typename _Alloc, typename _Tag = _Alloc>
+	class counting_alloc {
+	public:
+		typedef typename _Alloc::value_type value_type;
+		typedef alloc_counter<_Tag>         counter_type;
+
+		value_type* allocate(size_t n) {
+			value_type* p = m_alloc.allocate(n);
+			counter_type::on_allocate(n * sizeof (value_type));
+			return p;
+		}
+
+		void deallocate(value_type* p, size_t n) {
+			m_alloc.deallocate(p, n);
+			counter_type::on_deallocate(n * sizeof (value_type));
+		}
+
+		static alloc_usage usage() { return counter_type::usage(); }
+		static void reset() { counter_type::reset(); }
+
+	private:
+		_Alloc m_alloc;
+	};
 }
 
 #endif //_MEMORY_H_
@@ -392,9 +392,26 @@ namespace tools {
 			rightmost() = m_header;
 		}
 
+		/* the subtree under node, recursing only to the right */
+		void _erase(link_type node) {
+			while (nullptr != node) {
+				_erase((link_type) node->right());
+				link_type left = (link_type) node->left();
+				destroy_node(node);
+				node = left;
+			}
+		}
+
 		void _clear() {
-			// todo
+			if (0 == m_count) {
+				return;
+			}
+			_erase(root());
 
+			root()      = nullptr;
+			leftmost()  = m_header;
+			rightmost() = m_header;
+			m_count = 0;
 		}
 
 		iterator _insert(link_type current, link_type parent, const value_type& val) {
@@ -465,6 +482,9 @@ namespace tools {
 		size_type size() const { return m_count; }
 		size_type max_size() const { return size_type(-1); }
 
+		/* bytes of the nodes, the header included */
+		size_type memory_usage() const { return (m_count + 1) * allocator_type::bytes(1); }
+
 		const_iterator minimum() const {
 			if (empty()) {
 				return end();
@@ -556,7 +576,7 @@ namespace tools {
 			}
 
 			inner_iterator iter(parent);
-			return (end() == iter || m_comp(key, key_of(*iter))) ? end() : iter;
+			return (end().base() == iter || m_comp(key, key_of(*iter))) ? end() : iter;
 		}
 	};
 }
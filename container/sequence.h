@@ -7,9 +7,12 @@
 
 #include <memory>
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
 
 #include "iterator.h"
 #include "memory.h"
+#include "../common/trace.h"
 #include "../common/type_base.h"
 #include "algorithm.h"
 
@@ -48,6 +51,12 @@ namespace tools {
 
 	private:
 		void _initialize_with_n(size_type n) throw (std::bad_alloc) {
+			/* nothing to allocate, the allocator's nullptr is not a failure then */
+			if (0 == n) {
+				m_base = m_finish = m_end_of_storage = nullptr;
+				return;
+			}
+
 			m_base = get_space(n);
 			if (nullptr == m_base) {
 				throw std::bad_alloc();
@@ -76,6 +85,7 @@ namespace tools {
 		}
 
 		void _extend(size_type new_size) {
+			TOOLS_TRACE_SCOPE("sequence::_extend");
 			inner_iterator old_base   = m_base;
 			inner_iterator old_finish = m_finish;
 			inner_iterator old_eos    = m_end_of_storage;
@@ -100,14 +110,15 @@ namespace tools {
 		}
 
 		void _resize(size_type new_size, const value_type& val) {
-			if (capacity() == new_size) {
+			if (size() == new_size) {
 				return;
 			}
 
 			if (capacity() < new_size) {
 				_extend(new_size);
 			}
-			else if (size() < new_size) {
+
+			if (size() < new_size) {
 				construct(m_finish, m_base + new_size, val);
 				m_finish = m_base + new_size;
 			}
@@ -168,9 +179,9 @@ namespace tools {
 		}
 
 		template <typename... _Args>
-		inner_iterator _emplace(difference_type offset,
-		                        size_type       n,
-		                        _Args&&...      args) {
+		inner_iterator _emplace_n(difference_type offset,
+		                          size_type       n,
+		                          _Args&&...      args) {
 			if (capacity() < size() + n) {
 				_extend_when_full(size() + n);
 			}
@@ -247,6 +258,9 @@ namespace tools {
 		size_type max_size() const { return size_type(-1); }
 		size_type capacity() const { return m_end_of_storage - m_base; }
 
+		/* bytes of storage held, the elements' own storage not included */
+		size_type memory_usage() const { return allocator_type::bytes(capacity()); }
+
 		void resize(size_type new_size) { _resize(new_size, value_type()); }
 		void resize(size_type new_size, const value_type& val) { _resize(new_size, val); }
 
@@ -314,7 +328,7 @@ namespace tools {
 		}
 
 		iterator insert(const_iterator pos, size_type n, const value_type& val) {
-			return iterator(_emplace(pos - begin(), n, val));
+			return iterator(_emplace_n(pos - begin(), n, val));
 		}
 
 		template <typename _InputIterator>
@@ -0,0 +1,453 @@
+/*
+ * Created by Maou Lim on 2019/7/4.
+ */
+
+#ifndef _SPARSE_MATRIX_H_
+#define _SPARSE_MATRIX_H_
+
+#include <cassert>
+#include <algorithm>
+
+#include "../common/defines.h"
+#include "../common/parallel.h"
+#include "sequence.h"
+#include "matrix.h"
+
+namespace tools {
+
+	/**
+	 * @note A non-owning view of one compressed row (or column): nnz
+	 *       (index, value) pairs of a dim-long vector, indices ascending.
+	 *       It is what iterating a csr_matrix yields, so sparse samples
+	 *       can be fed to the optimizers without being densified.
+	 */
+	template <typename _Val, typename _Index = size_t>
+	struct sparse_view {
+		typedef _Val   value_type;
+		typedef _Index index_type;
+		typedef size_t size_type;
+
+		sparse_view() : indices(nullptr), values(nullptr), nnz(0), dim(0) { }
+
+		sparse_view(
+			const index_type* idx, const value_type* val, size_type n, size_type d
+		) : indices(idx), values(val), nnz(n), dim(d) { }
+
+		size_type size() const { return dim; }
+
+		value_type operator[](size_type idx) const {
+			assert(idx < dim);
+			const index_type* pos = std::lower_bound(indices, indices + nnz, (index_type) idx);
+			return (indices + nnz != pos && idx == *pos) ? values[pos - indices] : value_type(0);
+		}
+
+		const index_type* indices;
+		const value_type* values;
+		size_type         nnz;
+		size_type         dim;
+	};
+
+	/**
+	 * @note Sparse-dense inner product. _Dense is anything indexable by
+	 *       operator[], e.g. math::vector, tools::sequence or an array.
+	 */
+	template <typename _Val, typename _Index, typename _Dense>
+	_Val dot(const sparse_view<_Val, _Index>& sparse, const _Dense& dense) {
+		_Val result = _Val(0);
+		for (size_t i = 0; i < sparse.nnz; ++i) {
+			result += sparse.values[i] * dense[sparse.indices[i]];
+		}
+		return result;
+	}
+
+	/* dense += alpha * sparse, touching the non-zeros only */
+	template <typename _Dense, typename _Scalar, typename _Val, typename _Index>
+	_Dense& axpy(_Dense& dense, _Scalar alpha, const sparse_view<_Val, _Index>& sparse) {
+		for (size_t i = 0; i < sparse.nnz; ++i) {
+			dense[sparse.indices[i]] += alpha * sparse.values[i];
+		}
+		return dense;
+	}
+
+	template <typename _Val, typename _Index = size_t>
+	class coo_matrix {
+	public:
+		typedef _Val        value_type;
+		typedef _Index      index_type;
+		typedef size_t      size_type;
+
+		coo_matrix(size_type rows, size_type cols) : m_rows(rows), m_cols(cols) { }
+
+		size_type rows() const { return m_rows; }
+		size_type cols() const { return m_cols; }
+		size_type nnz()  const { return m_values.size(); }
+
+		void reserve(size_type n) {
+			m_row_index.reserve(n);
+			m_col_index.reserve(n);
+			m_values.reserve(n);
+		}
+
+		/* duplicated (row, col) entries are summed when compressed */
+		void insert(index_type row, index_type col, const value_type& val) {
+			assert((size_type) row < m_rows && (size_type) col < m_cols);
+			m_row_index.push_back(row);
+			m_col_index.push_back(col);
+			m_values.push_back(val);
+		}
+
+		void clear() {
+			m_row_index.clear();
+			m_col_index.clear();
+			m_values.clear();
+		}
+
+		const index_type* row_indices() const { return m_row_index.data(); }
+		const index_type* col_indices() const { return m_col_index.data(); }
+		const value_type* values()      const { return m_values.data(); }
+
+	private:
+		size_type                   m_rows, m_cols;
+		tools::sequence<index_type> m_row_index;
+		tools::sequence<index_type> m_col_index;
+		tools::sequence<value_type> m_values;
+	};
+
+	/**
+	 * @note Shared storage of the compressed formats: `offsets` has
+	 *       (majors + 1) entries, the minor indices and values of major
+	 *       m live in [offsets[m], offsets[m + 1]). CSR is row-major,
+	 *       CSC column-major; the CSR arrays of A are the CSC arrays of
+	 *       A^T, which makes transposition free.
+	 */
+	template <typename _Val, typename _Index>
+	class _compressed_storage {
+	public:
+		typedef _Val        value_type;
+		typedef _Index      index_type;
+		typedef size_t      size_type;
+
+	protected:
+		_compressed_storage(size_type majors, size_type minors) :
+			m_majors(majors), m_minors(minors), m_offsets(majors + 1, index_type(0)) { }
+
+		/**
+		 * @note Builds from triplets with two stable counting sorts,
+		 *       by minor then by major, O(nnz + majors + minors), then
+		 *       folds duplicated coordinates into one entry.
+		 */
+		void _compress(
+			const index_type* major,
+			const index_type* minor,
+			const value_type* values,
+			size_type         nnz
+		) {
+			sequence<index_type> order(nnz, index_type(0)), tmp(nnz, index_type(0));
+			sequence<index_type> count(tools::max(m_majors, m_minors) + 1, index_type(0));
+
+			for (size_type i = 0; i < nnz; ++i) { tmp[i] = (index_type) i; }
+
+			_counting_sort(minor, m_minors, tmp.data(), order.data(), nnz, count);
+			_counting_sort(major, m_majors, order.data(), tmp.data(), nnz, count);
+
+			m_indices.clear(); m_indices.reserve(nnz);
+			m_values.clear();  m_values.reserve(nnz);
+			for (size_type m = 0; m <= m_majors; ++m) { m_offsets[m] = index_type(0); }
+
+			for (size_type i = 0; i < nnz; ++i) {
+				const index_type e = tmp[i];
+				if (0 < i) {
+					const index_type p = tmp[i - 1];
+					if (major[p] == major[e] && minor[p] == minor[e]) {
+						m_values.back() += values[e];
+						continue;
+					}
+				}
+				m_indices.push_back(minor[e]);
+				m_values.push_back(values[e]);
+				++m_offsets[major[e] + 1];
+			}
+
+			for (size_type m = 0; m < m_majors; ++m) { m_offsets[m + 1] += m_offsets[m]; }
+		}
+
+		sparse_view<value_type, index_type> _major(size_type m) const {
+			assert(m < m_majors);
+			const size_type first = m_offsets[m], last = m_offsets[m + 1];
+			return sparse_view<value_type, index_type>(
+				m_indices.data() + first, m_values.data() + first, last - first, m_minors
+			);
+		}
+
+		value_type _at(size_type major, size_type minor) const {
+			return _major(major)[minor];
+		}
+
+		void _transpose_into(_compressed_storage& dest) const {
+			assert(dest.m_majors == m_minors && dest.m_minors == m_majors);
+
+			const size_type n = nnz();
+			dest.m_indices.clear(); dest.m_indices.resize(n, index_type(0));
+			dest.m_values.clear();  dest.m_values.resize(n, value_type(0));
+
+			for (size_type m = 0; m <= dest.m_majors; ++m) { dest.m_offsets[m] = index_type(0); }
+			for (size_type i = 0; i < n; ++i) { ++dest.m_offsets[m_indices[i] + 1]; }
+			for (size_type m = 0; m < dest.m_majors; ++m) { dest.m_offsets[m + 1] += dest.m_offsets[m]; }
+
+			sequence<index_type> cursor(dest.m_offsets.begin(), dest.m_offsets.end());
+			for (size_type m = 0; m < m_majors; ++m) {
+				for (size_type i = m_offsets[m]; i < (size_type) m_offsets[m + 1]; ++i) {
+					const index_type pos = cursor[m_indices[i]]++;
+					dest.m_indices[pos] = (index_type) m;
+					dest.m_values[pos] = m_values[i];
+				}
+			}
+		}
+
+	public:
+		size_type nnz() const { return m_values.size(); }
+
+		const index_type* offsets() const { return m_offsets.data(); }
+		const index_type* indices() const { return m_indices.data(); }
+		const value_type* values()  const { return m_values.data(); }
+
+	private:
+		static void _counting_sort(
+			const index_type*     keys,
+			size_type             range,
+			const index_type*     src,
+			index_type*           dest,
+			size_type             n,
+			sequence<index_type>& count
+		) {
+			for (size_type k = 0; k <= range; ++k) { count[k] = index_type(0); }
+			for (size_type i = 0; i < n; ++i) { ++count[keys[src[i]] + 1]; }
+			for (size_type k = 0; k < range; ++k) { count[k + 1] += count[k]; }
+			for (size_type i = 0; i < n; ++i) { dest[count[keys[src[i]]]++] = src[i]; }
+		}
+
+	protected:
+		size_type                   m_majors, m_minors;
+		tools::sequence<index_type> m_offsets;
+		tools::sequence<index_type> m_indices;
+		tools::sequence<value_type> m_values;
+	};
+
+	template <typename _Val, typename _Index>
+	class csc_matrix;
+
+	template <typename _Val, typename _Index = size_t>
+	class csr_matrix : public _compressed_storage<_Val, _Index> {
+		typedef _compressed_storage<_Val, _Index> base_type;
+		typedef csr_matrix<_Val, _Index>          self_type;
+
+	public:
+		typedef _Val                      value_type;
+		typedef _Index                    index_type;
+		typedef size_t                    size_type;
+		typedef sparse_view<_Val, _Index> row_type;
+
+		struct row_iterator {
+			typedef std::forward_iterator_tag iterator_category;
+			typedef row_type                  value_type;
+			typedef ptrdiff_t                 difference_type;
+			typedef const row_type*           pointer;
+			typedef row_type                  reference;
+
+			row_iterator(const self_type* m, size_type r) : mat(m), row(r) { }
+
+			row_type operator*() const { return mat->row(row); }
+			row_iterator& operator++() { ++row; return *this; }
+			row_iterator operator++(int) { row_iterator tmp = *this; ++row; return tmp; }
+
+			bool operator==(const row_iterator& other) const { return row == other.row; }
+			bool operator!=(const row_iterator& other) const { return row != other.row; }
+
+			const self_type* mat;
+			size_type        row;
+		};
+
+		csr_matrix(size_type rows, size_type cols) : base_type(rows, cols) { }
+
+		explicit csr_matrix(const coo_matrix<_Val, _Index>& coo) :
+			base_type(coo.rows(), coo.cols()) {
+			base_type::_compress(coo.row_indices(), coo.col_indices(), coo.values(), coo.nnz());
+		}
+
+		size_type rows() const { return base_type::m_majors; }
+		size_type cols() const { return base_type::m_minors; }
+
+		value_type operator()(size_type row, size_type col) const { return base_type::_at(row, col); }
+
+		row_type row(size_type r) const { return base_type::_major(r); }
+
+		row_iterator begin() const { return row_iterator(this, 0); }
+		row_iterator end() const { return row_iterator(this, rows()); }
+
+		csc_matrix<_Val, _Index> to_csc() const;
+	};
+
+	template <typename _Val, typename _Index = size_t>
+	class csc_matrix : public _compressed_storage<_Val, _Index> {
+		typedef _compressed_storage<_Val, _Index> base_type;
+
+	public:
+		typedef _Val                      value_type;
+		typedef _Index                    index_type;
+		typedef size_t                    size_type;
+		typedef sparse_view<_Val, _Index> column_type;
+
+		csc_matrix(size_type rows, size_type cols) : base_type(cols, rows) { }
+
+		explicit csc_matrix(const coo_matrix<_Val, _Index>& coo) :
+			base_type(coo.cols(), coo.rows()) {
+			base_type::_compress(coo.col_indices(), coo.row_indices(), coo.values(), coo.nnz());
+		}
+
+		size_type rows() const { return base_type::m_minors; }
+		size_type cols() const { return base_type::m_majors; }
+
+		value_type operator()(size_type row, size_type col) const { return base_type::_at(col, row); }
+
+		column_type column(size_type c) const { return base_type::_major(c); }
+
+		csr_matrix<_Val, _Index> to_csr() const {
+			csr_matrix<_Val, _Index> result(rows(), cols());
+			base_type::_transpose_into(result);
+			return result;
+		}
+	};
+
+	template <typename _Val, typename _Index>
+	csc_matrix<_Val, _Index> csr_matrix<_Val, _Index>::to_csc() const {
+		csc_matrix<_Val, _Index> result(rows(), cols());
+		base_type::_transpose_into(result);
+		return result;
+	}
+
+	const size_t _sparse_grain = 1024;
+
+	/* SpMV, y = A * x, rows split among threads */
+	template <typename _Val, typename _Index>
+	sequence<_Val> spmv(const csr_matrix<_Val, _Index>& a, const sequence<_Val>& x) {
+		assert(a.cols() == x.size());
+
+		sequence<_Val> y(a.rows(), _Val(0));
+		_Val* out = y.data();
+
+		parallel_for(0, a.rows(), _sparse_grain, [&a, &x, out](size_t r0, size_t r1) {
+			for (size_t r = r0; r < r1; ++r) { out[r] = dot(a.row(r), x); }
+		});
+
+		return y;
+	}
+
+	/**
+	 * @note SpMV on CSC scatters into y. Each thread owns a fixed range
+	 *       of rows and takes, from every column, the entries in that
+	 *       range (found by binary search), so nothing is shared and
+	 *       no partial results are buffered. Every y[r] is summed in
+	 *       column order however the rows are split, so the result is
+	 *       the same bit for bit on any number of threads.
+	 */
+	template <typename _Val, typename _Index>
+	sequence<_Val> spmv(const csc_matrix<_Val, _Index>& a, const sequence<_Val>& x) {
+		assert(a.cols() == x.size());
+
+		const size_t rows = a.rows(), cols = a.cols();
+		sequence<_Val> y(rows, _Val(0));
+		_Val* out = y.data();
+
+		const size_t blocks = tools::max<size_t>(1, tools::min(concurrency(), rows / _sparse_grain));
+		parallel_for(0, blocks, 1, [&a, &x, out, rows, cols, blocks](size_t b0, size_t b1) {
+			for (size_t block = b0; block < b1; ++block) {
+				const _Index r0 = (_Index) (rows * block / blocks), r1 = (_Index) (rows * (block + 1) / blocks);
+				for (size_t c = 0; c < cols; ++c) {
+					auto col = a.column(c);
+					const _Index* first = 1 == blocks ? col.indices : std::lower_bound(col.indices, col.indices + col.nnz, r0);
+					const _Index* last  = 1 == blocks ? col.indices + col.nnz : std::lower_bound(first, col.indices + col.nnz, r1);
+
+					const _Val xc = x[c];
+					for (const _Index* itr = first; itr != last; ++itr) { out[*itr] += col.values[itr - col.indices] * xc; }
+				}
+			}
+		});
+
+		return y;
+	}
+
+	/* y = A^T * x, a gather over the columns, e.g. X^T * residual */
+	template <typename _Val, typename _Index>
+	sequence<_Val> spmv_transposed(const csc_matrix<_Val, _Index>& a, const sequence<_Val>& x) {
+		assert(a.rows() == x.size());
+
+		sequence<_Val> y(a.cols(), _Val(0));
+		_Val* out = y.data();
+
+		parallel_for(0, a.cols(), _sparse_grain, [&a, &x, out](size_t c0, size_t c1) {
+			for (size_t c = c0; c < c1; ++c) { out[c] = dot(a.column(c), x); }
+		});
+
+		return y;
+	}
+
+	/* SpMM, C = A * B with a dense B, rows of C split among threads */
+	template <typename _Val, typename _Index, typename _Container>
+	matrix<_Val, _Container> spmm(
+		const csr_matrix<_Val, _Index>&  a,
+		const matrix<_Val, _Container>& b
+	) {
+		assert(a.cols() == b.rows());
+
+		const size_t k = b.cols();
+		matrix<_Val, _Container> c(a.rows(), k);
+
+		const _Val* src = b.data();
+		_Val*       out = c.data();
+
+		parallel_for(0, a.rows(), _sparse_grain / 16, [&a, src, out, k](size_t r0, size_t r1) {
+			for (size_t r = r0; r < r1; ++r) {
+				auto row = a.row(r);
+				_Val* dest = out + r * k;
+				for (size_t i = 0; i < row.nnz; ++i) {
+					const _Val  v    = row.values[i];
+					const _Val* brow = src + row.indices[i] * k;
+					for (size_t j = 0; j < k; ++j) { dest[j] += v * brow[j]; }
+				}
+			}
+		});
+
+		return c;
+	}
+
+	/* C = A^T * B with a dense B, rows of C (columns of A) split among threads */
+	template <typename _Val, typename _Index, typename _Container>
+	matrix<_Val, _Container> spmm_transposed(
+		const csc_matrix<_Val, _Index>&  a,
+		const matrix<_Val, _Container>& b
+	) {
+		assert(a.rows() == b.rows());
+
+		const size_t k = b.cols();
+		matrix<_Val, _Container> c(a.cols(), k);
+
+		const _Val* src = b.data();
+		_Val*       out = c.data();
+
+		parallel_for(0, a.cols(), _sparse_grain / 16, [&a, src, out, k](size_t c0, size_t c1) {
+			for (size_t col = c0; col < c1; ++col) {
+				auto column = a.column(col);
+				_Val* dest = out + col * k;
+				for (size_t i = 0; i < column.nnz; ++i) {
+					const _Val  v    = column.values[i];
+					const _Val* brow = src + column.indices[i] * k;
+					for (size_t j = 0; j < k; ++j) { dest[j] += v * brow[j]; }
+				}
+			}
+		});
+
+		return c;
+	}
+}
+
+#endif //_SPARSE_MATRIX_H_
@@ -568,6 +568,9 @@ namespace tools {
 		size_type size() const { return count; }
 		size_type max_size() const { return size_type(-1); }
 
+		/* bytes of the nodes, the header included */
+		size_type memory_usage() const { return (count + 1) * allocator_type::bytes(1); }
+
 		iterator begin() { return inner_iterator(first()); }
 		const_iterator begin() const { return const_inner_iterator(first()); }
 
@@ -265,6 +265,9 @@ namespace tools {
 
 		size_type max_size() const { return size_type(-1); }
 
+		/* bytes of the nodes, the one before head included */
+		size_type memory_usage() const { return (size() + 1) * allocator_type::bytes(1); }
+
 		reference front() { return const_cast<reference>(((const self_type*) this)->front()); }
 		const_reference front() const { return head()->val; }
 
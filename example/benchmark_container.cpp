@@ -0,0 +1,271 @@
+/*
+ * Created by Maou Lim on 2019/7/27.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <queue>
+#include <random>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../common/benchmark.h"
+#include "../container/adjacency_list.h"
+#include "../container/hashtable.h"
+#include "../container/heap.h"
+#include "../container/matrix.h"
+#include "../container/rb_tree.h"
+#include "../container/sequence.h"
+
+namespace {
+
+	typedef tools::_hashtable<
+		int, int, std::hash<int>, tools::identity<int>, tools::equal_to<int>, std::allocator<int>
+	> hashtable_type;
+
+	typedef tools::_rb_tree<int, int, tools::identity<int>> rb_tree_type;
+
+	/* the baseline of adjacency_list: a list of (vertex, value) per vertex */
+	typedef std::vector<std::list<std::pair<size_t, int>>> std_adjacency_type;
+
+	void sequence_benchmarks(tools::benchmark_suite& suite, const std::vector<int>& keys) {
+		const size_t n = keys.size();
+
+		suite.run("sequence/push_back", n, [&keys]() {
+			std::unique_ptr<tools::sequence<int>> result(new tools::sequence<int>());
+			for (auto each : keys) { result->push_back(each); }
+			return result;
+		});
+		suite.run("std::vector/push_back", n, [&keys]() {
+			std::unique_ptr<std::vector<int>> result(new std::vector<int>());
+			for (auto each : keys) { result->push_back(each); }
+			return result;
+		});
+
+		tools::sequence<int> sequence(keys.begin(), keys.end());
+		const std::vector<int> vector(keys.begin(), keys.end());
+
+		suite.run("sequence/iterate", n, [&sequence]() {
+			long long sum = 0;
+			for (auto each : sequence) { sum += each; }
+			return sum;
+		});
+		suite.run("std::vector/iterate", n, [&vector]() {
+			long long sum = 0;
+			for (auto each : vector) { sum += each; }
+			return sum;
+		});
+
+		suite.run("sequence/random_access", n, [&sequence, &keys]() {
+			long long sum = 0;
+			for (auto each : keys) { sum += sequence[(size_t) each]; }
+			return sum;
+		});
+		suite.run("std::vector/random_access", n, [&vector, &keys]() {
+			long long sum = 0;
+			for (auto each : keys) { sum += vector[(size_t) each]; }
+			return sum;
+		});
+	}
+
+	void hashtable_benchmarks(tools::benchmark_suite& suite, const std::vector<int>& keys) {
+		const size_t n = keys.size();
+
+		suite.run("hashtable/insert_unique", n, [&keys]() {
+			std::unique_ptr<hashtable_type> result(new hashtable_type(100, std::hash<int>(), tools::equal_to<int>()));
+			for (auto each : keys) { result->insert_unique(each); }
+			return result;
+		});
+		suite.run("std::unordered_set/insert", n, [&keys]() {
+			std::unique_ptr<std::unordered_set<int>> result(new std::unordered_set<int>());
+			for (auto each : keys) { result->insert(each); }
+			return result;
+		});
+
+		hashtable_type table(100, std::hash<int>(), tools::equal_to<int>());
+		std::unordered_set<int> set;
+		for (auto each : keys) { table.insert_unique(each); set.insert(each); }
+
+		/* every other lookup misses */
+		suite.run("hashtable/count", n, [&table, &keys]() {
+			size_t found = 0;
+			for (auto each : keys) { found += table.count(each % 2 == 0 ? each : -each - 1); }
+			return found;
+		});
+		suite.run("std::unordered_set/count", n, [&set, &keys]() {
+			size_t found = 0;
+			for (auto each : keys) { found += set.count(each % 2 == 0 ? each : -each - 1); }
+			return found;
+		});
+	}
+
+	void rb_tree_benchmarks(tools::benchmark_suite& suite, const std::vector<int>& keys) {
+		const size_t n = keys.size();
+
+		suite.run("rb_tree/insert_unique", n, [&keys]() {
+			std::unique_ptr<rb_tree_type> result(new rb_tree_type());
+			for (auto each : keys) { result->insert_unique(each); }
+			return result;
+		});
+		suite.run("std::set/insert", n, [&keys]() {
+			std::unique_ptr<std::set<int>> result(new std::set<int>());
+			for (auto each : keys) { result->insert(each); }
+			return result;
+		});
+
+		rb_tree_type tree;
+		std::set<int> set;
+		for (auto each : keys) { tree.insert_unique(each); set.insert(each); }
+
+		suite.run("rb_tree/find", n, [&tree, &keys]() {
+			size_t found = 0;
+			for (auto each : keys) { found += tree.end() != tree.find(each % 2 == 0 ? each : -each - 1) ? 1 : 0; }
+			return found;
+		});
+		suite.run("std::set/find", n, [&set, &keys]() {
+			size_t found = 0;
+			for (auto each : keys) { found += set.end() != set.find(each % 2 == 0 ? each : -each - 1) ? 1 : 0; }
+			return found;
+		});
+
+		/* _avl_tree has no insertion or lookup yet, there is nothing to time */
+	}
+
+	void priority_queue_benchmarks(tools::benchmark_suite& suite, const std::vector<int>& keys) {
+		const size_t n = keys.size();
+
+		suite.run("priority_queue/push_pop", n, [&keys]() {
+			tools::priority_queue<int> queue;
+			for (auto each : keys) { queue.push(each); }
+
+			long long sum = 0;
+			while (!queue.empty()) { sum = 3 * sum + queue.top(); queue.pop(); }
+			return sum;
+		});
+		suite.run("std::priority_queue/push_pop", n, [&keys]() {
+			std::priority_queue<int> queue;
+			for (auto each : keys) { queue.push(each); }
+
+			long long sum = 0;
+			while (!queue.empty()) { sum = 3 * sum + queue.top(); queue.pop(); }
+			return sum;
+		});
+	}
+
+	void adjacency_list_benchmarks(tools::benchmark_suite& suite, const std::vector<int>& keys) {
+		const size_t n = keys.size(), vertices = std::max<size_t>(1, n / 16);
+
+		/* about 16 links out of every vertex */
+		std::vector<std::pair<size_t, size_t>> links(n);
+		for (size_t i = 0; i < n; ++i) { links[i] = std::make_pair(i % vertices, (size_t) keys[i] % vertices); }
+
+		auto std_insert = [&links](std_adjacency_type& graph) {
+			for (auto& each : links) {
+				auto& list = graph[each.first];
+				auto found = std::find_if(list.begin(), list.end(), [&each](const std::pair<size_t, int>& link) {
+					return each.second == link.first;
+				});
+				if (list.end() == found) { list.emplace_back(each.second, 1); } else { found->second = 1; }
+			}
+		};
+
+		suite.run("adjacency_list/insert_link", n, [&links, vertices]() {
+			std::unique_ptr<tools::adjacency_list<int>> result(new tools::adjacency_list<int>(vertices));
+			for (auto& each : links) { result->insert_or_replace_link(each.first, each.second, 1); }
+			return result;
+		});
+		suite.run("std::vector<std::list>/insert_link", n, [&std_insert, vertices]() {
+			std::unique_ptr<std_adjacency_type> result(new std_adjacency_type(vertices));
+			std_insert(*result);
+			return result;
+		});
+
+		tools::adjacency_list<int> graph(vertices);
+		std_adjacency_type std_graph(vertices);
+		for (auto& each : links) { graph.insert_or_replace_link(each.first, each.second, 1); }
+		std_insert(std_graph);
+
+		suite.run("adjacency_list/lookup", n, [&graph, &links]() {
+			long long sum = 0;
+			for (auto& each : links) { sum += graph(each.second, each.first); }
+			return sum;
+		});
+		suite.run("std::vector<std::list>/lookup", n, [&std_graph, &links]() {
+			long long sum = 0;
+			for (auto& each : links) {
+				for (auto& link : std_graph[each.second]) {
+					if (each.first == link.first) { sum += link.second; break; }
+				}
+			}
+			return sum;
+		});
+	}
+
+	void matrix_benchmarks(tools::benchmark_suite& suite, size_t n) {
+		const size_t cols = 64, rows = std::max<size_t>(1, n / cols);
+
+		suite.run("matrix/fill_sum", rows * cols, [rows, cols]() {
+			tools::matrix<double> m(rows, cols);
+			for (size_t r = 0; r < rows; ++r) {
+				for (size_t c = 0; c < cols; ++c) { m(r, c) = (double) (r ^ c); }
+			}
+
+			double sum = 0.0;
+			for (size_t r = 0; r < rows; ++r) {
+				for (size_t c = 0; c < cols; ++c) { sum += m(r, c); }
+			}
+			return sum;
+		});
+		suite.run("std::vector/fill_sum", rows * cols, [rows, cols]() {
+			std::vector<double> m(rows * cols, 0.0);
+			for (size_t r = 0; r < rows; ++r) {
+				for (size_t c = 0; c < cols; ++c) { m[r * cols + c] = (double) (r ^ c); }
+			}
+
+			double sum = 0.0;
+			for (size_t r = 0; r < rows; ++r) {
+				for (size_t c = 0; c < cols; ++c) { sum += m[r * cols + c]; }
+			}
+			return sum;
+		});
+
+		std::vector<double> row(cols);
+		for (size_t c = 0; c < cols; ++c) { row[c] = (double) c; }
+
+		suite.run("matrix/push_bottom", rows * cols, [&row, rows, cols]() {
+			std::unique_ptr<tools::matrix<double>> result(new tools::matrix<double>(0, cols));
+			for (size_t r = 0; r < rows; ++r) { result->push_bottom(row.begin(), row.end()); }
+			return result;
+		});
+		suite.run("std::vector/push_bottom", rows * cols, [&row, rows]() {
+			std::unique_ptr<std::vector<double>> result(new std::vector<double>());
+			for (size_t r = 0; r < rows; ++r) { result->insert(result->end(), row.begin(), row.end()); }
+			return result;
+		});
+
+		tools::matrix<double> m(rows, cols);
+		for (size_t r = 0; r < rows; ++r) { m(r, 0) = (double) (r % 3); }
+
+		suite.run("matrix/select", rows * cols, [&m]() {
+			return m.select([&m](size_t r, const auto&, const auto&) { return 0.0 != m(r, 0); }).rows();
+		});
+	}
+}
+
+void container_benchmarks(tools::benchmark_suite& suite, size_t n) {
+	std::mt19937_64 engine(2019);
+	std::vector<int> keys(n);
+	for (size_t i = 0; i < n; ++i) { keys[i] = (int) i; }
+	std::shuffle(keys.begin(), keys.end(), engine);
+
+	sequence_benchmarks(suite, keys);
+	hashtable_benchmarks(suite, keys);
+	rb_tree_benchmarks(suite, keys);
+	priority_queue_benchmarks(suite, keys);
+	adjacency_list_benchmarks(suite, keys);
+	matrix_benchmarks(suite, n);
+}
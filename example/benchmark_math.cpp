@@ -0,0 +1,80 @@
+/*
+ * Created by Maou Lim on 2019/7/27.
+ */
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../common/benchmark.h"
+#include "../math/vector.h"
+#include "../math/vector_operator.h"
+
+/* apart from the container benchmarks, container/iterator.h would hide the vector operators */
+
+namespace {
+
+	typedef math::vector<float, 16> vector_type;
+	typedef std::array<float, 16>   array_type;
+}
+
+void math_benchmarks(tools::benchmark_suite& suite, size_t n) {
+	const size_t count = std::max<size_t>(1, n / 16);
+
+	std::mt19937_64 engine(2019);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	std::vector<vector_type> xs(count), ys(count);
+	std::vector<array_type> axs(count), ays(count);
+	for (size_t i = 0; i < count; ++i) {
+		for (size_t k = 0; k < 16; ++k) {
+			axs[i][k] = xs[i][k] = uniform(engine);
+			ays[i][k] = ys[i][k] = uniform(engine);
+		}
+	}
+
+	suite.run("math::vector/axpy", count, [&xs, &ys]() {
+		std::vector<vector_type> result(ys);
+		for (size_t i = 0; i < xs.size(); ++i) { result[i] += xs[i] * 0.5f; }
+		return result[0][0];
+	});
+	suite.run("std::array/axpy", count, [&axs, &ays]() {
+		std::vector<array_type> result(ays);
+		for (size_t i = 0; i < axs.size(); ++i) {
+			for (size_t k = 0; k < 16; ++k) { result[i][k] += axs[i][k] * 0.5f; }
+		}
+		return result[0][0];
+	});
+
+	suite.run("math::vector/dot", count, [&xs, &ys]() {
+		float sum = 0.0f;
+		for (size_t i = 0; i < xs.size(); ++i) { sum += math::dot(xs[i], ys[i]); }
+		return sum;
+	});
+	suite.run("std::array/dot", count, [&axs, &ays]() {
+		float sum = 0.0f;
+		for (size_t i = 0; i < axs.size(); ++i) {
+			float dot = 0.0f;
+			for (size_t k = 0; k < 16; ++k) { dot += axs[i][k] * ays[i][k]; }
+			sum += dot;
+		}
+		return sum;
+	});
+
+	suite.run("math::vector/normalize", count, [&xs]() {
+		std::vector<vector_type> result(xs);
+		for (auto& each : result) { math::normalize(each); }
+		return result[0][0];
+	});
+	suite.run("std::array/normalize", count, [&axs]() {
+		std::vector<array_type> result(axs);
+		for (auto& each : result) {
+			float squares = 0.0f;
+			for (auto v : each) { squares += v * v; }
+			const float length = std::sqrt(squares);
+			for (auto& v : each) { v /= length; }
+		}
+		return result[0][0];
+	});
+}
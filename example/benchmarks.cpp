@@ -0,0 +1,68 @@
+/*
+ * Created by Maou Lim on 2019/7/27.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "../common/benchmark.h"
+
+/* in benchmark_container.cpp and benchmark_math.cpp */
+void container_benchmarks(tools::benchmark_suite& suite, size_t n);
+void math_benchmarks(tools::benchmark_suite& suite, size_t n);
+
+void usage(std::ostream& stream) {
+	stream << "usage: Benchmarks [--size items] [--warmup runs] [--repetitions runs]\n"
+	          "                  [--filter substring] [--json file]\n"
+	          "  --size         items per container or vector (default 65536)\n"
+	          "  --warmup       untimed runs before timing (default 2)\n"
+	          "  --repetitions  timed runs, the median is reported (default 15)\n"
+	          "  --filter       only the benchmarks whose name contains it\n"
+	          "  --json         also write the results to this file\n"
+	          "  -h, --help     print this and exit" << std::endl;
+}
+
+/**
+ * @note Benchmarks [--size items] [--warmup runs] [--repetitions runs]
+ *                  [--filter substring] [--json file]
+ */
+int main(int argc, char* argv[]) {
+	size_t size = 1 << 16, warmup = 2, repetitions = 15;
+	std::string filter, json;
+
+	/* every option but --help takes a value, so one left alone at the end is an error rather than dropped */
+	for (int i = 1; i < argc; i += 2) {
+		if (0 == std::strcmp("-h", argv[i]) || 0 == std::strcmp("--help", argv[i])) { usage(std::cout); return 0; }
+
+		const bool known = 0 == std::strcmp("--size", argv[i]) || 0 == std::strcmp("--warmup", argv[i]) ||
+		                   0 == std::strcmp("--repetitions", argv[i]) || 0 == std::strcmp("--filter", argv[i]) ||
+		                   0 == std::strcmp("--json", argv[i]);
+		if (!known) { std::cerr << "unknown option " << argv[i] << std::endl; usage(std::cerr); return 1; }
+		if (i + 1 == argc) { std::cerr << "option " << argv[i] << " has no value" << std::endl; usage(std::cerr); return 1; }
+
+		if (0 == std::strcmp("--size", argv[i])) { size = (size_t) std::atoll(argv[i + 1]); }
+		else if (0 == std::strcmp("--warmup", argv[i])) { warmup = (size_t) std::atoll(argv[i + 1]); }
+		else if (0 == std::strcmp("--repetitions", argv[i])) { repetitions = (size_t) std::atoll(argv[i + 1]); }
+		else if (0 == std::strcmp("--filter", argv[i])) { filter = argv[i + 1]; }
+		else { json = argv[i + 1]; }
+	}
+
+	tools::benchmark_suite suite(warmup, repetitions);
+	suite.set_filter(filter);
+
+	container_benchmarks(suite, size);
+	math_benchmarks(suite, size);
+
+	std::cout << size << " items, " << warmup << " warmup and " << repetitions << " timed repetitions" << std::endl;
+	suite.print(std::cout);
+
+	if (!json.empty()) {
+		std::ofstream stream(json);
+		if (!stream) { std::cerr << "cannot write " << json << std::endl; return 1; }
+		suite.write_json(stream);
+	}
+	return 0;
+}
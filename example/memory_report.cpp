@@ -0,0 +1,146 @@
+/*
+ * Created by Maou Lim on 2019/7/28.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "../container/adjacency_list.h"
+#include "../container/bidirectional_list.h"
+#include "../container/hashtable.h"
+#include "../container/heap.h"
+#include "../container/matrix.h"
+#include "../container/rb_tree.h"
+#include "../container/sequence.h"
+#include "../container/unidirectional_list.h"
+
+/* every container type counts under a tag of its own */
+template <typename _Tag>
+using counted = tools::counting_alloc<std::allocator<char>, _Tag>;
+
+struct sequence_tag { };
+struct bidirectional_list_tag { };
+struct unidirectional_list_tag { };
+struct hashtable_tag { };
+struct rb_tree_tag { };
+struct priority_queue_tag { };
+struct adjacency_list_tag { };
+struct matrix_tag { };
+
+bool report(const std::string& name, size_t elements, size_t payload, size_t usage, const tools::alloc_usage& counted, size_t left) {
+	const double per_element = elements ? (double) counted.live_bytes / elements : 0.0;
+	std::printf(
+		"%-20s %10llu %12llu %12llu %12llu %10llu %10.2f %10.2f\n",
+		name.c_str(), (unsigned long long) elements, (unsigned long long) counted.live_bytes, (unsigned long long) usage,
+		(unsigned long long) counted.peak_bytes, (unsigned long long) counted.allocations, per_element, per_element - payload
+	);
+
+	bool good = true;
+	if (usage != counted.live_bytes) { std::printf("\tmemory_usage() disagrees with the allocator\n"); good = false; }
+	if (0 != left) { std::printf("\t%llu bytes still live after destruction\n", (unsigned long long) left); good = false; }
+	return good;
+}
+
+/* fill one container counting in _Alloc, report on it, and check it gives everything back */
+template <typename _Alloc, typename _Fill>
+bool measure(const std::string& name, size_t elements, size_t payload, _Fill fill) {
+	typedef typename std::remove_pointer<decltype(fill())>::type container_type;
+	_Alloc::reset();
+
+	size_t usage;
+	tools::alloc_usage counted_usage;
+	{
+		std::unique_ptr<container_type> container(fill());
+		usage = container->memory_usage();
+		counted_usage = _Alloc::usage();
+	}
+	return report(name, elements, payload, usage, counted_usage, _Alloc::usage().live_bytes);
+}
+
+/**
+ * @note memory_report [elements], the bytes every container holds once
+ *       it is filled with that many ints, and what an element costs
+ *       beyond its own 4 bytes.
+ */
+int main(int argc, char* argv[]) {
+	const size_t n = 1 < argc ? (size_t) std::atoll(argv[1]) : 100000;
+	const size_t payload = sizeof (int);
+
+	std::printf(
+		"%-20s %10s %12s %12s %12s %10s %10s %10s\n",
+		"container", "elements", "live bytes", "usage", "peak bytes", "allocs", "bytes/elem", "overhead"
+	);
+
+	bool good = true;
+
+	typedef counted<sequence_tag> sequence_alloc;
+	typedef tools::sequence<int, sequence_alloc> sequence_type;
+	good = measure<sequence_alloc>("sequence", n, payload, [n]() {
+		auto result = new sequence_type();
+		for (size_t i = 0; i < n; ++i) { result->push_back((int) i); }
+		return result;
+	}) && good;
+
+	typedef counted<bidirectional_list_tag> bilist_alloc;
+	typedef tools::bidirectional_list<int, bilist_alloc> bilist_type;
+	good = measure<bilist_alloc>("bidirectional_list", n, payload, [n]() {
+		auto result = new bilist_type();
+		for (size_t i = 0; i < n; ++i) { result->push_back((int) i); }
+		return result;
+	}) && good;
+
+	typedef counted<unidirectional_list_tag> unilist_alloc;
+	typedef tools::unidirectional_list<int, unilist_alloc> unilist_type;
+	good = measure<unilist_alloc>("unidirectional_list", n, payload, [n]() {
+		auto result = new unilist_type();
+		for (size_t i = 0; i < n; ++i) { result->push_front((int) i); }
+		return result;
+	}) && good;
+
+	typedef counted<hashtable_tag> hashtable_alloc;
+	typedef tools::_hashtable<int, int, std::hash<int>, tools::identity<int>, tools::equal_to<int>, hashtable_alloc> hashtable_type;
+	good = measure<hashtable_alloc>("_hashtable", n, payload, [n]() {
+		auto result = new hashtable_type(100, std::hash<int>(), tools::equal_to<int>());
+		for (size_t i = 0; i < n; ++i) { result->insert_unique((int) i); }
+		return result;
+	}) && good;
+
+	typedef counted<rb_tree_tag> rb_tree_alloc;
+	typedef tools::_rb_tree<int, int, tools::identity<int>, tools::less<int>, rb_tree_alloc> rb_tree_type;
+	good = measure<rb_tree_alloc>("_rb_tree", n, payload, [n]() {
+		auto result = new rb_tree_type();
+		for (size_t i = 0; i < n; ++i) { result->insert_unique((int) i); }
+		return result;
+	}) && good;
+
+	typedef counted<priority_queue_tag> queue_alloc;
+	typedef tools::priority_queue<int, tools::sequence<int, queue_alloc>> queue_type;
+	good = measure<queue_alloc>("priority_queue", n, payload, [n]() {
+		auto result = new queue_type();
+		for (size_t i = 0; i < n; ++i) { result->push((int) i); }
+		return result;
+	}) && good;
+
+	/* about 16 links out of every vertex */
+	const size_t vertices = n / 16 ? n / 16 : 1;
+	typedef counted<adjacency_list_tag> graph_alloc;
+	typedef tools::adjacency_list<int, 0, graph_alloc> graph_type;
+	good = measure<graph_alloc>("adjacency_list", n, payload, [n, vertices]() {
+		auto result = new graph_type(vertices);
+		for (size_t i = 0; i < n; ++i) { result->insert_or_replace_link(i % vertices, (i % vertices + 1 + i / vertices) % vertices, 1); }
+		return result;
+	}) && good;
+
+	const size_t cols = 64, rows = n / cols ? n / cols : 1;
+	typedef counted<matrix_tag> matrix_alloc;
+	typedef tools::matrix<int, tools::sequence<int, matrix_alloc>> matrix_type;
+	good = measure<matrix_alloc>("matrix", rows * cols, payload, [rows, cols]() {
+		return new matrix_type(rows, cols);
+	}) && good;
+
+	return good ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/*
+ * Created by Maou Lim on 2019/7/20.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+
+#include "../ml/autodiff.h"
+
+/* counts heap allocations, to show the steady state training loop makes none */
+static tools::size_t allocations = 0;
+
+void* operator new(std::size_t size) {
+	++allocations;
+	if (void* p = std::malloc(size)) { return p; }
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+typedef ml::tensor<double> tensor;
+typedef ml::tape<double>   tape;
+typedef ml::var<double>    var;
+
+static std::mt19937_64 rand_engine(2019);
+
+tensor random_tensor(const ml::shape& dims, double scale = 1.0) {
+	std::normal_distribution<double> normal(0.0, scale);
+	tensor result(dims);
+	result.apply([&normal](double& x) { x = normal(rand_engine); });
+	return result;
+}
+
+/* binary cross entropy of sigmoid(x * w + b) against y, plus an L2 term */
+var logistic_loss(var x, var y, var w, var b, double regular) {
+	var p = ml::sigmoid(ml::matmul(x, w) + b);
+	var entropy = -(y * ml::log(p + 1e-12) + (1.0 - y) * ml::log((1.0 - p) + 1e-12));
+	return ml::mean(entropy) + 0.5 * regular * ml::sum(ml::square(w));
+}
+
+/* central differences against the tape's gradient of w */
+double max_gradient_error(tape& t, const tensor& x, const tensor& y, tensor& w, const tensor& b) {
+	const double h = 1e-6, regular = 1e-3;
+
+	t.reset();
+	var vw = t.variable(w);
+	t.backward(logistic_loss(t.constant(x), t.constant(y), vw, t.variable(b), regular));
+	const tensor grad = t.gradient(vw).clone();
+
+	double worst = 0.0;
+	for (tools::size_t i = 0; i < w.dim(0); ++i) {
+		const double origin = w(i, 0);
+		double loss[2];
+		for (int side = 0; side < 2; ++side) {
+			w(i, 0) = origin + (0 == side ? h : -h);
+			t.reset();
+			var l = logistic_loss(t.constant(x), t.constant(y), t.variable(w), t.variable(b), regular);
+			loss[side] = t.value(l)();
+		}
+		w(i, 0) = origin;
+
+		const double numeric = (loss[0] - loss[1]) / (2 * h);
+		worst = std::max(worst, std::abs(numeric - grad(i, 0)));
+	}
+	return worst;
+}
+
+int main() {
+	const tools::size_t samples = 512, features = 8, steps = 300;
+	const double alpha = 0.5, regular = 1e-3;
+
+	/* labels from a hidden linear rule */
+	const tensor x = random_tensor(ml::shape { samples, features });
+	const tensor truth = random_tensor(ml::shape { features, 1 });
+	const tensor y = ml::map(ml::matmul(x, truth), [](double z) { return 0.0 < z ? 1.0 : 0.0; });
+
+	tensor w(ml::shape { features, 1 }), b(ml::shape { 1 });
+
+	tape t;
+	std::cout << "max |numeric - autodiff| on w: " << max_gradient_error(t, x, y, w, b) << std::endl;
+
+	/* the hand derived gradient of the logistic regression example */
+	{
+		t.reset();
+		var vw = t.variable(w), vb = t.variable(b);
+		t.backward(logistic_loss(t.constant(x), t.constant(y), vw, vb, regular));
+
+		const tensor p = ml::sigmoid(ml::matmul(x, w) + b);
+		const tensor hand = ml::matmul(x.transpose(), p - y) / (double) samples + regular * w;
+
+		double worst = 0.0;
+		const tensor& grad = t.gradient(vw);
+		for (tools::size_t i = 0; i < features; ++i) { worst = std::max(worst, std::abs(hand(i, 0) - grad(i, 0))); }
+
+		/* b is broadcast over the samples, its gradient is summed back */
+		const double hand_b = ml::sum(p - y) / samples;
+		worst = std::max(worst, std::abs(hand_b - t.gradient(vb)(0)));
+		std::cout << "max |hand written - autodiff| on w, b: " << worst << std::endl;
+	}
+
+	tape training;
+	tools::size_t first_step = 0, later_steps = 0;
+	for (tools::size_t step = 0; step < steps; ++step) {
+		const tools::size_t before = allocations;
+
+		training.reset();
+		var vw = training.variable(w), vb = training.variable(b);
+		var loss = logistic_loss(training.constant(x), training.constant(y), vw, vb, regular);
+		training.backward(loss);
+
+		w.apply(training.gradient(vw), [alpha](double& p, double g) { p -= alpha * g; });
+		b.apply(training.gradient(vb), [alpha](double& p, double g) { p -= alpha * g; });
+
+		if (0 == step) { first_step = allocations - before; }
+		else { later_steps += allocations - before; }
+
+		if (0 == step % 100) { std::cout << "step " << step << "\tloss: " << training.value(loss)() << std::endl; }
+	}
+
+	std::cout << "tape nodes: " << training.size() << std::endl;
+	std::cout << "allocations: first step " << first_step
+	          << ", next " << steps - 1 << " steps " << later_steps << std::endl;
+
+	tools::size_t correct = 0;
+	const tensor predicted = ml::matmul(x, w) + b;
+	for (tools::size_t i = 0; i < samples; ++i) {
+		if ((0.0 < predicted(i, 0)) == (0.5 < y(i, 0))) { ++correct; }
+	}
+	std::cout << "accuracy on training set: " << (double) correct / samples << std::endl;
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Created by Maou Lim on 2019/7/12.
+ */
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "../math/vector.h"
+#include "../math/vector_operator.h"
+#include "../ml/optimizer.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+const size_t dimension = 32;
+
+typedef math::vector<double, dimension> param;
+typedef std::pair<param, double>        sample;
+
+struct squared_error_gradient {
+	param operator()(const param& theta, const sample& s) const {
+		return (math::dot(theta, s.first) - s.second) * s.first;
+	}
+};
+
+class virtual_gradient_descent :
+	public ml::gradient_descent<param, sample, double> {
+public:
+	explicit virtual_gradient_descent(double alpha) : gradient_descent(alpha) { }
+
+	param_type gradient(const param_type& theta, const sample_type& s) override {
+		return squared_error_gradient()(theta, s);
+	}
+};
+
+static std::mt19937_64 rand_engine(2019);
+
+template <typename _Optimizer>
+double train(_Optimizer& optimizer, const std::vector<sample>& samples, size_t epochs, param& theta) {
+	auto start = clock_type::now();
+	for (size_t epoch = 0; epoch < epochs; ++epoch) {
+		optimizer.optimize(theta, samples.begin(), samples.end());
+	}
+	return std::chrono::duration<double, std::milli>(clock_type::now() - start).count() / epochs;
+}
+
+int main() {
+	const size_t batch_size = 100000;
+	const size_t epochs     = 50;
+
+	std::uniform_real_distribution<double> rand_real(-1.0, 1.0);
+
+	param truth;
+	for (size_t i = 0; i < dimension; ++i) { truth[i] = (double) i / dimension; }
+
+	std::vector<sample> samples(batch_size);
+	for (auto& each : samples) {
+		for (size_t i = 0; i < dimension; ++i) { each.first[i] = rand_real(rand_engine); }
+		each.second = math::dot(truth, each.first) + 0.01 * rand_real(rand_engine);
+	}
+
+	param theta_virtual = param(), theta_single = param(), theta_parallel = param();
+
+	virtual_gradient_descent virtual_optimizer(0.5);
+	ml::batched_gradient_descent<param, sample, squared_error_gradient> single_optimizer(0.5, squared_error_gradient(), 1);
+	ml::batched_gradient_descent<param, sample, squared_error_gradient> parallel_optimizer(0.5);
+
+	const double virtual_ms  = train(virtual_optimizer, samples, epochs, theta_virtual);
+	const double single_ms   = train(single_optimizer, samples, epochs, theta_single);
+	const double parallel_ms = train(parallel_optimizer, samples, epochs, theta_parallel);
+
+	double max_error = 0.0;
+	bool   identical = true;
+	for (size_t i = 0; i < dimension; ++i) {
+		max_error = std::max(max_error, std::abs(theta_parallel[i] - truth[i]));
+		identical = identical && theta_single[i] == theta_parallel[i];
+	}
+
+	std::cout << "virtual, 1 thread:  " << virtual_ms << " ms / batch" << std::endl;
+	std::cout << "functor, 1 thread:  " << single_ms << " ms / batch" << std::endl;
+	std::cout << "functor, " << parallel_optimizer.threads() << " threads: "
+	          << parallel_ms << " ms / batch" << std::endl;
+	std::cout << "max |theta - truth|: " << max_error << std::endl;
+	std::cout << "1 thread and " << parallel_optimizer.threads() << " threads agree bitwise: "
+	          << (identical ? "yes" : "no") << std::endl;
+
+	return 0;
+}
@@ -3,6 +3,7 @@
  */
 
 #include <iostream>
+#include <stdexcept>
 
 #include "../ml/candidate_elimination.h"
 
@@ -31,6 +32,27 @@ int main() {
 	space.fit(s4);
 
 	std::cout << space << std::endl;
-	return 0;
+
+	/* an attribute of 100 values takes more than a word of bits, value 70 sits in the second one */
+	ml::version_space<int> wide(ml::meta<int>({ 100, 3 }));
+	wide.fit(ml::sample<int>({ 70, 1 }, yes));
+	wide.fit(ml::sample<int>({ 5 , 1 }, no ));
+	wide.fit(ml::sample<int>({ 70, 2 }, yes));
+
+	std::cout << wide << std::endl;
+	const ml::constraint<int> expected({ 70, ml::meta_info<int>::all });
+	const bool generalized = 1 == wide.special_rules().size() && expected == wide.special_rules().front() &&
+	                         ml::vote::positive == wide.classify(ml::candidate<int>({ 70, 0 })) &&
+	                         ml::vote::negative == wide.classify(ml::candidate<int>({ 5, 0 }));
+
+	/* a value beyond its limit is refused rather than packed into the next field */
+	bool refused = false;
+	try { wide.fit(ml::sample<int>({ 100, 1 }, no)); }
+	catch (const std::out_of_range&) { refused = true; }
+	refused = refused && 1 == wide.special_rules().size();
+
+	std::cout << "wide attribute: " << (generalized ? "generalized" : "WRONG") << ", value 100 of 100: "
+	          << (refused ? "refused" : "NOT REFUSED") << std::endl;
+	return generalized && refused ? 0 : 1;
 }
 
@@ -0,0 +1,202 @@
+/*
+ * Created by Maou Lim on 2019/7/10.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../math/math_io.h"
+#include "../ml/dataset.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+inline double elapsed_ms(clock_type::time_point since) {
+	return std::chrono::duration<double, std::milli>(clock_type::now() - since).count();
+}
+
+static std::mt19937_64 rand_engine(2019);
+
+/* a fresh directory under $TMPDIR (or /tmp), removed with the files made in it when this goes out of scope */
+class scratch_dir {
+public:
+	scratch_dir() {
+		const char* tmp = std::getenv("TMPDIR");
+		std::string pattern = std::string(nullptr == tmp || '\0' == *tmp ? "/tmp" : tmp) + "/test_dataset.XXXXXX";
+		if (nullptr != mkdtemp(&pattern[0])) { m_path = pattern; }
+	}
+
+	~scratch_dir() {
+		if (m_path.empty()) { return; }
+		for (auto& each : m_files) { std::remove(each.c_str()); }
+		rmdir(m_path.c_str());
+	}
+
+	scratch_dir(const scratch_dir&) = delete;
+	scratch_dir& operator=(const scratch_dir&) = delete;
+
+	bool good() const { return !m_path.empty(); }
+
+	std::string file(const std::string& name) {
+		m_files.push_back(m_path + "/" + name);
+		return m_files.back();
+	}
+
+private:
+	std::string              m_path;
+	std::vector<std::string> m_files;
+};
+
+/* overwrites the field at a byte offset into a file image */
+template <typename _Tp>
+void poke(std::vector<char>& bytes, size_t at, _Tp value) { std::memcpy(bytes.data() + at, &value, sizeof(value)); }
+
+std::vector<char> read_bytes(const std::string& path) {
+	std::ifstream stream(path, std::ios::binary);
+	return std::vector<char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @note Files a reader must refuse rather than read through: a column
+ *       or the table off its 64 byte boundary, a row count whose byte
+ *       count wraps around to what the column really holds, and a rle
+ *       column claiming more rows than its records describe.
+ */
+bool rejects_corrupt_files(scratch_dir& dir) {
+	const size_t rows = 1000;
+	const std::string mixed_path = dir.file("mixed.tbds"), rle_path = dir.file("rle.tbds"), bad_path = dir.file("corrupt.tbds");
+
+	std::vector<double> values(rows);
+	std::vector<tools::sint32_t> labels(rows, 1);
+	for (size_t i = 0; i < rows; ++i) { values[i] = (double) i / rows; }
+	{
+		ml::dataset_writer writer(mixed_path, rows);
+		writer.add_column("x", values.data());
+		writer.add_column("label", labels.data(), ml::column_codec::rle);
+	}
+	{
+		ml::dataset_writer writer(rle_path, rows);
+		writer.add_column("label", labels.data(), ml::column_codec::rle);
+	}
+
+	const std::vector<char> mixed = read_bytes(mixed_path), rle = read_bytes(rle_path);
+	if (!ml::dataset(mixed_path).is_open() || !ml::dataset(rle_path).is_open()) {
+		std::cout << "an intact file was refused" << std::endl;
+		return false;
+	}
+
+	/* header: rows at byte 8, table_offset at 24; column entry: offset at byte 48 */
+	tools::uint64_t table, column;
+	std::memcpy(&table, mixed.data() + 24, sizeof(table));
+	std::memcpy(&column, mixed.data() + table + 48, sizeof(column));
+
+	struct corruption {
+		const char*                              what;
+		const std::vector<char>&                 source;
+		std::function<void(std::vector<char>&)>  apply;
+	};
+	const std::vector<corruption> corruptions = {
+		{ "misaligned column", mixed, [&](std::vector<char>& b) { poke<tools::uint64_t>(b, table + 48, column + 8); } },
+		{ "misaligned table", mixed, [&](std::vector<char>& b) {
+			b.insert(b.begin() + (std::ptrdiff_t) table, 8, '\0');
+			poke<tools::uint64_t>(b, 24, table + 8);
+		} },
+		{ "row count wrapping around", mixed, [&](std::vector<char>& b) { poke<tools::uint64_t>(b, 8, rows + (1ull << 61)); } },
+		{ "rle column short of records", rle, [&](std::vector<char>& b) { poke<tools::uint64_t>(b, 8, 1ull << 40); } }
+	};
+
+	bool good = true;
+	for (auto& each : corruptions) {
+		std::vector<char> bytes(each.source);
+		each.apply(bytes);
+		std::ofstream(bad_path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize) bytes.size());
+
+		const bool refused = !ml::dataset(bad_path).is_open();
+		std::cout << each.what << ": " << (refused ? "refused" : "ACCEPTED") << std::endl;
+		good = refused && good;
+	}
+	return good;
+}
+
+int main() {
+	const size_t rows = 1000000;
+	const size_t cols = 16;
+
+	/* the two files come to about 450 MB, kept out of the working directory */
+	scratch_dir dir;
+	if (!dir.good()) {
+		std::cout << "cannot create a temporary directory" << std::endl;
+		return 1;
+	}
+	const std::string tsv_path = dir.file("dataset.tsv"), binary_path = dir.file("dataset.tbds");
+
+	if (!rejects_corrupt_files(dir)) { return 1; }
+
+	std::normal_distribution<double> rand_feature(0.0, 1.0);
+
+	tools::matrix<double> features(rows, cols);
+	std::vector<tools::sint32_t> labels(rows);
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t c = 0; c < cols; ++c) { features(r, c) = rand_feature(rand_engine); }
+		labels[r] = (tools::sint32_t) (r / 1000 % 2);
+	}
+
+	auto start = clock_type::now();
+	{
+		std::ofstream text(tsv_path);
+		math::tsv_writer writer(text);
+		writer.write(features);
+	}
+	std::cout << "write tsv: " << elapsed_ms(start) << " ms" << std::endl;
+
+	start = clock_type::now();
+	{
+		ml::dataset_writer writer(binary_path, rows);
+		writer.add_columns(features);
+		writer.add_column("label", labels.data(), ml::column_codec::rle);
+	}
+	std::cout << "write binary: " << elapsed_ms(start) << " ms" << std::endl;
+
+	start = clock_type::now();
+	tools::matrix<double> parsed(0, 0);
+	if (!math::load_tsv(tsv_path, parsed) || rows != parsed.rows() || cols != parsed.cols()) {
+		std::cout << "cannot load " << tsv_path << std::endl;
+		return 1;
+	}
+	std::cout << "load tsv: " << elapsed_ms(start) << " ms" << std::endl;
+
+	start = clock_type::now();
+	ml::dataset data(binary_path);
+	std::cout << "open binary: " << elapsed_ms(start) << " ms, "
+	          << data.rows() << " rows, " << data.columns() << " columns" << std::endl;
+
+	ml::sample_view<double, tools::sint32_t> samples;
+	if (!data.samples(0, cols, data.find("label"), samples)) {
+		std::cout << "unexpected layout" << std::endl;
+		return 1;
+	}
+
+	start = clock_type::now();
+	size_t mismatches = 0;
+	for (size_t r = 0; r < samples.size(); ++r) {
+		auto sample = samples[r];
+		mismatches += sample.label != labels[r];
+		for (size_t c = 0; c < cols; ++c) {
+			mismatches += sample.features[c] != features(r, c);
+			mismatches += parsed(r, c) != features(r, c);
+		}
+	}
+	std::cout << "scan: " << elapsed_ms(start) << " ms, mismatches: " << mismatches << std::endl;
+
+	return 0 == mismatches ? 0 : 1;
+}
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
 
 #include "../container/matrix.h"
 #include "../ml/decision_tree.h"
@@ -30,6 +33,24 @@ const value_type training_data[] = {
 	rain    , mild, high  , strong, no
 };
 
+/* the same days with the temperature (F) and the humidity (%) measured */
+const value_type numeric_data[] = {
+	sunny   , 85, 85, weak  , no ,
+	sunny   , 80, 90, strong, no ,
+	overcast, 83, 86, weak  , yes,
+	rain    , 70, 96, weak  , yes,
+	rain    , 68, 80, weak  , yes,
+	rain    , 65, 70, strong, no ,
+	overcast, 64, 65, strong, yes,
+	sunny   , 72, 95, weak  , no ,
+	sunny   , 69, 70, weak  , yes,
+	rain    , 75, 80, weak  , yes,
+	sunny   , 75, 70, strong, yes,
+	overcast, 72, 90, strong, yes,
+	overcast, 81, 75, weak  , yes,
+	rain    , 71, 91, strong, no
+};
+
 int main() {
 
 	const sample_space training_set(14, 5, training_data, training_data + 14 * 5);
@@ -39,7 +60,67 @@ int main() {
 
 	std::cout << tree << std::endl;
 
-	return 0;
+	/* the compiled tree against the rows it was grown from, one by one and as a batch */
+	const std::vector<value_type> labels = tree.predict(training_set);
+
+	size_t correct = 0, agree = 0;
+	for (size_t r = 0; r < training_set.rows(); ++r) {
+		if (training_set(r, 4) == labels[r]) { ++correct; }
+		if (tree.predict_one(training_set[r]) == labels[r]) { ++agree; }
+	}
+	std::cout << "training accuracy: " << correct << " / " << training_set.rows()
+	          << ", single row predictions agreeing: " << agree << std::endl;
+
+	const value_type unseen[] = { rain, hot, high, strong };
+	std::cout << "rain, hot, high, strong -> " << (yes == tree.predict_one(unseen) ? "yes" : "no") << std::endl;
+
+
+	const sample_space numeric_set(14, 5, numeric_data, numeric_data + 14 * 5);
+
+	ml::decision_tree<attr_type, value_type> numeric_tree;
+	numeric_tree.set_numeric(1);
+	numeric_tree.set_numeric(2);
+	numeric_tree.build(numeric_set);
+
+	std::cout << std::endl << numeric_tree << std::endl;
+
+	const value_type muggy[] = { sunny, 74, 78, weak };
+	std::cout << "sunny, 74F, 78%, weak -> " << (yes == numeric_tree.predict_one(muggy) ? "yes" : "no") << std::endl;
+
+	/* a categorical attribute with more values than a bin code holds is refused, not wrapped around */
+	const size_t many = ml::max_bins + 10;
+	sample_space identifiers(many, 2);
+	for (size_t r = 0; r < many; ++r) { identifiers(r, 0) = (value_type) r; identifiers(r, 1) = (value_type) (r % 2); }
+
+	bool refused = false;
+	try {
+		ml::decision_tree<attr_type, value_type> wide_tree;
+		wide_tree.build(identifiers);
+	}
+	catch (const std::length_error&) { refused = true; }
+	std::cout << many << " categories: " << (refused ? "refused" : "NOT REFUSED") << std::endl;
+
+	/* a numeric attribute is ranked, not binned, so far more distinct values than bin codes still split right */
+	const size_t uniform_rows = 200000;
+	std::mt19937_64 engine(2019);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	tools::matrix<double> uniform_set(uniform_rows, 2), held_out(10000, 2);
+	for (size_t r = 0; r < uniform_rows; ++r) { uniform_set(r, 0) = uniform(engine); uniform_set(r, 1) = uniform_set(r, 0) < 0.5 ? 1.0 : 0.0; }
+	for (size_t r = 0; r < held_out.rows(); ++r) { held_out(r, 0) = uniform(engine); held_out(r, 1) = held_out(r, 0) < 0.5 ? 1.0 : 0.0; }
+
+	ml::decision_tree<attr_type, double> uniform_tree;
+	uniform_tree.set_numeric(0);
+	uniform_tree.build(uniform_set);
+
+	size_t fitted = 0, generalized = 0;
+	const std::vector<double> fitted_labels = uniform_tree.predict(uniform_set), held_out_labels = uniform_tree.predict(held_out);
+	for (size_t r = 0; r < uniform_rows; ++r) { fitted += uniform_set(r, 1) == fitted_labels[r] ? 1 : 0; }
+	for (size_t r = 0; r < held_out.rows(); ++r) { generalized += held_out(r, 1) == held_out_labels[r] ? 1 : 0; }
+	std::cout << uniform_rows << " distinct values, x < 0.5: " << fitted << " / " << uniform_rows << " fitted, "
+	          << generalized << " / " << held_out.rows() << " held out" << std::endl;
+
+	const bool ranked = uniform_rows == fitted && held_out.rows() <= generalized + 10;
+	return refused && ranked ? 0 : 1;
 }
 
 
@@ -0,0 +1,147 @@
+/*
+ * Created by Maou Lim on 2019/7/22.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../container/matrix.h"
+#include "../ml/decision_tree.h"
+
+typedef int                       attr_type;
+typedef int                       value_type;
+typedef tools::matrix<value_type> sample_space;
+
+/* rows of `attrs` categorical attributes with `values` values each, labels from a noisy rule */
+sample_space make_dataset(size_t rows, size_t attrs, int values, std::mt19937_64& engine) {
+	std::uniform_int_distribution<int> value(0, values - 1);
+	std::uniform_real_distribution<double> noise(0.0, 1.0);
+
+	sample_space data(rows, attrs + 1);
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t c = 0; c < attrs; ++c) { data(r, c) = value(engine); }
+		const int label = (data(r, 0) + 2 * data(r, 1) + (data(r, 2) == data(r, 3) ? 1 : 0)) % 3;
+		data(r, attrs) = noise(engine) < 0.1 ? value(engine) % 3 : label;
+	}
+	return data;
+}
+
+/* two measurements of `levels` levels, the label is which side of a line they are */
+sample_space make_numeric_dataset(size_t rows, int levels, std::mt19937_64& engine) {
+	std::uniform_int_distribution<int> value(0, levels - 1);
+	std::uniform_real_distribution<double> noise(0.0, 1.0);
+
+	sample_space data(rows, 3);
+	for (size_t r = 0; r < rows; ++r) {
+		data(r, 0) = value(engine);
+		data(r, 1) = value(engine);
+		const int label = data(r, 0) + data(r, 1) / 2 < levels ? 0 : 1;
+		data(r, 2) = noise(engine) < 0.05 ? 1 - label : label;
+	}
+	return data;
+}
+
+/* the measurements as categories (a child per level) and as numbers (threshold splits) */
+void compare_numeric(size_t rows, std::mt19937_64& engine) {
+	typedef std::chrono::steady_clock clock_type;
+
+	const int levels = 10000;
+	const sample_space train = make_numeric_dataset(rows, levels, engine);
+	const sample_space test = make_numeric_dataset(rows / 10, levels, engine);
+
+	for (int numeric = 0; numeric < 2; ++numeric) {
+		ml::decision_tree<attr_type, value_type> tree;
+		tree.set_numeric(0, 1 == numeric);
+		tree.set_numeric(1, 1 == numeric);
+
+		const auto start = clock_type::now();
+		tree.build(train);
+		const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+		const std::vector<value_type> labels = tree.predict(test);
+		size_t correct = 0;
+		for (size_t r = 0; r < test.rows(); ++r) {
+			if (test(r, 2) == labels[r]) { ++correct; }
+		}
+
+		std::cout << (1 == numeric ? "numeric    " : "categorical") << "\t" << rows << " rows x 2 attributes of "
+		          << levels << " values: built in " << seconds << " s, held out accuracy " << (double) correct / test.rows() << std::endl;
+	}
+}
+
+/* build time with the given threads, the tree printed into `shape` */
+double time_build(const sample_space& data, size_t threads, std::string& shape) {
+	typedef std::chrono::steady_clock clock_type;
+
+	ml::decision_tree<attr_type, value_type> tree;
+	tree.set_threads(threads);
+
+	const auto start = clock_type::now();
+	tree.build(data);
+	const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	std::ostringstream stream;
+	tree.print(stream);
+	shape = stream.str();
+	return seconds;
+}
+
+int main(int argc, char* argv[]) {
+	const size_t rows   = 1 < argc ? (size_t) std::atoll(argv[1]) : 1000000;
+	const int    values = 2 < argc ? std::atoi(argv[2]) : 8;
+	const size_t most   = 3 < argc ? (size_t) std::atoll(argv[3]) : 32;
+	const size_t attrs  = 8;
+
+	std::mt19937_64 engine(2019);
+	const sample_space data = make_dataset(rows, attrs, values, engine);
+
+	std::cout << rows << " rows x " << attrs << " attributes of " << values << " values, "
+	          << tools::concurrency() << " hardware threads" << std::endl;
+
+	std::string serial;
+	const double base = time_build(data, 1, serial);
+	std::cout << "threads: 1\tbuilt in " << base << " s (" << rows / base << " rows/s)" << std::endl;
+
+	/* the speedup can not exceed the hardware threads, past them it shows the overhead */
+	for (size_t threads = 2; threads <= most; threads *= 2) {
+		std::string shape;
+		const double seconds = time_build(data, threads, shape);
+		std::cout << "threads: " << threads << "\tbuilt in " << seconds << " s (" << rows / seconds << " rows/s)"
+		          << "\tspeedup: " << base / seconds << (shape == serial ? "" : "\tTREE DIFFERS") << std::endl;
+	}
+
+	/* scoring through the compiled tree, by blocks of rows against one row at a time */
+	typedef std::chrono::steady_clock clock_type;
+
+	ml::decision_tree<attr_type, value_type> tree;
+	tree.set_threads(1);
+	tree.build(data);
+
+	auto start = clock_type::now();
+	const std::vector<value_type> labels = tree.predict(data);
+	const double batched = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	size_t agree = 0;
+	start = clock_type::now();
+	for (size_t r = 0; r < rows; ++r) {
+		if (tree.predict_one(data[r]) == labels[r]) { ++agree; }
+	}
+	const double single = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	size_t correct = 0;
+	for (size_t r = 0; r < rows; ++r) {
+		if (data(r, attrs) == labels[r]) { ++correct; }
+	}
+
+	std::cout << "predict: " << rows / batched << " rows/s batched, " << rows / single << " rows/s one by one, "
+	          << agree << " agreeing, training accuracy " << (double) correct / rows << std::endl;
+
+	/* a tenth of the rows, the fan-out of the categorical tree takes long enough on those */
+	compare_numeric(rows / 10, engine);
+	return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Created by Maou Lim on 2019/7/25.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../container/matrix.h"
+#include "../ml/gbdt.h"
+
+typedef float                     value_type;
+typedef tools::matrix<value_type> sample_space;
+
+/* features in [-1, 1], the target a smooth function of the first twelve plus noise */
+void make_dataset(size_t rows, size_t features, std::mt19937_64& engine, sample_space& x, std::vector<value_type>& y) {
+	std::uniform_real_distribution<value_type> uniform(-1.0f, 1.0f);
+	std::normal_distribution<double> noise(0.0, 0.1);
+
+	x = sample_space(rows, features);
+	y.resize(rows);
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t f = 0; f < features; ++f) { x(r, f) = uniform(engine); }
+
+		double target = x(r, 10) * x(r, 11) + noise(engine);
+		for (size_t f = 0; f < 10; ++f) { target += std::sin(3.0 * x(r, f)) / (1.0 + f); }
+		y[r] = (value_type) target;
+	}
+}
+
+template <typename _Metric>
+void run(const char* name, ml::boosting_loss loss, const sample_space& train, const std::vector<value_type>& train_y,
+         const sample_space& test, const std::vector<value_type>& test_y, size_t rounds, _Metric metric) {
+	typedef std::chrono::steady_clock clock_type;
+
+	ml::gbdt<value_type> model(loss);
+	model.set_rounds(rounds);
+	model.set_max_depth(6);
+	model.set_learning_rate(0.3);
+
+	auto start = clock_type::now();
+	model.train(train, train_y);
+	const double training = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	start = clock_type::now();
+	const std::vector<value_type> scores = model.predict(train);
+	const double scoring = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	std::cout << name << "\t" << model.trees() << " trees trained in " << training << " s, held out "
+	          << metric(test_y, model.predict(test)) << ", scoring " << train.rows() / scoring << " rows/s ("
+	          << train.rows() * model.trees() / scoring << " tree rows/s), score[0] " << scores[0] << std::endl;
+}
+
+/* the same model on one thread and on four, which the fixed summing blocks guarantee */
+bool same_on_threads(const sample_space& train, const std::vector<value_type>& train_y, size_t rounds) {
+	std::vector<value_type> scores[2];
+	const size_t threads[2] = { 1, 4 };
+	for (size_t k = 0; k < 2; ++k) {
+		ml::gbdt<value_type> model;
+		model.set_rounds(rounds);
+		model.set_threads(threads[k]);
+		model.train(train, train_y);
+		scores[k] = model.predict(train);
+	}
+
+	const bool same = scores[0] == scores[1];
+	std::cout << "1 and 4 threads	" << (same ? "same" : "DIFFERENT") << " predictions" << std::endl;
+	return same;
+}
+
+int main(int argc, char* argv[]) {
+	const size_t rows     = 1 < argc ? (size_t) std::atoll(argv[1]) : 1000000;
+	const size_t features = 2 < argc ? (size_t) std::atoll(argv[2]) : 100;
+	const size_t rounds   = 3 < argc ? (size_t) std::atoll(argv[3]) : 20;
+
+	std::mt19937_64 engine(2019);
+	sample_space train(1, 1), test(1, 1);
+	std::vector<value_type> train_y, test_y;
+	make_dataset(rows, features, engine, train, train_y);
+	make_dataset(rows / 10, features, engine, test, test_y);
+
+	std::cout << rows << " x " << features << " rows, " << tools::concurrency() << " hardware threads" << std::endl;
+
+	run("squared error", ml::boosting_loss::squared_error, train, train_y, test, test_y, rounds,
+		[](const std::vector<value_type>& y, const std::vector<value_type>& p) {
+			double error = 0.0;
+			for (size_t i = 0; i < y.size(); ++i) { error += (y[i] - p[i]) * (y[i] - p[i]); }
+			return std::sqrt(error / y.size());
+		}
+	);
+
+	const bool same = same_on_threads(train, train_y, std::min<size_t>(rounds, 5));
+
+	/* the sign of the same target as the label */
+	for (auto& each : train_y) { each = 0.0f < each ? 1.0f : 0.0f; }
+	for (auto& each : test_y) { each = 0.0f < each ? 1.0f : 0.0f; }
+
+	run("logistic     ", ml::boosting_loss::logistic, train, train_y, test, test_y, rounds,
+		[](const std::vector<value_type>& y, const std::vector<value_type>& p) {
+			size_t correct = 0;
+			for (size_t i = 0; i < y.size(); ++i) { correct += (0.5f < p[i]) == (0.5f < y[i]) ? 1 : 0; }
+			return (double) correct / y.size();
+		}
+	);
+	return same ? 0 : 1;
+}
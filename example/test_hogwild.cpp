@@ -0,0 +1,87 @@
+/*
+ * Created by Maou Lim on 2019/7/14.
+ */
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include "../ml/hogwild.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+struct sparse_sample {
+	std::vector<tools::uint32_t> index;
+	std::vector<double>          value;
+	double                       label;
+};
+
+struct sparse_squared_error {
+	template <typename _Theta, typename _Update>
+	void operator()(const _Theta& theta, const sparse_sample& s, _Update& update) const {
+		double prediction = 0.0;
+		for (size_t k = 0; k < s.index.size(); ++k) { prediction += theta[s.index[k]] * s.value[k]; }
+
+		const double residual = prediction - s.label;
+		for (size_t k = 0; k < s.index.size(); ++k) { update(s.index[k], residual * s.value[k]); }
+	}
+};
+
+static std::mt19937_64 rand_engine(2019);
+
+double mean_squared_error(const std::vector<double>& theta, const std::vector<sparse_sample>& samples) {
+	double sum = 0.0;
+	for (auto& s : samples) {
+		double prediction = 0.0;
+		for (size_t k = 0; k < s.index.size(); ++k) { prediction += theta[s.index[k]] * s.value[k]; }
+		sum += (prediction - s.label) * (prediction - s.label);
+	}
+	return sum / samples.size();
+}
+
+int main() {
+	const size_t dimension = 100000;
+	const size_t count     = 200000;
+	const size_t nonzeros  = 10;
+	const size_t epochs    = 10;
+
+	std::uniform_int_distribution<tools::uint32_t> rand_index(0, dimension - 1);
+	std::normal_distribution<double>                rand_normal(0.0, 1.0);
+
+	std::vector<double> truth(dimension);
+	for (auto& each : truth) { each = rand_normal(rand_engine); }
+
+	std::vector<sparse_sample> samples(count);
+	for (auto& s : samples) {
+		s.label = 0.0;
+		for (size_t k = 0; k < nonzeros; ++k) {
+			s.index.push_back(rand_index(rand_engine));
+			s.value.push_back(rand_normal(rand_engine));
+			s.label += truth[s.index.back()] * s.value.back();
+		}
+	}
+
+	const size_t thread_counts[] = { 1, 2, 4, tools::concurrency() };
+	for (size_t threads : thread_counts) {
+		for (auto mode : { ml::sharding::contiguous, ml::sharding::interleaved }) {
+			ml::hogwild_sgd<sparse_sample, sparse_squared_error> sgd(dimension, 0.05);
+			sgd.set_sharding(mode);
+
+			auto start = clock_type::now();
+			const size_t updates = sgd.train(samples.begin(), samples.end(), epochs, threads);
+			const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+			std::vector<double> theta(dimension);
+			sgd.parameters().copy_to(theta.begin());
+
+			std::cout << threads << " threads, "
+			          << (ml::sharding::contiguous == mode ? "contiguous " : "interleaved")
+			          << "\ttime: " << seconds << " s"
+			          << "\tthroughput: " << updates / seconds << " samples/s"
+			          << "\tmse: " << mean_squared_error(theta, samples) << std::endl;
+		}
+	}
+
+	return 0;
+}
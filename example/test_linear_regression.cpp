@@ -3,36 +3,23 @@
  */
 
 #include <iostream>
+#include <fstream>
 #include <random>
 #include <ctime>
 
-#include "../container/sequence.h"
-#include "../ml/optimizer.h"
 #include "../math/vector4.h"
-#include "../math/vector_function.h"
+#include "../math/vector_operator.h"
 #include "../math/math_io.h"
+#include "../container/sequence.h"
+#include "../ml/optimizer.h"
+#include "../ml/trainer.h"
+#include "../ml/data_source.h"
 
-inline tools::vector4d operator+(const tools::vector4d& left, const tools::vector4d& right) {
-	return apply(left, right, tools::plus<double>());
-}
-
-inline tools::vector4d operator*(double scalar, const tools::vector4d& v) {
-	tools::vector4d result;
-	tools::transform(v, result, [scalar](size_t, double val) { return val * scalar; });
-	return result;
-}
-
-inline tools::vector4d operator/(const tools::vector4d& v, double scalar) {
-	tools::vector4d result;
-	tools::transform(v, result, [scalar](size_t, double val) { return val / scalar; });
-	return result;
-}
-
-typedef std::pair<tools::vector4d, double> sample;
-typedef tools::sequence<sample>            sample_space;
+typedef std::pair<math::vector4d, double> sample;
+typedef tools::sequence<sample>           sample_space;
 
 class gradient_descent_with_rmse :
-	public ml::gradient_descent<tools::vector4d, sample, double> {
+	public ml::gradient_descent<math::vector4d, sample, double> {
 public:
 
 	explicit gradient_descent_with_rmse(double alpha) :
@@ -41,15 +28,42 @@ public:
 	param_type gradient(
 		const param_type& theta, const sample_type& sample
 	) override {
-		return (tools::dot(theta, sample.first) - sample.second) * sample.first;
+		return (math::dot(theta, sample.first) - sample.second) * sample.first;
 	}
 };
 
-inline double target_func(const tools::vector4d& x) {
+class linear_regression_trainer :
+	public ml::trainer<math::vector4d, sample, gradient_descent_with_rmse, sample_space, double> {
+public:
+
+	void optimize(
+		optimizer_type& optimizer, trainee_type& theta, sample_iterator first, sample_iterator last
+	) override {
+		optimizer.optimize(theta, first, last);
+	}
+
+	error_type error(const trainee_type& theta, const sample_type& sample) override {
+		const double diff = math::dot(theta, sample.first) - sample.second;
+		return diff * diff;
+	}
+};
+
+/* "x0 \t x1 \t x2 \t x3 \t y" per line */
+struct sample_parser {
+	bool operator()(const char* first, const char* last, sample& s) const {
+		math::vector<double, 5> fields;
+		if (!math::from_tsv(first, last, fields)) { return false; }
+		s.first  = math::vector4d(fields[0], fields[1], fields[2], fields[3]);
+		s.second = fields[4];
+		return true;
+	}
+};
+
+inline double target_func(const math::vector4d& x) {
 	return 1 * x[0] + 2 * x[1] + 3 * x[2] + 4 * x[3];
 }
 
-inline double func_with_noisy(const tools::vector4d& x) {
+inline double func_with_noisy(const math::vector4d& x) {
 	return target_func(x) + 1 * std::sin(x[1] + x[2] + x[3]);
 }
 
@@ -63,7 +77,7 @@ int main() {
 	const size_t batch_size      = 20;
 
 	/* generate inputs */
-	tools::vector4d inputs[training_set_sz];
+	math::vector4d inputs[training_set_sz];
 	for (size_t i = 0; i < training_set_sz; ++i) {
 		inputs[i][0] = 1;
 		inputs[i][1] = i % 10;
@@ -75,37 +89,40 @@ int main() {
 	training_set.reserve(training_set_sz);
 	for (size_t i = 0; i < training_set_sz; ++i) {
 		training_set.emplace_back(
-			(tools::vector4d) inputs[i],
+			(math::vector4d) inputs[i],
 			func_with_noisy(inputs[i])
 		);
 	}
 
-	std::uniform_int_distribution<size_t> rand_int(0, training_set_sz - 1);
-
 	/* initialize parameters */
-	tools::vector4d theta = { 0.5, 0.1, 0.2, 0.4 };
-	gradient_descent_with_rmse optimizer(2e-3);
-
-	sample_space mini_batch; mini_batch.reserve(batch_size);
+	math::vector4d theta(0.5, 0.1, 0.2, 0.4);
+
+	linear_regression_trainer trainer;
+	trainer.feed(training_set.begin(), training_set.end());
+	trainer.seed(time(nullptr));
+	trainer.set_reporter([](const ml::epoch_report& report) {
+		if (0 != report.epoch % 5) { return; }
+		std::cout << "epoch " << report.epoch
+		          << "\tmse: " << report.error
+		          << "\t" << report.samples_per_second << " samples/s" << std::endl;
+	});
 
 	/* start training */
-	for (size_t epoch = 0; epoch < max_epoch; ++epoch) {
-		mini_batch.clear();
-		for (size_t i = 0; i < batch_size; ++i) {
-			mini_batch.emplace_back(training_set[rand_int(rand_engine)]);
-		}
-
-		optimizer.optimize(theta, mini_batch.begin(), mini_batch.end());
-	}
+	const size_t epochs = trainer.train(
+		theta,
+		ml::either(ml::max_epochs(max_epoch), ml::min_error(0.5)),
+		linear_regression_trainer::mini_batch,
+		2e-3, batch_size
+	);
 
 	/* output linear-regression parameter theta */
-	std::cout << "Linear-Regression parameter: " << theta << std::endl;
+	std::cout << "Linear-Regression parameter after " << epochs << " epochs: " << theta << std::endl;
 
 	size_t count_correct = 0;
 	double max_error     = 5e-2;
 
 	for (auto& each : training_set) {
-		auto output = tools::dot(theta, each.first);
+		auto output = math::dot(theta, each.first);
 		auto diff = std::abs(output - each.second);
 		auto relative_err = diff / output;
 		if (relative_err < max_error) { ++count_correct; }
@@ -115,6 +132,25 @@ int main() {
 	          << (float) count_correct / training_set_sz
 	          << std::endl;
 
+	/* same training, streamed from a file through the prefetcher */
+	{
+		std::ofstream file("linear_regression.tsv");
+		math::tsv_writer writer(file);
+		for (auto& each : training_set) {
+			writer.write(each.first).delimiter().write(each.second).newline();
+		}
+	}
+
+	ml::line_source<sample, sample_parser> source("linear_regression.tsv");
+	math::vector4d streamed_theta(0.5, 0.1, 0.2, 0.4);
+
+	linear_regression_trainer streaming_trainer;
+	const size_t streamed_epochs = streaming_trainer.train_stream(
+		streamed_theta, source, ml::max_epochs(epochs), 2e-3, batch_size
+	);
+
+	std::cout << "Streamed parameter after " << streamed_epochs << " epochs: " << streamed_theta << std::endl;
+
 	/* generate testing-set */
 
 	std::uniform_real_distribution<double> rand_real(-100.0, 100.0);
@@ -122,11 +158,11 @@ int main() {
 	count_correct = 0;
 
 	for (size_t i = 0; i < testing_set_sz; ++i) {
-		auto test_input = tools::vector4d(
+		auto test_input = math::vector4d(
 			1.0, rand_real(rand_engine), rand_real(rand_engine), rand_real(rand_engine)
 		);
 
-		auto output = tools::dot(theta, test_input);
+		auto output = math::dot(theta, test_input);
 		auto diff = std::abs(output - target_func(test_input));
 		auto relative_err = diff / output;
 		if (relative_err < max_error) { ++count_correct; }
@@ -136,4 +172,4 @@ int main() {
 	          << (float) count_correct / testing_set_sz
 	          << std::endl;
 	return 0;
-}
\ No newline at end of file
+}
@@ -5,58 +5,58 @@
 #include <iostream>
 #include <utility>
 #include <random>
-#include <ctime>
 
-#include "../container/sequence.h"
-#include "../ml/optimizer.h"
 #include "../math/vector3.h"
-#include "../math/vector_function.h"
+#include "../math/vector_operator.h"
 #include "../math/math_io.h"
+#include "../container/sequence.h"
+#include "../ml/optimizer.h"
+#include "../ml/trainer.h"
 
-typedef int                               label;
-typedef std::pair<tools::vector3d, label> sample;
-typedef tools::sequence<sample>           sample_space;
-
-inline tools::vector3d operator+(const tools::vector3d& left, const tools::vector3d& right) {
-	return apply(left, right, tools::plus<double>());
-}
-
-inline tools::vector3d operator*(double scalar, const tools::vector3d& v) {
-	tools::vector3d result;
-	tools::transform(v, result, [scalar](size_t, double val) { return val * scalar; });
-	return result;
-}
-
-inline tools::vector3d operator/(const tools::vector3d& v, double scalar) {
-	tools::vector3d result;
-	tools::transform(v, result, [scalar](size_t, double val) { return val / scalar; });
-	return result;
-}
+typedef int                              label;
+typedef std::pair<math::vector3d, label> sample;
+typedef tools::sequence<sample>          sample_space;
 
 class gradient_descent_with_entropy :
-	public ml::gradient_descent<tools::vector3d, sample> {
+	public ml::adam<math::vector3d, sample> {
 public:
 
-	explicit gradient_descent_with_entropy(double alpha, double r) :
-		gradient_descent(alpha), regular(r) { }
+	explicit gradient_descent_with_entropy(double alpha, double r = 1e-3) :
+		adam(alpha), regular(r) { }
 
 	param_type gradient(
 		const param_type& theta, const sample_type& sample
 	) override {
-		return (tools::sigmoid(tools::dot(theta, sample.first)) - sample.second) * sample.first
+		return (math::sigmoid(math::dot(theta, sample.first)) - sample.second) * sample.first
 		       + regular * theta;
 	}
 
 	double regular;
 };
 
-static std::mt19937_64 rand_engine(time(nullptr));
+class logistic_regression_trainer :
+	public ml::trainer<math::vector3d, sample, gradient_descent_with_entropy, sample_space, double> {
+public:
+
+	void optimize(
+		optimizer_type& optimizer, trainee_type& theta, sample_iterator first, sample_iterator last
+	) override {
+		optimizer.optimize(theta, first, last);
+	}
+
+	error_type error(const trainee_type& theta, const sample_type& sample) override {
+		const double p = math::sigmoid(math::dot(theta, sample.first));
+		return -std::log(sample.second ? p : 1.0 - p);
+	}
+};
+
+static std::mt19937_64 rand_engine(2019);
 
-inline label target_classifier(const tools::vector3d& vec) {
+inline label target_classifier(const math::vector3d& vec) {
 	return 0.0 < (-3 * vec[0] + 2 * vec[1] - vec[2]);
 }
 
-inline label classifier_with_noisy(const tools::vector3d& vec) {
+inline label classifier_with_noisy(const math::vector3d& vec) {
 	static std::uniform_int_distribution<size_t> rand_int(1, 100);
 	static std::uniform_int_distribution<label>  rand_label(0, 1);
 	if (50 < rand_int(rand_engine)) {
@@ -67,8 +67,8 @@ inline label classifier_with_noisy(const tools::vector3d& vec) {
 	}
 }
 
-inline label model(const tools::vector3d& theta, const tools::vector3d& vec) {
-	return 0.5 < tools::sigmoid(tools::dot(theta, vec)) ? 1 : 0;
+inline label model(const math::vector3d& theta, const math::vector3d& vec) {
+	return 0.5 < math::sigmoid(math::dot(theta, vec)) ? 1 : 0;
 }
 
 int main() {
@@ -76,11 +76,11 @@ int main() {
 	/* constants */
 	const size_t training_set_sz = 16;
 	const size_t testing_set_sz  = 100;
-	const size_t max_epoch       = 2000;
+	const size_t max_epoch       = 200;
 	const size_t batch_size      = 20;
 
 	/* generate training-set */
-	tools::vector3d inputs[training_set_sz];
+	math::vector3d inputs[training_set_sz];
 	for (size_t i = 0; i < training_set_sz; ++i) {
 		inputs[i][0] = +1.0;
 		inputs[i][1] = -2.0 + i % 4;
@@ -91,29 +91,22 @@ int main() {
 	training_set.reserve(training_set_sz);
 	for (size_t i = 0; i < training_set_sz; ++i) {
 		training_set.emplace_back(
-			(tools::vector3d) inputs[i],
+			(math::vector3d) inputs[i],
 			classifier_with_noisy(inputs[i])
 		);
 	}
 
-	std::uniform_int_distribution<size_t> rand_int(0, training_set_sz - 1);
-
 	/* initialize parameters */
-	tools::vector3d theta = { 0.5, 0.1, 0.2 };
-	gradient_descent_with_entropy optimizer(1e-1, 1e-3);
+	math::vector3d theta(0.5, 0.1, 0.2);
 
-	sample_space mini_batch; mini_batch.reserve(batch_size);
+	logistic_regression_trainer trainer;
+	trainer.feed(training_set.begin(), training_set.end());
+	trainer.seed(2019);
 
 	/* start training */
-	for (size_t epoch = 0; epoch < max_epoch; ++epoch) {
-		// to select mini-batch
-		mini_batch.clear();
-		for (size_t i = 0; i < batch_size; ++i) {
-			mini_batch.emplace_back(training_set[rand_int(rand_engine)]);
-		}
-
-		optimizer.optimize(theta, mini_batch.begin(), mini_batch.end());
-	}
+	trainer.train(
+		theta, ml::max_epochs(max_epoch), logistic_regression_trainer::mini_batch, 1e-1, batch_size
+	);
 
 	/* output logistic-regression classifier parameter theta */
 	std::cout << "Logistic-Regression classifier parameter: " << theta << std::endl;
@@ -134,7 +127,7 @@ int main() {
 	count_correct = 0;
 
 	for (size_t i = 0; i < testing_set_sz; ++i) {
-		auto test_input = tools::vector3d(
+		auto test_input = math::vector3d(
 			1.0, rand_real(rand_engine), rand_real(rand_engine)
 		);
 
@@ -145,5 +138,6 @@ int main() {
 	          << (float) count_correct / testing_set_sz
 	          << std::endl;
 
-	return 0;
+	/* half the training labels are coin flips, the boundary should still be found */
+	return 8 * testing_set_sz <= 10 * count_correct ? 0 : 1;
 }
\ No newline at end of file
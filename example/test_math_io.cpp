@@ -0,0 +1,144 @@
+/*
+ * Created by Maou Lim on 2019/7/30.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+/* vector_operator.h is skipped once container/iterator.h was included, so the math headers go first */
+#include "../math/vector.h"
+#include "../math/math_io.h"
+#include "../container/matrix.h"
+
+typedef tools::matrix<double> matrix_type;
+
+bool check(const char* what, bool good) {
+	std::printf("%-40s %s\n", what, good ? "ok" : "FAILED");
+	return good;
+}
+
+/* the whole text is one number equal to expected */
+template <typename _Tp>
+bool parses(const std::string& text, _Tp expected) {
+	_Tp value = _Tp();
+	const char* end = math::parse_number(text.data(), text.data() + text.size(), value);
+	return text.data() + text.size() == end && 0 == std::memcmp(&value, &expected, sizeof(value));
+}
+
+/* nothing of the text is taken as a number */
+template <typename _Tp>
+bool rejects(const std::string& text) {
+	_Tp value = _Tp();
+	return text.data() == math::parse_number(text.data(), text.data() + text.size(), value);
+}
+
+/* tsv_writer output read back by parse_number and by strto*, both bit for bit */
+template <typename _Tp, typename _Bits>
+bool round_trips(size_t n, std::mt19937_64& engine) {
+	for (size_t i = 0; i < n; ++i) {
+		const _Bits bits = (_Bits) engine();
+		_Tp value;
+		std::memcpy(&value, &bits, sizeof(value));
+		if (!std::isfinite(value)) { continue; }
+
+		math::tsv_writer writer;
+		writer.write(value);
+		const std::string& text = writer.str();
+
+		char* end = nullptr;
+		const _Tp reference = std::is_same<_Tp, float>::value ? std::strtof(text.c_str(), &end) : std::strtod(text.c_str(), &end);
+		if (!parses(text, value) || 0 != std::memcmp(&reference, &value, sizeof(value))) {
+			std::printf("  %s does not read back\n", text.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+std::string written(double value) {
+	math::tsv_writer writer;
+	writer.write(value);
+	return writer.str();
+}
+
+/**
+ * @note test_math_io, parse_number on the edges of every type, then
+ *       from_tsv on blank, ragged and CRLF text, and the round trip of
+ *       random bit patterns through tsv_writer.
+ */
+int main() {
+	bool good = true;
+
+	good = check("integers", parses<int>("-2147483648", -2147483647 - 1) && parses<int>("+42", 42) &&
+	                         parses<tools::uint8_t>("255", 255) && parses<tools::uint64_t>("18446744073709551615", ~0ull)) && good;
+	good = check("integer overflow", rejects<int>("2147483648") && rejects<tools::uint8_t>("256") &&
+	                                 rejects<tools::sint64_t>("9223372036854775808") && rejects<unsigned>("-1")) && good;
+	good = check("not a number", rejects<double>("") && rejects<double>("-") && rejects<double>(".") &&
+	                             rejects<double>("e5") && rejects<double>(" 1") && rejects<int>("x")) && good;
+
+	good = check("decimals", parses("0.1", 0.1) && parses("-1.5e-3", -1.5e-3) && parses("123456.789", 123456.789) &&
+	                         parses(".5", 0.5) && parses("5.", 5.0) && parses("1E+22", 1e22) && parses("0.1", 0.1f)) && good;
+	good = check("decimals past the fast path", parses("9007199254740993", 9007199254740993.0) &&
+	                                            parses("2.2250738585072014e-308", 2.2250738585072014e-308) &&
+	                                            parses("4.9406564584124654e-324", 4.9406564584124654e-324) &&
+	                                            parses("1.7976931348623157e308", 1.7976931348623157e308)) && good;
+	good = check("float overflow to infinity", parses("1e400", std::numeric_limits<double>::infinity()) &&
+	                                           parses("-1e40", -std::numeric_limits<float>::infinity()) &&
+	                                           parses("1e-400", 0.0)) && good;
+	double nan = 0.0;
+	good = check("nan and inf", parses("inf", std::numeric_limits<double>::infinity()) && parses("-inf", -std::numeric_limits<double>::infinity()) &&
+	                            math::parse_number("nan\t1", "nan\t1" + 5, nan) == "nan\t1" + 3 && std::isnan(nan)) && good;
+
+	/* 200 significant digits, more than the 128 byte stack copy */
+	const std::string pi = "3.14159265358979323846264338327950288419716939937510582097494459230781640628620899862803482534211706798214808651328230664709384460955058223172535940812848111745028410270193852110555964462294895493038196";
+	good = check("token longer than 127 characters", parses(pi, 3.141592653589793) &&
+	                                                 parses("0." + std::string(300, '0') + "1e300", 1e-1)) && good;
+
+	math::vector<double, 3> vec;
+	good = check("vector row", math::from_tsv("1\t-2.5\t3e2", vec) && 1.0 == vec[0] && -2.5 == vec[1] && 300.0 == vec[2]) && good;
+	good = check("vector row, trailing tab and CRLF", math::from_tsv(" 1 \t2\t3\t\r\n", vec) && 3.0 == vec[2]) && good;
+	good = check("vector row, short or long", !math::from_tsv("1\t2", vec) && !math::from_tsv("1\t2\t3\t4", vec)) && good;
+	good = check("vector row, empty field", !math::from_tsv("1\t\t3", vec) && !math::from_csv("1,,3", vec)) && good;
+
+	matrix_type mat(0, 0);
+	good = check("matrix, blank lines and CRLF", math::from_tsv("\r\n1\t2\r\n\n  \n3\t4\r\n\n", mat) &&
+	                                             2 == mat.rows() && 2 == mat.cols() && 4.0 == mat(1, 1)) && good;
+	good = check("matrix, ragged rows", !math::from_tsv("1\t2\n3\n", mat) && !math::from_tsv("1\t2\n3\t4\t5\n", mat)) && good;
+	good = check("matrix, csv", math::from_csv("1,2,3\n4,5,6", mat) && 2 == mat.rows() && 3 == mat.cols() && 6.0 == mat(1, 2)) && good;
+	good = check("matrix, empty text", math::from_tsv("", mat) && 0 == mat.rows()) && good;
+
+	good = check("shortest digits", "0.1" == written(0.1) && "0.3" == written(0.3) && "1e-05" == written(1e-5) &&
+	                                "1e+20" == written(1e20) && "-0" == written(-0.0) && "5e-324" == written(5e-324) &&
+	                                "1.7976931348623157e+308" == written(1.7976931348623157e308)) && good;
+
+	std::mt19937_64 engine(2019);
+	good = check("double round trip", round_trips<double, tools::uint64_t>(1000000, engine)) && good;
+	good = check("float round trip", round_trips<float, tools::uint32_t>(1000000, engine)) && good;
+
+	std::uniform_real_distribution<double> value(-1e6, 1e6);
+	matrix_type source(300, 17);
+	for (size_t r = 0; r < source.rows(); ++r) {
+		for (size_t c = 0; c < source.cols(); ++c) { source(r, c) = value(engine) * std::pow(10.0, (double) (c % 7) * 10 - 30); }
+	}
+	matrix_type parsed(0, 0);
+	bool same = math::from_tsv(math::to_tsv(source), parsed) && source.rows() == parsed.rows() && source.cols() == parsed.cols();
+	for (size_t r = 0; same && r < source.rows(); ++r) {
+		for (size_t c = 0; c < source.cols(); ++c) { same = same && source(r, c) == parsed(r, c); }
+	}
+	good = check("matrix round trip", same) && good;
+
+	/* operator<< formats through the stream, to_tsv keeps the trailing tab */
+	vec[0] = 1.0 / 3; vec[1] = 2; vec[2] = -0.5;
+	std::ostringstream stream;
+	stream.precision(3);
+	stream << vec;
+	good = check("operator<< precision", "0.333\t2\t-0.5\t" == stream.str()) && good;
+	good = check("to_tsv trailing tab", "0.3333333333333333\t2\t-0.5\t" == math::to_tsv(vec)) && good;
+
+	return good ? 0 : 1;
+}
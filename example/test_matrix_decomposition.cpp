@@ -0,0 +1,161 @@
+/*
+ * Created by Maou Lim on 2019/7/30.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "../common/parallel.h"
+#include "../container/matrix.h"
+#include "../math/matrix_decomposition.h"
+
+typedef tools::matrix<double> matrix_type;
+
+matrix_type random_matrix(size_t rows, size_t cols, std::mt19937_64& engine) {
+	std::uniform_real_distribution<double> value(-1.0, 1.0);
+	matrix_type result(rows, cols);
+	for (size_t i = 0; i < rows; ++i) {
+		for (size_t j = 0; j < cols; ++j) { result(i, j) = value(engine); }
+	}
+	return result;
+}
+
+matrix_type multiply(const matrix_type& a, const matrix_type& b) {
+	matrix_type result(a.rows(), b.cols());
+	for (size_t i = 0; i < a.rows(); ++i) {
+		for (size_t k = 0; k < a.cols(); ++k) {
+			for (size_t j = 0; j < b.cols(); ++j) { result(i, j) += a(i, k) * b(k, j); }
+		}
+	}
+	return result;
+}
+
+/* ||a - b||_F / ||a||_F */
+double residual(const matrix_type& a, const matrix_type& b) {
+	double diff = 0.0, norm = 0.0;
+	for (size_t i = 0; i < a.rows(); ++i) {
+		for (size_t j = 0; j < a.cols(); ++j) {
+			diff += (a(i, j) - b(i, j)) * (a(i, j) - b(i, j));
+			norm += a(i, j) * a(i, j);
+		}
+	}
+	return std::sqrt(diff / norm);
+}
+
+/* P^T * L * U, undoing the row swaps of the factorization from the last one */
+matrix_type lu_product(const math::lu_decomposition<matrix_type>& lu) {
+	const size_t n = lu.factors.rows();
+	matrix_type l(n, n, tools::matrix_init::identity), u(n, n);
+	for (size_t i = 0; i < n; ++i) {
+		for (size_t j = 0; j < n; ++j) { (j < i ? l(i, j) : u(i, j)) = lu.factors(i, j); }
+	}
+
+	matrix_type result = multiply(l, u);
+	for (size_t i = n; 0 < i--; ) {
+		if (i == lu.pivots[i]) { continue; }
+		for (size_t j = 0; j < n; ++j) { std::swap(result(i, j), result(lu.pivots[i], j)); }
+	}
+	return result;
+}
+
+/* L * L^T, only the lower triangle holds L */
+matrix_type cholesky_product(const math::cholesky_decomposition<matrix_type>& chol) {
+	const size_t n = chol.lower.rows();
+	matrix_type l(n, n), lt(n, n);
+	for (size_t i = 0; i < n; ++i) {
+		for (size_t j = 0; j <= i; ++j) { l(i, j) = lt(j, i) = chol.lower(i, j); }
+	}
+	return multiply(l, lt);
+}
+
+/* H_0 * ... * H_(n-1) * R, applying the reflectors to R from the last one */
+matrix_type qr_product(const math::qr_decomposition<matrix_type>& qr) {
+	const size_t m = qr.factors.rows(), n = qr.factors.cols();
+	matrix_type result(m, n);
+	for (size_t i = 0; i < n; ++i) {
+		for (size_t j = i; j < n; ++j) { result(i, j) = qr.factors(i, j); }
+	}
+
+	for (size_t k = n; 0 < k--; ) {
+		for (size_t c = 0; c < n; ++c) {
+			double w = result(k, c);
+			for (size_t i = k + 1; i < m; ++i) { w += qr.factors(i, k) * result(i, c); }
+			w *= qr.tau[k];
+			result(k, c) -= w;
+			for (size_t i = k + 1; i < m; ++i) { result(i, c) -= w * qr.factors(i, k); }
+		}
+	}
+	return result;
+}
+
+bool check(const char* what, size_t n, double value, double tolerance) {
+	const bool good = value < tolerance;
+	std::printf("%-18s %4llu  %.3e%s\n", what, (unsigned long long) n, value, good ? "" : "  TOO LARGE");
+	return good;
+}
+
+/**
+ * @note test_matrix_decomposition, the relative residuals of LU,
+ *       Cholesky, QR and the inverse around the block size, where the
+ *       blocked paths meet the tail of the last block, and over a few
+ *       blocks, where the trailing updates of QR's compact WY form and
+ *       the tasks of the pool come in.
+ */
+int main() {
+	const double tolerance = 1e-10;
+	std::mt19937_64 engine(2019);
+
+	bool good = true;
+	for (size_t n : { (size_t) 63, (size_t) 64, (size_t) 65, (size_t) 200 }) {
+		const matrix_type a = random_matrix(n, n, engine);
+
+		const auto lu = math::lu_decompose(a);
+		good = check("||A - LU||", n, lu.singular ? 1.0 : residual(a, lu_product(lu)), tolerance) && good;
+
+		/* B^T * B + n * I is symmetric positive definite */
+		const matrix_type b = random_matrix(n, n, engine);
+		matrix_type spd(n, n);
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t j = 0; j < n; ++j) {
+				for (size_t k = 0; k < n; ++k) { spd(i, j) += b(k, i) * b(k, j); }
+			}
+			spd(i, i) += (double) n;
+		}
+		const auto chol = math::cholesky_decompose(spd);
+		good = check("||A - LL^T||", n, chol.positive_definite ? residual(spd, cholesky_product(chol)) : 1.0, tolerance) && good;
+
+		good = check("||A - QR||", n, residual(a, qr_product(math::qr_decompose(a))), tolerance) && good;
+
+		const matrix_type tall = random_matrix(n + 7, n, engine);
+		good = check("||A - QR|| tall", n, residual(tall, qr_product(math::qr_decompose(tall))), tolerance) && good;
+
+		matrix_type inverse(n, n);
+		const bool regular = math::inverse(a, inverse);
+		const matrix_type identity(n, n, tools::matrix_init::identity);
+		good = check("||A A^-1 - I||", n, regular ? residual(identity, multiply(a, inverse)) : 1.0, tolerance) && good;
+	}
+
+	/* more threads than cores on one shared pool, a zero column (tau = 0) in the middle of a block */
+	tools::thread_pool pool(4);
+	const size_t n = 150;
+
+	matrix_type a = random_matrix(n, n, engine);
+	const auto lu = math::lu_decompose(a, pool);
+	good = check("||A - LU|| pool", n, lu.singular ? 1.0 : residual(a, lu_product(lu)), tolerance) && good;
+
+	matrix_type spd(n, n, tools::matrix_init::identity);
+	for (size_t i = 0; i < n; ++i) {
+		for (size_t j = 0; j < n; ++j) { spd(i, j) += (a(i, j) + a(j, i)) / (4.0 * (double) n); }
+	}
+	const auto chol = math::cholesky_decompose(spd, pool);
+	good = check("||A - LL^T|| pool", n, chol.positive_definite ? residual(spd, cholesky_product(chol)) : 1.0, tolerance) && good;
+
+	matrix_type tall = random_matrix(3 * n, n, engine);
+	for (size_t i = 0; i < tall.rows(); ++i) { tall(i, 70) = 0.0; }
+	const auto qr = math::qr_decompose(tall, pool);
+	good = check("||A - QR|| pool", n, residual(tall, qr_product(qr)), tolerance) && good;
+	good = check("tau of zero column", n, std::abs(qr.tau[70]), 1e-300) && good;
+
+	return good ? 0 : 1;
+}
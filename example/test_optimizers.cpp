@@ -0,0 +1,154 @@
+/*
+ * Created by Maou Lim on 2019/7/21.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../math/vector.h"
+#include "../math/vector_operator.h"
+#include "../math/math_common.h"
+#include "../container/sequence.h"
+#include "../ml/optimizer.h"
+#include "../ml/trainer.h"
+
+const tools::size_t dimension = 16;
+
+typedef math::vector<double, dimension>  param;
+typedef std::pair<param, double>         sample;
+typedef tools::sequence<sample>          sample_space;
+
+/* the logistic regression gradient on top of any of the optimizers */
+template <template <typename, typename, typename> class _Optimizer>
+class logistic_gradient : public _Optimizer<param, sample, double> {
+public:
+	template <typename... _Args>
+	explicit logistic_gradient(double alpha, _Args... args) :
+		_Optimizer<param, sample, double>(alpha, args...) { }
+
+	param gradient(const param& theta, const sample& s) override {
+		return (math::sigmoid(math::dot(theta, s.first)) - s.second) * s.first;
+	}
+};
+
+/* momentum(alpha) only takes the step from the trainer, these fix the rest */
+class nesterov_gradient : public logistic_gradient<ml::momentum> {
+public:
+	explicit nesterov_gradient(double alpha) : logistic_gradient(alpha, 0.9, true) { }
+};
+
+template <typename _Optimizer>
+class logistic_trainer : public ml::trainer<param, sample, _Optimizer, sample_space, double> {
+	typedef ml::trainer<param, sample, _Optimizer, sample_space, double> base_type;
+
+public:
+	typedef typename base_type::optimizer_type  optimizer_type;
+	typedef typename base_type::trainee_type    trainee_type;
+	typedef typename base_type::sample_iterator sample_iterator;
+	typedef typename base_type::error_type      error_type;
+
+	void optimize(optimizer_type& optimizer, trainee_type& theta, sample_iterator first, sample_iterator last) override {
+		optimizer.optimize(theta, first, last);
+	}
+
+	error_type error(const trainee_type& theta, const sample& s) override {
+		const double p = math::sigmoid(math::dot(theta, s.first));
+		return -std::log(0.5 < s.second ? p : 1.0 - p);
+	}
+};
+
+template <typename _Optimizer>
+void run(const std::string& name, const sample_space& samples, double rate) {
+	typedef std::chrono::steady_clock clock_type;
+
+	logistic_trainer<_Optimizer> trainer;
+	trainer.feed(samples.begin(), samples.end());
+	trainer.seed(2019);
+
+	param theta = param();
+	double error = 0.0;
+	trainer.set_reporter([&error](const ml::epoch_report& report) { error = report.error; });
+
+	const auto start = clock_type::now();
+	const tools::size_t epochs = trainer.train(
+		theta, ml::either(ml::max_epochs(1000), ml::min_error(0.35)), logistic_trainer<_Optimizer>::mini_batch, rate, 64
+	);
+	const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	std::cout << name << "\tepochs: " << epochs << "\tloss: " << error << "\tseconds: " << seconds << std::endl;
+}
+
+/* the update alone, nanoseconds per parameter */
+template <typename _Step>
+void time_update(const std::string& name, _Step step) {
+	typedef std::chrono::steady_clock clock_type;
+
+	const tools::size_t n = 1 << 16, rounds = 2000;
+	std::vector<double> theta(n, 1.0), g(n, 1e-3), a(n, 0.0), b(n, 0.0);
+
+	const auto start = clock_type::now();
+	for (tools::size_t i = 0; i < rounds; ++i) { step(theta.data(), a.data(), b.data(), g.data(), n); }
+	const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	std::cout << name << "\t" << seconds * 1e9 / (n * rounds) << " ns per parameter (" << theta[0] << ")" << std::endl;
+}
+
+int main() {
+	const tools::size_t count = 4096;
+
+	/* features of very different scales, the case adaptive steps are for */
+	std::mt19937_64 engine(2019);
+	std::normal_distribution<double> normal(0.0, 1.0);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	param scale, truth;
+	for (tools::size_t i = 0; i < dimension; ++i) {
+		scale[i] = std::pow(10.0, (double) (i % 4) - 2.0);
+		truth[i] = 4.0 * normal(engine) / scale[i];
+	}
+
+	sample_space samples;
+	samples.reserve(count);
+	for (tools::size_t k = 0; k < count; ++k) {
+		param x;
+		for (tools::size_t i = 0; i < dimension; ++i) { x[i] = normal(engine) * scale[i]; }
+		const bool label = 0.0 < math::dot(truth, x);
+		samples.emplace_back(x, (uniform(engine) < 0.05 ? !label : label) ? 1.0 : 0.0);
+	}
+
+	/* the stopping condition is asked before the first epoch, max_epochs(0) must leave theta alone */
+	{
+		logistic_trainer<logistic_gradient<ml::gradient_descent>> trainer;
+		trainer.feed(samples.begin(), samples.end());
+		param theta = param();
+		const tools::size_t epochs = trainer.train(theta, ml::max_epochs(0), logistic_trainer<logistic_gradient<ml::gradient_descent>>::one_by_one, 1e-1);
+		if (0 != epochs || 0.0 != math::dot(theta, theta)) {
+			std::cout << "max_epochs(0) ran " << epochs << " epochs" << std::endl;
+			return 1;
+		}
+	}
+
+	run<logistic_gradient<ml::gradient_descent>>("sgd     ", samples, 1e-1);
+	run<logistic_gradient<ml::momentum>>        ("momentum", samples, 1e-2);
+	run<nesterov_gradient>                      ("nesterov", samples, 1e-2);
+	run<logistic_gradient<ml::adagrad>>         ("adagrad ", samples, 1e-1);
+	run<logistic_gradient<ml::rmsprop>>         ("rmsprop ", samples, 1e-2);
+	run<logistic_gradient<ml::adam>>            ("adam    ", samples, 1e-2);
+
+	time_update("sgd     ", [](double* t, double*, double*, const double* g, tools::size_t n) {
+		for (tools::size_t i = 0; i < n; ++i) { t[i] -= 1e-3 * g[i]; }
+	});
+	time_update("nesterov", [](double* t, double* a, double*, const double* g, tools::size_t n) {
+		ml::_momentum_step(t, a, g, n, 1e-3, 0.9, true);
+	});
+	time_update("rmsprop ", [](double* t, double* a, double*, const double* g, tools::size_t n) {
+		ml::_rmsprop_step(t, a, g, n, 1e-3, 0.9, 1e-8);
+	});
+	time_update("adam    ", [](double* t, double* a, double* b, const double* g, tools::size_t n) {
+		ml::_adam_step(t, a, b, g, n, 1e-3, 0.9, 0.999, 1e-8);
+	});
+	return 0;
+}
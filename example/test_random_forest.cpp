@@ -0,0 +1,90 @@
+/*
+ * Created by Maou Lim on 2019/7/24.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../container/matrix.h"
+#include "../ml/random_forest.h"
+
+typedef int                       attr_type;
+typedef int                       value_type;
+typedef tools::matrix<value_type> sample_space;
+
+const size_t numerics = 4, categoricals = 12;
+
+/* 4 measurements and 12 categories, 3 labels from a rule on a few of them plus 10% noise */
+sample_space make_dataset(size_t rows, std::mt19937_64& engine) {
+	std::uniform_int_distribution<int> measure(0, 999), category(0, 4);
+	std::uniform_real_distribution<double> noise(0.0, 1.0);
+
+	sample_space data(rows, numerics + categoricals + 1);
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t c = 0; c < numerics; ++c) { data(r, c) = measure(engine); }
+		for (size_t c = numerics; c < numerics + categoricals; ++c) { data(r, c) = category(engine); }
+
+		int label = data(r, 0) + data(r, 1) < 1000 ? 0 : 1;
+		if (data(r, 2) < 300 && data(r, numerics) < 2) { label = 2; }
+		data(r, numerics + categoricals) = noise(engine) < 0.1 ? (int) (noise(engine) * 3) : label;
+	}
+	return data;
+}
+
+double accuracy(const sample_space& data, const std::vector<value_type>& labels) {
+	size_t correct = 0;
+	for (size_t r = 0; r < data.rows(); ++r) {
+		if (data(r, data.cols() - 1) == labels[r]) { ++correct; }
+	}
+	return (double) correct / data.rows();
+}
+
+int main(int argc, char* argv[]) {
+	typedef std::chrono::steady_clock clock_type;
+
+	const size_t rows  = 1 < argc ? (size_t) std::atoll(argv[1]) : 100000;
+	const size_t trees = 2 < argc ? (size_t) std::atoll(argv[2]) : 50;
+
+	std::mt19937_64 engine(2019);
+	const sample_space train = make_dataset(rows, engine);
+	const sample_space test = make_dataset(rows / 10, engine);
+
+	std::cout << rows << " rows, " << numerics << " numeric and " << categoricals << " categorical attributes, "
+	          << tools::concurrency() << " hardware threads" << std::endl;
+
+	ml::decision_tree<attr_type, value_type> single;
+	for (size_t c = 0; c < numerics; ++c) { single.set_numeric((attr_type) c); }
+
+	auto start = clock_type::now();
+	single.build(train);
+	double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+	std::cout << "one tree\tbuilt in " << seconds << " s, held out accuracy " << accuracy(test, single.predict(test)) << std::endl;
+
+	ml::random_forest<attr_type, value_type> forest;
+	forest.set_trees(trees);
+	for (size_t c = 0; c < numerics; ++c) { forest.set_numeric((attr_type) c); }
+
+	/* the matrix is coded once, the trees share it */
+	const ml::tree_data<value_type> data(train, std::vector<bool>(numerics, true));
+
+	for (size_t threads = 1; ; threads = std::min<size_t>(2 * threads, tools::concurrency())) {
+		forest.set_threads(threads);
+
+		start = clock_type::now();
+		forest.build(data);
+		seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+		start = clock_type::now();
+		const std::vector<value_type> labels = forest.predict(test);
+		const double scoring = std::chrono::duration<double>(clock_type::now() - start).count();
+
+		std::cout << trees << " trees, " << threads << " threads\tbuilt in " << seconds << " s, held out accuracy "
+		          << accuracy(test, labels) << ", predict " << test.rows() / scoring << " rows/s" << std::endl;
+
+		if (tools::concurrency() == threads) { break; }
+	}
+	return 0;
+}
@@ -0,0 +1,233 @@
+/*
+ * Created by Maou Lim on 2019/7/30.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+
+/* vector_operator.h is skipped once container/iterator.h was included, so the math headers go first */
+#include "../math/vector.h"
+#include "../math/vector_operator.h"
+#include "../container/sparse_matrix.h"
+#include "../ml/optimizer.h"
+
+typedef tools::matrix<double>       dense_type;
+typedef tools::coo_matrix<double>   coo_type;
+typedef tools::csr_matrix<double>   csr_type;
+typedef tools::csc_matrix<double>   csc_type;
+typedef tools::sequence<double>     sequence_type;
+typedef tools::sparse_view<double>  view_type;
+
+const size_t features = 32;
+
+typedef math::vector<double, features>      param;
+typedef std::pair<view_type, double>        sample;
+
+/* least squares on a sparse sample, the gradient only touches its non-zeros */
+class sparse_least_squares : public ml::gradient_descent<param, sample, double> {
+public:
+	explicit sparse_least_squares(double alpha) : gradient_descent(alpha) { }
+
+	param_type gradient(const param_type& theta, const sample_type& s) override {
+		param_type result = param_type();
+		return tools::axpy(result, tools::dot(s.first, theta) - s.second, s.first);
+	}
+};
+
+/* the same gradient reported one non-zero at a time, for optimize_sparse */
+struct sparse_residual {
+	template <typename _Update>
+	void operator()(const param& theta, const sample& s, _Update& update) const {
+		const double residual = tools::dot(s.first, theta) - s.second;
+		for (size_t i = 0; i < s.first.nnz; ++i) { update(s.first.indices[i], residual * s.first.values[i]); }
+	}
+};
+
+bool report(const char* what, double error, double tolerance) {
+	const bool good = error <= tolerance;
+	std::printf("%-26s %.3e%s\n", what, error, good ? "" : "  TOO LARGE");
+	return good;
+}
+
+double max_error(const sequence_type& a, const sequence_type& b) {
+	double result = a.size() == b.size() ? 0.0 : 1.0;
+	for (size_t i = 0; i < a.size() && i < b.size(); ++i) { result = std::max(result, std::abs(a[i] - b[i])); }
+	return result;
+}
+
+double max_error(const dense_type& a, const dense_type& b) {
+	double result = a.rows() == b.rows() && a.cols() == b.cols() ? 0.0 : 1.0;
+	for (size_t i = 0; i < a.rows() && i < b.rows(); ++i) {
+		for (size_t j = 0; j < a.cols() && j < b.cols(); ++j) { result = std::max(result, std::abs(a(i, j) - b(i, j))); }
+	}
+	return result;
+}
+
+/* how far a sparse matrix is from the dense one, entry by entry */
+template <typename _Sparse>
+double max_error(const _Sparse& a, const dense_type& dense) {
+	double result = a.rows() == dense.rows() && a.cols() == dense.cols() ? 0.0 : 1.0;
+	for (size_t i = 0; i < a.rows() && i < dense.rows(); ++i) {
+		for (size_t j = 0; j < a.cols() && j < dense.cols(); ++j) { result = std::max(result, std::abs(a(i, j) - dense(i, j))); }
+	}
+	return result;
+}
+
+dense_type multiply(const dense_type& a, const dense_type& b, bool transpose_a) {
+	const size_t rows = transpose_a ? a.cols() : a.rows(), inner = transpose_a ? a.rows() : a.cols();
+	dense_type result(rows, b.cols());
+	for (size_t i = 0; i < rows; ++i) {
+		for (size_t k = 0; k < inner; ++k) {
+			const double v = transpose_a ? a(k, i) : a(i, k);
+			for (size_t j = 0; j < b.cols(); ++j) { result(i, j) += v * b(k, j); }
+		}
+	}
+	return result;
+}
+
+/**
+ * @note test_sparse_matrix, builds CSR and CSC from triplets with
+ *       duplicates and checks every product against the dense one,
+ *       then fits a least-squares model over sparse samples.
+ */
+int main() {
+	std::mt19937_64 engine(2019);
+	std::uniform_real_distribution<double> value(-1.0, 1.0);
+
+	/* about 1% dense, wide enough for the column partials of the CSC SpMV, and every 10th entry given twice */
+	const size_t rows = 3000, cols = 2500, entries = rows * cols / 100;
+	coo_type coo(rows, cols);
+	dense_type dense(rows, cols);
+	for (size_t e = 0; e < entries; ++e) {
+		const size_t r = engine() % rows, c = engine() % cols;
+		const size_t times = 0 == e % 10 ? 2 : 1;
+		for (size_t t = 0; t < times; ++t) {
+			const double v = value(engine);
+			coo.insert(r, c, v);
+			dense(r, c) += v;
+		}
+	}
+
+	size_t unique = 0;
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t c = 0; c < cols; ++c) { unique += 0.0 != dense(r, c) ? 1 : 0; }
+	}
+
+	const csr_type csr(coo);
+	const csc_type csc(coo);
+
+	bool good = true;
+	const double tolerance = 1e-12;
+	std::printf("%llu triplets, %llu distinct entries, %llu in CSR, %llu in CSC\n", (unsigned long long) coo.nnz(),
+	            (unsigned long long) unique, (unsigned long long) csr.nnz(), (unsigned long long) csc.nnz());
+	good = unique == csr.nnz() && unique == csc.nnz() && good;
+
+	good = report("CSR from triplets", max_error(csr, dense), tolerance) && good;
+	good = report("CSC from triplets", max_error(csc, dense), tolerance) && good;
+	good = report("CSR to CSC", max_error(csr.to_csc(), dense), tolerance) && good;
+	good = report("CSC to CSR", max_error(csc.to_csr(), dense), tolerance) && good;
+
+	sequence_type x(cols, 0.0), z(rows, 0.0);
+	for (size_t c = 0; c < cols; ++c) { x[c] = value(engine); }
+	for (size_t r = 0; r < rows; ++r) { z[r] = value(engine); }
+
+	sequence_type ax(rows, 0.0), atz(cols, 0.0);
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t c = 0; c < cols; ++c) { ax[r] += dense(r, c) * x[c]; atz[c] += dense(r, c) * z[r]; }
+	}
+	good = report("spmv on CSR", max_error(tools::spmv(csr, x), ax), tolerance) && good;
+	good = report("spmv on CSC", max_error(tools::spmv(csc, x), ax), tolerance) && good;
+	good = report("spmv_transposed", max_error(tools::spmv_transposed(csc, z), atz), tolerance) && good;
+
+	dense_type b(cols, 5), d(rows, 5);
+	for (size_t i = 0; i < cols; ++i) { for (size_t j = 0; j < 5; ++j) { b(i, j) = value(engine); } }
+	for (size_t i = 0; i < rows; ++i) { for (size_t j = 0; j < 5; ++j) { d(i, j) = value(engine); } }
+	good = report("spmm", max_error(tools::spmm(csr, b), multiply(dense, b, false)), tolerance) && good;
+	good = report("spmm_transposed", max_error(tools::spmm_transposed(csc, d), multiply(dense, d, true)), tolerance) && good;
+
+	/* sparse samples: dot of a row with a math::vector, and spmv with the same weights as a sequence */
+	param dense_theta = param();
+	for (size_t i = 0; i < features; ++i) { dense_theta[i] = value(engine); }
+
+	coo_type sample_coo(2000, features);
+	sequence_type labels(2000, 0.0);
+	for (size_t r = 0; r < 2000; ++r) {
+		for (size_t i = 0; i < features; ++i) {
+			if (0 == engine() % 4) { sample_coo.insert(r, i, value(engine)); }
+		}
+	}
+	const csr_type sample_csr(sample_coo);
+
+	double dot_error = 0.0;
+	for (size_t r = 0; r < sample_csr.rows(); ++r) {
+		double expected = 0.0;
+		for (size_t i = 0; i < features; ++i) { expected += sample_csr(r, i) * dense_theta[i]; }
+		labels[r] = expected;
+		dot_error = std::max(dot_error, std::abs(tools::dot(sample_csr.row(r), dense_theta) - expected));
+	}
+	good = report("dot with math::vector", dot_error, tolerance) && good;
+	sequence_type theta_sequence(features, 0.0);
+	for (size_t i = 0; i < features; ++i) { theta_sequence[i] = dense_theta[i]; }
+	good = report("spmv against labels", max_error(tools::spmv(sample_csr, theta_sequence), labels), tolerance) && good;
+
+	/* the labels are exact, so gradient descent over the sparse rows has to find the weights */
+	tools::sequence<sample> samples;
+	size_t r = 0;
+	for (auto row : sample_csr) { samples.push_back(sample(row, labels[r++])); }
+
+	sparse_least_squares optimizer(2.0);
+	param theta = param();
+	for (size_t epoch = 0; epoch < 2000; ++epoch) { optimizer.optimize(theta, samples.begin(), samples.end()); }
+
+	double weight_error = 0.0;
+	for (size_t i = 0; i < features; ++i) { weight_error = std::max(weight_error, std::abs(theta[i] - dense_theta[i])); }
+	good = report("gradient_descent weights", weight_error, 1e-6) && good;
+
+	/* one sparse step moves exactly the coordinates of the sample's non-zeros */
+	const sample& first = samples[0];
+	param stepped = theta;
+	stepped[first.first.indices[0]] += 1.0;
+	const param before = stepped;
+	sparse_least_squares(0.1).optimize_sparse(stepped, first, sparse_residual());
+	size_t moved = 0, moved_outside = 0;
+	for (size_t i = 0; i < features; ++i) {
+		if (before[i] == stepped[i]) { continue; }
+		++moved;
+		moved_outside += 0.0 == first.first[i] ? 1 : 0;
+	}
+	std::printf("%-26s %llu of %llu non-zeros moved, %llu others\n", "optimize_sparse step",
+	            (unsigned long long) moved, (unsigned long long) first.first.nnz, (unsigned long long) moved_outside);
+	good = 0 < moved && 0 == moved_outside && good;
+
+	/* and sequential sparse SGD alone finds the weights too */
+	sparse_least_squares sgd(0.5);
+	param sgd_theta = param();
+	for (size_t epoch = 0; epoch < 300; ++epoch) {
+		for (auto& s : samples) { sgd.optimize_sparse(sgd_theta, s, sparse_residual()); }
+	}
+	double sgd_error = 0.0;
+	for (size_t i = 0; i < features; ++i) { sgd_error = std::max(sgd_error, std::abs(sgd_theta[i] - dense_theta[i])); }
+	good = report("optimize_sparse weights", sgd_error, 1e-6) && good;
+
+	/* CSC SpMV sums every y[r] in column order, so a matrix tall enough to be split into row blocks matches the serial scatter exactly */
+	coo_type tall_coo(20 * tools::_sparse_grain, 300);
+	for (size_t e = 0; e < 60000; ++e) { tall_coo.insert(engine() % tall_coo.rows(), engine() % tall_coo.cols(), value(engine)); }
+	const csc_type tall(tall_coo);
+	sequence_type tall_x(tall.cols(), 0.0);
+	for (size_t c = 0; c < tall.cols(); ++c) { tall_x[c] = value(engine); }
+
+	const sequence_type blocked = tools::spmv(tall, tall_x);
+	sequence_type serial(tall.rows(), 0.0);
+	for (size_t c = 0; c < tall.cols(); ++c) {
+		const auto col = tall.column(c);
+		for (size_t i = 0; i < col.nnz; ++i) { serial[col.indices[i]] += col.values[i] * tall_x[c]; }
+	}
+	bool identical = blocked.size() == serial.size();
+	for (size_t i = 0; identical && i < serial.size(); ++i) { identical = blocked[i] == serial[i]; }
+	good = report("spmv on CSC, row blocks", identical ? 0.0 : 1.0, 0.0) && good;
+
+	return good ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+/*
+ * Created by Maou Lim on 2019/7/29.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/trace.h"
+#include "../container/hashtable.h"
+#include "../container/matrix.h"
+#include "../ml/decision_tree.h"
+#include "../ml/gbdt.h"
+#include "../ml/optimizer.h"
+
+typedef int                       value_type;
+typedef tools::matrix<value_type> sample_space;
+typedef std::pair<double, double> sample;
+
+struct squared_error_gradient {
+	double operator()(double theta, const sample& s) const { return (theta * s.first - s.second) * s.first; }
+};
+
+/* rows of `attrs` attributes of 8 values, labels from a noisy rule */
+sample_space make_dataset(size_t rows, size_t attrs, std::mt19937_64& engine) {
+	std::uniform_int_distribution<int> value(0, 7);
+	sample_space data(rows, attrs + 1);
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t c = 0; c < attrs; ++c) { data(r, c) = value(engine); }
+		data(r, attrs) = (data(r, 0) + 2 * data(r, 1) + (0 == value(engine) ? 1 : 0)) % 3;
+	}
+	return data;
+}
+
+/* how many events of each name the trace at path holds, by scanning it */
+std::map<std::string, size_t> count_events(const std::string& path) {
+	std::ifstream stream(path);
+	const std::string text((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+	std::map<std::string, size_t> counts;
+	const std::string key = "{\"name\": \"";
+	for (size_t at = text.find(key); std::string::npos != at; at = text.find(key, at)) {
+		at += key.size();
+		++counts[text.substr(at, text.find('"', at) - at)];
+	}
+	return counts;
+}
+
+/**
+ * @note test_tracing [rows] [trace file], traces a decision tree, a
+ *       boosted model, a batched gradient and container growth, then
+ *       writes them to the file for chrome://tracing or Perfetto.
+ */
+int main(int argc, char* argv[]) {
+	typedef std::chrono::steady_clock clock_type;
+
+	const size_t rows = 1 < argc ? (size_t) std::atoll(argv[1]) : 200000;
+	const std::string path = 2 < argc ? argv[2] : "trace.json";
+
+	/* what a probe costs, recorded then dropped so it does not crowd the ring */
+	const size_t probes = 1000000;
+	const auto start = clock_type::now();
+	for (size_t i = 0; i < probes; ++i) { TOOLS_TRACE_SCOPE("probe"); }
+	const double probe_ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / probes;
+	tools::trace_clear();
+	std::cout << "a probe costs " << probe_ns << " ns" << std::endl;
+
+	std::mt19937_64 engine(2019);
+	const sample_space data = make_dataset(rows, 8, engine);
+
+	ml::decision_tree<value_type, value_type> tree;
+	tree.set_threads(4);
+	tree.build(data);
+
+	sample_space x(rows, 8);
+	std::vector<double> y(rows);
+	for (size_t r = 0; r < rows; ++r) {
+		for (size_t c = 0; c < 8; ++c) { x(r, c) = data(r, c); }
+		y[r] = data(r, 8);
+	}
+	ml::gbdt<double> model;
+	model.set_rounds(4);
+	model.set_threads(4);
+	model.train(x, y);
+
+	std::vector<sample> samples(rows);
+	for (auto& each : samples) { each.first = (double) (engine() % 100) / 100; each.second = 3.0 * each.first; }
+	ml::batched_gradient_descent<double, sample, squared_error_gradient> optimizer(0.5, squared_error_gradient(), 4);
+	double theta = 0.0;
+	for (size_t epoch = 0; epoch < 8; ++epoch) { optimizer.optimize(theta, samples.begin(), samples.end()); }
+
+	tools::sequence<int> sequence;
+	tools::_hashtable<int, int, std::hash<int>, tools::identity<int>, tools::equal_to<int>, std::allocator<int>> table(
+		16, std::hash<int>(), tools::equal_to<int>()
+	);
+	for (size_t i = 0; i < rows; ++i) { sequence.push_back((int) i); table.insert_unique((int) i); }
+
+	if (!tools::trace_flush(path)) {
+		std::cout << "tracing is compiled out or " << path << " cannot be written" << std::endl;
+		return 1;
+	}
+
+	const std::map<std::string, size_t> counts = count_events(path);
+	for (auto& each : counts) { std::cout << each.first << "\t" << each.second << std::endl; }
+
+	bool good = 0 == counts.count("probe");
+	for (const char* name : {
+		"decision_tree::_grow", "decision_tree::_fill", "decision_tree::_max_gain_attr", "gbdt::round",
+		"gbdt::_fill", "batched_gradient_descent::_delta", "sequence::_extend", "hashtable::resize"
+	}) {
+		if (0 == counts.count(name)) { std::cout << "no " << name << " in the trace" << std::endl; good = false; }
+	}
+	std::cout << "theta " << theta << ", trace written to " << path << std::endl;
+	return good ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+/*
+ * Created by Maou Lim on 2019/7/6.
+ */
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+#include "../math/math_common.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+static std::mt19937_64 rand_engine(2019);
+
+inline std::int64_t ordered_bits(double x) {
+	std::int64_t bits;
+	std::memcpy(&bits, &x, sizeof (double));
+	return bits < 0 ? INT64_MIN - bits : bits;
+}
+
+inline double ulp_distance(double a, double b) {
+	if (a == b || (a != a && b != b)) { return 0.0; }
+	return std::fabs((double) (ordered_bits(a) - ordered_bits(b)));
+}
+
+inline double relative_error(double a, double b) {
+	if (a == b || (a != a && b != b)) { return 0.0; }
+	return std::fabs(a - b) / std::fabs(b);
+}
+
+template <typename _Kernel, typename _Reference>
+void report(
+	const char*                name,
+	const std::vector<double>& inputs,
+	_Kernel                    kernel,
+	_Reference                 reference
+) {
+	const size_t n = inputs.size();
+	std::vector<double> fast(n), exact(n);
+
+	auto start = clock_type::now();
+	kernel(inputs.data(), n, fast.data());
+	double fast_ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+
+	start = clock_type::now();
+	for (size_t i = 0; i < n; ++i) { exact[i] = reference(inputs[i]); }
+	double libm_ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+
+	double max_ulp = 0.0, max_rel = 0.0;
+	for (size_t i = 0; i < n; ++i) {
+		if (std::fabs(exact[i]) < std::numeric_limits<double>::min()) { continue; }
+		max_ulp = std::max(max_ulp, ulp_distance(fast[i], exact[i]));
+		max_rel = std::max(max_rel, relative_error(fast[i], exact[i]));
+	}
+
+	std::cout << name
+	          << "\tmax ulp: " << max_ulp
+	          << "\tmax rel: " << max_rel
+	          << "\tvectorized: " << fast_ms << " ms"
+	          << "\tlibm: " << libm_ms << " ms"
+	          << "\tspeedup: " << libm_ms / fast_ms << std::endl;
+}
+
+int main() {
+	const size_t n = 10000000;
+
+	std::uniform_real_distribution<double> rand_exp(-745.0, 709.0);
+	std::uniform_real_distribution<double> rand_small(-20.0, 20.0);
+	std::uniform_real_distribution<double> rand_exponent(-1070.0, 1023.0);
+	std::uniform_real_distribution<double> rand_mantissa(1.0, 2.0);
+
+	std::vector<double> exp_inputs(n), log_inputs(n), small_inputs(n);
+	for (size_t i = 0; i < n; ++i) {
+		exp_inputs[i]   = rand_exp(rand_engine);
+		log_inputs[i]   = std::ldexp(rand_mantissa(rand_engine), (int) rand_exponent(rand_engine));
+		small_inputs[i] = rand_small(rand_engine);
+	}
+
+	auto libm_sigmoid = [](double x) { return math::sigmoid(x); };
+	auto libm_exp     = [](double x) { return std::exp(x); };
+	auto libm_log     = [](double x) { return std::log(x); };
+	auto libm_tanh    = [](double x) { return std::tanh(x); };
+
+	std::cout << "precision::accurate" << std::endl;
+	report("exp", exp_inputs, [](const double* s, size_t k, double* d) { math::exp(s, k, d); }, libm_exp);
+	report("log", log_inputs, [](const double* s, size_t k, double* d) { math::log(s, k, d); }, libm_log);
+	report("sigmoid", small_inputs, [](const double* s, size_t k, double* d) { math::sigmoid(s, k, d); }, libm_sigmoid);
+	report("tanh", small_inputs, [](const double* s, size_t k, double* d) { math::tanh(s, k, d); }, libm_tanh);
+
+	std::cout << "precision::fast" << std::endl;
+	report("exp", exp_inputs, [](const double* s, size_t k, double* d) { math::exp<math::precision::fast>(s, k, d); }, libm_exp);
+	report("log", log_inputs, [](const double* s, size_t k, double* d) { math::log<math::precision::fast>(s, k, d); }, libm_log);
+	report("sigmoid", small_inputs, [](const double* s, size_t k, double* d) { math::sigmoid<math::precision::fast>(s, k, d); }, libm_sigmoid);
+	report("tanh", small_inputs, [](const double* s, size_t k, double* d) { math::tanh<math::precision::fast>(s, k, d); }, libm_tanh);
+
+	math::vector<double, 5> logits { 1.0, 2.0, 3.0, 4.0, 5.0 };
+	auto probs = math::softmax(logits);
+	std::cout << "softmax:";
+	for (size_t i = 0; i < 5; ++i) { std::cout << " " << probs[i]; }
+	std::cout << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Created by Maou Lim on 2019/7/26.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <random>
+#include <vector>
+
+#include "../ml/candidate_elimination.h"
+
+typedef int                    value_type;
+typedef ml::sample<value_type> sample_type;
+typedef ml::constraint<value_type> rule_type;
+
+/* the version space on rule vectors, as it was before the rules were packed and G was deduplicated */
+class vector_space {
+public:
+	explicit vector_space(const ml::meta<value_type>& limit) : m_limit(limit) {
+		m_special.emplace_back(limit.size(), ml::meta_info<value_type>::nil);
+		m_general.emplace_back(limit.size(), ml::meta_info<value_type>::all);
+	}
+
+	void fit(const sample_type& s) {
+		if (s.second) {
+			m_general.remove_if([&s](const rule_type& r) { return !ml::consistent(r, s.first); });
+			for (auto& each : m_special) { ml::do_if_mismatch(each, s.first, &generalize); }
+			m_special.remove_if([this](const rule_type& r) {
+				for (auto& each : m_general) { if (ml::general_than(each, r)) { return false; } }
+				return true;
+			});
+			return;
+		}
+
+		m_special.remove_if([&s](const rule_type& r) { return ml::consistent(r, s.first); });
+
+		std::list<rule_type> tmp;
+		for (auto& each : m_general) {
+			if (!ml::consistent(each, s.first)) { tmp.emplace_back(std::move(each)); continue; }
+			for (size_t i = 0; i < m_limit.size(); ++i) {
+				if (ml::meta_info<value_type>::all != each[i]) { continue; }
+				for (value_type e = 0; e < m_limit[i]; ++e) {
+					if (s.first[i] == e) { continue; }
+					rule_type r(each); r[i] = e;
+					tmp.emplace_back(std::move(r));
+				}
+			}
+		}
+		m_general.swap(tmp);
+		m_general.remove_if([this](const rule_type& r) {
+			for (auto& each : m_special) { if (ml::general_than(r, each)) { return false; } }
+			return true;
+		});
+	}
+
+	const std::list<rule_type>& general_rules() const { return m_general; }
+	const std::list<rule_type>& special_rules() const { return m_special; }
+
+private:
+	static value_type generalize(const value_type& constraint, const value_type& candidate) {
+		if (ml::meta_info<value_type>::nil == constraint) { return candidate; }
+		return ml::meta_info<value_type>::all;
+	}
+
+	ml::meta<value_type> m_limit;
+	std::list<rule_type> m_general;
+	std::list<rule_type> m_special;
+};
+
+/* uniform candidates, positive when the first `fixed` attributes are 0 */
+std::vector<sample_type> make_samples(size_t count, const ml::meta<value_type>& limit, size_t fixed, std::mt19937_64& engine) {
+	std::vector<sample_type> samples(count);
+	for (size_t k = 0; k < count; ++k) {
+		auto& each = samples[k];
+		each.first.resize(limit.size());
+		for (size_t i = 0; i < limit.size(); ++i) { each.first[i] = (value_type) (engine() % limit[i]); }
+
+		/* every other one is made positive so both boundaries keep moving */
+		if (0 == k % 2) { for (size_t i = 0; i < fixed; ++i) { each.first[i] = 0; } }
+
+		each.second = true;
+		for (size_t i = 0; i < fixed; ++i) { each.second = each.second && 0 == each.first[i]; }
+	}
+	return samples;
+}
+
+/* the same G up to duplicates and rules covered by others the reference keeps */
+bool same_general(const std::list<rule_type>& general, const std::list<rule_type>& reference) {
+	for (auto& r : general) {
+		if (reference.end() == std::find(reference.begin(), reference.end(), r)) { return false; }
+	}
+	for (auto& r : reference) {
+		bool covered = false;
+		for (auto& g : general) { if (ml::general_than(g, r)) { covered = true; break; } }
+		if (!covered) { return false; }
+	}
+	return true;
+}
+
+template <typename _Op>
+double seconds(_Op op) {
+	typedef std::chrono::steady_clock clock_type;
+	const auto start = clock_type::now();
+	op();
+	return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+/* classify on rule vectors then on the packed version space with up to `most` threads, true when they vote the same */
+bool classify_both(ml::version_space<value_type>& space, const std::vector<ml::candidate<value_type>>& candidates, size_t most) {
+	const std::list<rule_type> special = space.special_rules(), general = space.general_rules();
+	const size_t count = candidates.size();
+
+	std::vector<ml::vote> votes(count);
+	const double vector_classify = seconds([&]() {
+		for (size_t k = 0; k < count; ++k) {
+			bool positive = !special.empty(), negative = true;
+			for (auto& r : special) { positive = positive && ml::consistent(r, candidates[k]); }
+			for (auto& r : general) { negative = negative && !ml::consistent(r, candidates[k]); }
+			votes[k] = positive ? ml::vote::positive : negative ? ml::vote::negative : ml::vote::unknown;
+		}
+	});
+
+	size_t undecided = 0;
+	for (auto each : votes) { undecided += ml::vote::unknown == each ? 1 : 0; }
+	std::cout << "classify	" << general.size() << " general rules, " << undecided << " undecided, "
+	          << count / vector_classify << " candidates/s on vectors" << std::endl;
+
+	bool same = true;
+	for (size_t threads = 1; ; threads = std::min<size_t>(2 * threads, most)) {
+		space.set_threads(threads);
+		std::vector<ml::vote> packed;
+		const double packed_classify = seconds([&]() { packed = space.classify(candidates.begin(), candidates.end()); });
+
+		same = same && packed == votes;
+		std::cout << "\t\t" << threads << " threads, " << count / packed_classify << " candidates/s packed, "
+		          << (packed == votes ? "same" : "DIFFERENT") << " votes" << std::endl;
+
+		if (most == threads) { break; }
+	}
+	return same;
+}
+
+int main(int argc, char* argv[]) {
+	const size_t attributes = 1 < argc ? (size_t) std::atoll(argv[1]) : 64;
+	const size_t count      = 2 < argc ? (size_t) std::atoll(argv[2]) : 20000;
+	const size_t rounds     = 3 < argc ? (size_t) std::atoll(argv[3]) : 6;
+	const size_t fixed      = 3;
+
+	std::mt19937_64 engine(2019);
+	ml::meta<value_type> limit(attributes);
+	for (auto& each : limit) { each = (value_type) (2 + engine() % 6); }
+
+	const std::vector<sample_type> samples = make_samples(count, limit, fixed, engine);
+	std::cout << attributes << " attributes of 2 to 7 values, " << count << " samples" << std::endl;
+
+	/* testing rules against candidates */
+	const ml::rule_layout<value_type> layout(limit);
+	std::vector<rule_type> rules(64);
+	std::vector<ml::packed_rule> packed_rules(rules.size());
+	for (size_t k = 0; k < rules.size(); ++k) {
+		rules[k] = samples[k].first;
+		for (size_t i = 0; i < attributes; ++i) {
+			if (0 != engine() % 8) { rules[k][i] = ml::meta_info<value_type>::all; }
+		}
+		packed_rules[k] = layout.pack(rules[k]);
+	}
+
+	std::vector<ml::packed_rule> packed_samples(count);
+	for (size_t k = 0; k < count; ++k) { packed_samples[k] = layout.pack(samples[k].first); }
+
+	size_t matches = 0, packed_matches = 0;
+	const double vector_test = seconds([&]() {
+		for (auto& s : samples) { for (auto& r : rules) { matches += ml::consistent(r, s.first) ? 1 : 0; } }
+	});
+	const double packed_test = seconds([&]() {
+		for (auto& s : packed_samples) { for (auto& r : packed_rules) { packed_matches += ml::covers(r, s) ? 1 : 0; } }
+	});
+
+	const double tests = (double) count * rules.size();
+	std::cout << "consistent\t" << tests / vector_test << " tests/s on vectors, " << tests / packed_test
+	          << " on " << layout.words() << " packed words (" << matches << " vs " << packed_matches << " matches)" << std::endl;
+
+	/* fitting the whole stream */
+	vector_space reference(limit);
+	ml::version_space<value_type> space(limit);
+	const double vector_fit = seconds([&]() { for (auto& each : samples) { reference.fit(each); } });
+	const double packed_fit = seconds([&]() { for (auto& each : samples) { space.fit(each); } });
+
+	bool same = space.special_rules() == reference.special_rules() &&
+	            same_general(space.general_rules(), reference.general_rules());
+	std::cout << "fit\t\t" << count / vector_fit << " samples/s on vectors, " << count / packed_fit << " packed, "
+	          << space.special_rules().size() << " special and " << space.general_rules().size() << " general rules, "
+	          << (same ? "same" : "DIFFERENT") << " boundaries" << std::endl;
+
+	/* attributes of 64 values and more, whose fields run over two or three words, among narrow ones */
+	const ml::meta<value_type> wide_limit({ 3, 64, 2, 200, 63, 127, 65, 5 });
+	const std::vector<sample_type> wide_samples = make_samples(2000, wide_limit, 2, engine);
+	vector_space wide_reference(wide_limit);
+	ml::version_space<value_type> wide(wide_limit);
+	for (auto& each : wide_samples) { wide_reference.fit(each); wide.fit(each); }
+
+	const bool wide_same = wide.special_rules() == wide_reference.special_rules() &&
+	                       same_general(wide.general_rules(), wide_reference.general_rules());
+	same = same && wide_same;
+	std::cout << "fit		" << wide_limit.size() << " attributes of up to 200 values on " << ml::rule_layout<value_type>(wide_limit).words()
+	          << " packed words, " << (wide_same ? "same" : "DIFFERENT") << " boundaries" << std::endl;
+
+	std::vector<ml::candidate<value_type>> wide_candidates(wide_samples.size());
+	for (size_t k = 0; k < wide_samples.size(); ++k) { wide_candidates[k] = wide_samples[k].first; }
+	ml::version_space<value_type> wide_early(wide_limit);
+	wide_early.fit_all(wide_samples.begin(), wide_samples.begin() + 3);
+	same = classify_both(wide_early, wide_candidates, 1) && same;
+
+	/* one positive, then negatives close to it: G only ever grows, and specializing reaches most rules several times */
+	const ml::meta<value_type> small(limit.begin(), limit.begin() + std::min<size_t>(24, attributes));
+	std::vector<sample_type> negatives(1 + rounds);
+	for (auto v : small) { negatives[0].first.push_back((value_type) (engine() % v)); }
+	negatives[0].second = true;
+	for (size_t k = 1; k < negatives.size(); ++k) {
+		negatives[k] = negatives[0];
+		negatives[k].second = false;
+		for (size_t d = 0; d < 4; ++d) {
+			const size_t i = engine() % small.size();
+			negatives[k].first[i] = (negatives[k].first[i] + 1) % small[i];
+		}
+	}
+
+	vector_space grown(small);
+	const double vector_grow = seconds([&]() { for (auto& each : negatives) { grown.fit(each); } });
+	std::cout << rounds << " negatives\t" << small.size() << " attributes, on vectors " << vector_grow
+	          << " s for " << grown.general_rules().size() << " general rules" << std::endl;
+
+	for (size_t threads = 1; ; threads = std::min<size_t>(2 * threads, tools::concurrency())) {
+		ml::version_space<value_type> deduplicated(small);
+		deduplicated.set_threads(threads);
+		const double packed_grow = seconds([&]() { for (auto& each : negatives) { deduplicated.fit(each); } });
+
+		const bool equal = same_general(deduplicated.general_rules(), grown.general_rules());
+		same = same && equal;
+		std::cout << "\t\t" << threads << " threads, packed " << packed_grow << " s for "
+		          << deduplicated.general_rules().size() << " general rules, " << (equal ? "same" : "DIFFERENT") << std::endl;
+
+		if (tools::concurrency() == threads) { break; }
+	}
+
+	/* the whole stream as one batch, at least up to 4 threads to go through the chunk merge */
+	const size_t most = std::max<size_t>(4, tools::concurrency());
+	for (size_t threads = 1; ; threads = std::min<size_t>(2 * threads, most)) {
+		ml::version_space<value_type> batch(limit);
+		batch.set_threads(threads);
+		const double batch_fit = seconds([&]() { batch.fit_all(samples.begin(), samples.end()); });
+
+		const bool equal = batch.special_rules() == space.special_rules() &&
+		                   same_general(batch.general_rules(), space.general_rules());
+		same = same && equal;
+		std::cout << "fit_all		" << threads << " threads, " << count / batch_fit << " samples/s, "
+		          << (equal ? "same" : "DIFFERENT") << " boundaries as fit" << std::endl;
+
+		if (most == threads) { break; }
+	}
+
+	/* positives after a negative they come to cover: the space collapses whatever the threads */
+	std::vector<sample_type> positives(std::max<size_t>(count, 4 * 4096));
+	for (auto& each : positives) {
+		for (auto v : limit) { each.first.push_back((value_type) (engine() % v)); }
+		each.second = true;
+	}
+	const sample_type zeros(ml::candidate<value_type>(attributes, 0), false), ones(ml::candidate<value_type>(attributes, 1), true);
+	for (size_t threads : { 1, 4 }) {
+		ml::version_space<value_type> earlier(limit);
+		earlier.set_threads(threads);
+		earlier.fit(zeros);
+		earlier.fit(ones);
+		earlier.fit_all(positives.begin(), positives.end());
+
+		const bool collapsed = earlier.special_rules().empty() && earlier.general_rules().empty() &&
+		                       ml::vote::positive != earlier.classify(zeros.first);
+		same = same && collapsed;
+		std::cout << "fit_all		" << threads << " threads after a covered negative, " << earlier.special_rules().size()
+		          << " special and " << earlier.general_rules().size() << " general rules, "
+		          << (collapsed ? "collapsed" : "NOT COLLAPSED") << std::endl;
+	}
+
+	/* classifying against the boundaries after a few samples, where some candidates are still undecided */
+	std::vector<ml::candidate<value_type>> candidates(count);
+	for (size_t k = 0; k < count; ++k) { candidates[k] = samples[(k * 7919) % count].first; }
+
+	/* right after the first negative G holds a rule per other value of every attribute, after 40 samples only a few */
+	for (size_t fitted : { (size_t) 2, (size_t) 40 }) {
+		ml::version_space<value_type> early(limit);
+		early.fit_all(samples.begin(), samples.begin() + std::min<size_t>(fitted, count));
+		same = classify_both(early, candidates, most) && same;
+	}
+
+	return same && matches == packed_matches ? 0 : 1;
+}
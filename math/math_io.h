@@ -1,150 +1,830 @@
 #ifndef _MATH_IO_H_
 #define _MATH_IO_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <ostream>
 #include <string>
-#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "../common/defines.h"
+#include "../common/mapped_file.h"
+#include "../common/parallel.h"
 
 #include "matrix.h"
 
+namespace tools {
+
+	/* declared only, container/matrix.h drags iterator.h along which
+	 * disables the math vector operators */
+	template <typename _Val, typename _Container>
+	class matrix;
+}
+
 namespace math {
 
-	template <
-		typename _Tp, tools::size_t _N
-	>
-	void from_tsv(
-		const std::string& csv_str,
-		vector<_Tp, _N>&   vec
+	/**
+	 * @note Delimiter scanning, 16 bytes per step with SSE2 and byte by
+	 *       byte on the tail or without it.
+	 */
+	inline const char* _find_char(const char* first, const char* last, char c) {
+#ifdef __SSE2__
+		const __m128i pattern = _mm_set1_epi8(c);
+		while (16 <= last - first) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			const int     mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+			if (0 != mask) { return first + __builtin_ctz((unsigned int) mask); }
+			first += 16;
+		}
+#endif
+		while (first != last && c != *first) { ++first; }
+		return first;
+	}
+
+	inline tools::size_t _count_char(const char* first, const char* last, char c) {
+		tools::size_t count = 0;
+#ifdef __SSE2__
+		const __m128i pattern = _mm_set1_epi8(c);
+		while (16 <= last - first) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			count += __builtin_popcount((unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern)));
+			first += 16;
+		}
+#endif
+		for (; first != last; ++first) { count += (c == *first); }
+		return count;
+	}
+
+	inline const char* _skip_blanks(const char* first, const char* last) {
+		while (first != last && (tools::space == *first || '\r' == *first)) { ++first; }
+		return first;
+	}
+
+	inline bool _is_digit(char c) { return '0' <= c && c <= '9'; }
+
+	template <typename _Tp>
+	struct _float_traits;
+
+	template <>
+	struct _float_traits<float> {
+		static constexpr tools::uint64_t max_exact = 1ull << 24;
+		static constexpr int             max_pow10 = 10;
+		static float convert(const char* str, char** end) { return std::strtof(str, end); }
+	};
+
+	template <>
+	struct _float_traits<double> {
+		static constexpr tools::uint64_t max_exact = 1ull << 53;
+		static constexpr int             max_pow10 = 22;
+		static double convert(const char* str, char** end) { return std::strtod(str, end); }
+	};
+
+	template <>
+	struct _float_traits<long double> {
+		static constexpr tools::uint64_t max_exact = 0;
+		static constexpr int             max_pow10 = -1;
+		static long double convert(const char* str, char** end) { return std::strtold(str, end); }
+	};
+
+	/* strto* on a terminated copy of the token, the mapping has none; long ones are copied to the heap */
+	template <typename _Tp>
+	const char* _parse_float_slow(const char* first, const char* last, _Tp& value) {
+		char buffer[128];
+		std::string long_token;
+
+		const tools::size_t length = (tools::size_t) (last - first);
+		char* copy = buffer;
+		if (sizeof(buffer) - 1 < length) {
+			long_token.assign(first, length);
+			copy = &long_token[0];
+		}
+		else {
+			std::memcpy(buffer, first, length);
+			buffer[length] = '\0';
+		}
+
+		char* end = nullptr;
+		const _Tp result = _float_traits<_Tp>::convert(copy, &end);
+		if (end == copy) { return first; }
+
+		value = result;
+		return first + (end - copy);
+	}
+
+	template <typename _Tp>
+	const char* _parse_number(const char* first, const char* last, _Tp& value, std::true_type) {
+		const char* itr = first;
+
+		bool negative = false;
+		if (itr != last && ('-' == *itr || '+' == *itr)) {
+			negative = '-' == *itr; ++itr;
+		}
+		if (negative && !std::is_signed<_Tp>::value) { return first; }
+
+		const char* digits = itr;
+		const tools::uint64_t limit = negative ?
+			(tools::uint64_t) std::numeric_limits<_Tp>::max() + 1 :
+			(tools::uint64_t) std::numeric_limits<_Tp>::max();
+
+		tools::uint64_t result = 0;
+		for (; itr != last && _is_digit(*itr); ++itr) {
+			const tools::uint64_t digit = (tools::uint64_t) (*itr - '0');
+			if ((limit - digit) / 10 < result) { return first; }
+			result = result * 10 + digit;
+		}
+		if (itr == digits) { return first; }
+
+		value = negative ? (_Tp) (0 - result) : (_Tp) result;
+		return itr;
+	}
+
+	/**
+	 * @note Up to 19 significant digits are gathered into an integer.
+	 *       When it and the power of ten are both exact in _Tp a single
+	 *       multiplication or division gives the correctly rounded
+	 *       result (Clinger's fast path), which covers nearly all the
+	 *       numbers printed by programs. Everything else, including
+	 *       nan and inf, goes through strto*.
+	 */
+	template <typename _Tp>
+	const char* _parse_number(const char* first, const char* last, _Tp& value, std::false_type) {
+		static const _Tp pow10[] = {
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+			1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+			1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		const char* itr = first;
+
+		bool negative = false;
+		if (itr != last && ('-' == *itr || '+' == *itr)) {
+			negative = '-' == *itr; ++itr;
+		}
+		const char* body = itr;
+
+		tools::uint64_t mantissa    = 0;
+		int             exponent    = 0;
+		int             significant = 0;
+		bool            truncated   = false;
+		bool            any_digit   = false;
+
+		for (; itr != last && _is_digit(*itr); ++itr) {
+			any_digit = true;
+			if (0 == mantissa && '0' == *itr) { continue; }
+			if (19 <= significant) { truncated = true; ++exponent; continue; }
+			mantissa = mantissa * 10 + (tools::uint64_t) (*itr - '0'); ++significant;
+		}
+
+		if (itr != last && '.' == *itr) {
+			for (++itr; itr != last && _is_digit(*itr); ++itr) {
+				any_digit = true;
+				if (0 == mantissa && '0' == *itr) { --exponent; continue; }
+				if (19 <= significant) { truncated = true; continue; }
+				mantissa = mantissa * 10 + (tools::uint64_t) (*itr - '0'); ++significant; --exponent;
+			}
+		}
+
+		/* only nan and inf are left to strto*, which would skip whitespace into the next field */
+		if (!any_digit) {
+			if (body == last || ('n' != (*body | 0x20) && 'i' != (*body | 0x20))) { return first; }
+			return _parse_float_slow(first, first + std::min<tools::size_t>(64, (tools::size_t) (last - first)), value);
+		}
+
+		if (itr != last && ('e' == *itr || 'E' == *itr)) {
+			const char* exp_itr = itr + 1;
+
+			bool exp_negative = false;
+			if (exp_itr != last && ('-' == *exp_itr || '+' == *exp_itr)) {
+				exp_negative = '-' == *exp_itr; ++exp_itr;
+			}
+
+			if (exp_itr != last && _is_digit(*exp_itr)) {
+				int exp_value = 0;
+				for (; exp_itr != last && _is_digit(*exp_itr); ++exp_itr) {
+					if (exp_value < 100000) { exp_value = exp_value * 10 + (*exp_itr - '0'); }
+				}
+				exponent += exp_negative ? -exp_value : exp_value;
+				itr = exp_itr;
+			}
+		}
+
+		const int max_pow10 = _float_traits<_Tp>::max_pow10;
+		if (0 == mantissa) {
+			value = negative ? -(_Tp) 0 : (_Tp) 0;
+			return itr;
+		}
+		if (truncated || _float_traits<_Tp>::max_exact < mantissa ||
+			exponent < -max_pow10 || max_pow10 < exponent) {
+			return _parse_float_slow(first, itr, value);
+		}
+
+		_Tp result = (_Tp) mantissa;
+		result = exponent < 0 ? result / pow10[-exponent] : result * pow10[exponent];
+		value = negative ? -result : result;
+		return itr;
+	}
+
+	/**
+	 * @note from_chars-style number parsing: reads one number starting
+	 *       exactly at first and returns the position right after it,
+	 *       or first itself when there is no valid number (or when an
+	 *       integer would overflow). Nothing is allocated or copied.
+	 */
+	template <typename _Tp>
+	const char* parse_number(const char* first, const char* last, _Tp& value) {
+		return _parse_number(first, last, value, std::is_integral<_Tp>());
+	}
+
+	/**
+	 * @note Parses n delimited fields of one row into out[0, n). A
+	 *       trailing delimiter is tolerated. Returns the position of the
+	 *       row's '\n' (or last), nullptr if the row is malformed.
+	 */
+	template <typename _Tp, typename _Output>
+	const char* _parse_row(
+		const char*   first,
+		const char*   last,
+		char          delim,
+		_Output&&     out,
+		tools::size_t n
 	) {
-		// todo
+		for (tools::size_t i = 0; i < n; ++i) {
+			_Tp value;
+			first = _skip_blanks(first, last);
+
+			const char* next = parse_number(first, last, value);
+			if (next == first) { return nullptr; }
+
+			out[i] = value;
+			first  = _skip_blanks(next, last);
+
+			if (i + 1 < n) {
+				if (first == last || delim != *first) { return nullptr; }
+				++first;
+			}
+		}
+
+		if (first != last && delim == *first) { first = _skip_blanks(first + 1, last); }
+		return first == last || tools::ret == *first ? first : nullptr;
 	}
 
-	template <
-		tools::size_t _Length,
-		typename      _Tp,
-		tools::size_t _N
-	>
-	struct _vec_to_tsv_impl;
+	inline bool _blank_line(const char* first, const char* last) {
+		return _skip_blanks(first, last) == last;
+	}
 
-	template <
-		typename      _Tp,
-		tools::size_t _N
-	>
-	std::string to_tsv(const vector<_Tp, _N>& src) {
-		std::stringstream stream;
-		return _vec_to_tsv_impl<
-			_N, _Tp, _N
-		>::element_sprint(stream, src).str();
+	inline bool _blank_text(const char* first, const char* last) {
+		for (; first != last; ++first) {
+			if (tools::space != *first && '\r' != *first && tools::ret != *first) { return false; }
+		}
+		return true;
 	}
 
-	template <
-		tools::size_t _Length,
-		typename      _Tp,
-		tools::size_t _N
-	>
-	struct _vec_to_tsv_impl {
-
-		static std::stringstream& element_sprint(
-			std::stringstream&     stream,
-			const vector<_Tp, _N>& src
-		) {
-			const tools::size_t index = _Length - 1;
-			_vec_to_tsv_impl<
-				index, _Tp, _N
-			>::element_sprint(stream, src) << src[index] << tools::tab;
-			return stream;
+	/* fields in a row, a trailing delimiter does not open a new one */
+	inline tools::size_t _count_fields(const char* first, const char* last, char delim) {
+		while (first != last && (tools::space == last[-1] || '\r' == last[-1])) { --last; }
+		if (first == last) { return 0; }
+
+		const tools::size_t delims = _count_char(first, last, delim);
+		return delim == last[-1] ? delims : delims + 1;
+	}
+
+	template <typename _Tp, tools::size_t _N>
+	bool from_tsv(const char* first, const char* last, vector<_Tp, _N>& vec, char delim = tools::tab) {
+		const char* end = _parse_row<_Tp>(first, last, delim, vec, _N);
+		return nullptr != end && _blank_text(end, last);
+	}
+
+	template <typename _Tp, tools::size_t _Rows, tools::size_t _Cols>
+	bool from_tsv(const char* first, const char* last, matrix<_Tp, _Rows, _Cols>& mat, char delim = tools::tab) {
+		for (tools::size_t r = 0; r < _Rows; ++r) {
+			const char* line_end = _find_char(first, last, tools::ret);
+			while (first != last && _blank_line(first, line_end)) {
+				first    = line_end == last ? last : line_end + 1;
+				line_end = _find_char(first, last, tools::ret);
+			}
+			if (first == last) { return false; }
+
+			const char* end = _parse_row<_Tp>(first, last, delim, mat[r], _Cols);
+			if (nullptr == end) { return false; }
+			first = end == last ? last : end + 1;
 		}
+		return _blank_text(first, last);
+	}
+
+	/**
+	 * @note The row starts are located in one SIMD pass over the text,
+	 *       then the rows are parsed straight into the matrix storage
+	 *       in parallel. The column count comes from the first row and
+	 *       every other row must match it. Blank lines are skipped.
+	 */
+	template <typename _Tp, typename _Container>
+	bool from_tsv(const char* first, const char* last, tools::matrix<_Tp, _Container>& mat, char delim = tools::tab) {
+		std::vector<const char*> row_starts;
+		row_starts.reserve(1024);
+
+		tools::size_t cols = 0;
+		while (first != last) {
+			const char* line_end = _find_char(first, last, tools::ret);
+			if (!_blank_line(first, line_end)) {
+				if (row_starts.empty()) { cols = _count_fields(first, line_end, delim); }
+				row_starts.push_back(first);
+			}
+			first = line_end == last ? last : line_end + 1;
+		}
+
+		const tools::size_t rows = row_starts.size();
+		tools::matrix<_Tp, _Container> result(rows, cols);
+
+		std::atomic<bool> valid(true);
+		_Tp* const data = result.data();
+
+		tools::parallel_for(0, rows, 4096, [&](tools::size_t begin, tools::size_t end) {
+			for (tools::size_t r = begin; r < end && valid.load(std::memory_order_relaxed); ++r) {
+				if (nullptr == _parse_row<_Tp>(row_starts[r], last, delim, data + r * cols, cols)) {
+					valid.store(false, std::memory_order_relaxed);
+				}
+			}
+		});
+
+		if (!valid.load()) { return false; }
+
+		mat = std::move(result);
+		return true;
+	}
+
+	template <typename _Target>
+	bool from_tsv(const std::string& tsv_str, _Target& target, char delim = tools::tab) {
+		return from_tsv(tsv_str.data(), tsv_str.data() + tsv_str.size(), target, delim);
+	}
+
+	template <typename _Target>
+	bool from_csv(const std::string& csv_str, _Target& target) {
+		return from_tsv(csv_str, target, ',');
+	}
+
+	/* parses the file in place through a read-only mapping */
+	template <typename _Target>
+	bool load_tsv(const std::string& path, _Target& target, char delim = tools::tab) {
+		tools::mapped_file file;
+		if (!file.open(path)) { return false; }
+		return from_tsv(file.begin(), file.end(), target, delim);
+	}
+
+	template <typename _Target>
+	bool load_csv(const std::string& path, _Target& target) {
+		return load_tsv(path, target, ',');
+	}
+
+	/**
+	 * @note Shortest round-trip float formatting after Grisu2 (Loitsch,
+	 *       "Printing floating-point numbers quickly and accurately with
+	 *       integers", 2010). The value and the bounds of its rounding
+	 *       interval are scaled by a cached power of ten into 64 bit
+	 *       integers, and digits are generated until they fall inside
+	 *       the interval, so they always read back to the value. Rarely
+	 *       one digit longer than the shortest; no snprintf, no re-parse.
+	 */
+	struct _diy_fp {
+		tools::uint64_t f;
+		int             e;
 	};
 
-	template <
-		typename      _Tp,
-		tools::size_t _N
-	>
-	struct _vec_to_tsv_impl<0, _Tp, _N> {
+	/* the upper half of the 128 bit product, rounded */
+	inline _diy_fp _diy_mul(_diy_fp x, _diy_fp y) {
+		const tools::uint64_t a = x.f >> 32, b = x.f & 0xffffffffu;
+		const tools::uint64_t c = y.f >> 32, d = y.f & 0xffffffffu;
+		const tools::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+		const tools::uint64_t mid = (bd >> 32) + (ad & 0xffffffffu) + (bc & 0xffffffffu) + (1ull << 31);
+		return { ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64 };
+	}
 
-		static std::stringstream& element_sprint(
-			std::stringstream& stream, const vector<_Tp, _N>&
-		) { return stream; }
+	inline _diy_fp _diy_normalize(_diy_fp x) {
+		const int shift = __builtin_clzll(x.f);
+		return { x.f << shift, x.e - shift };
+	}
+
+	/* a positive finite value with the midpoints to its neighbours, all in the exponent of the upper one */
+	template <typename _Tp>
+	void _float_boundaries(_Tp value, _diy_fp& minus, _diy_fp& w, _diy_fp& plus) {
+		typedef typename std::conditional<4 == sizeof(_Tp), tools::uint32_t, tools::uint64_t>::type bits_type;
+
+		const int             precision = std::numeric_limits<_Tp>::digits;
+		const int             bias      = std::numeric_limits<_Tp>::max_exponent - 1 + (precision - 1);
+		const tools::uint64_t hidden    = 1ull << (precision - 1);
+
+		bits_type bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const tools::uint64_t exponent = (tools::uint64_t) bits >> (precision - 1);
+		const tools::uint64_t fraction = (tools::uint64_t) bits & (hidden - 1);
+
+		const _diy_fp v = 0 == exponent ?
+			_diy_fp { fraction, 1 - bias } : _diy_fp { fraction + hidden, (int) exponent - bias };
+
+		/* at a power of two the neighbour below is half as far as the one above */
+		const _diy_fp lower = 0 == fraction && 1 < exponent ?
+			_diy_fp { 4 * v.f - 1, v.e - 2 } : _diy_fp { 2 * v.f - 1, v.e - 1 };
+
+		plus  = _diy_normalize({ 2 * v.f + 1, v.e - 1 });
+		minus = { lower.f << (lower.e - plus.e), plus.e };
+		w     = _diy_normalize(v);
+	}
+
+	struct _cached_power {
+		tools::uint64_t f;
+		int             e;
+		int             k;
 	};
 
-	template <
-		tools::size_t _Length,
-		typename      _Tp,
-		tools::size_t _Rows,
-		tools::size_t _Cols
-	>
-	struct _mat_to_tsv_impl;
+	/* 10^k for k = -300, -292, ..., 340, rounded to 64 bits */
+	inline const _cached_power& _cached_power_for(int e) {
+		static const _cached_power powers[] = {
+			{ 0xAB70FE17C79AC6CAull, -1060, -300 },
+			{ 0xFF77B1FCBEBCDC4Full, -1034, -292 },
+			{ 0xBE5691EF416BD60Cull, -1007, -284 },
+			{ 0x8DD01FAD907FFC3Cull,  -980, -276 },
+			{ 0xD3515C2831559A83ull,  -954, -268 },
+			{ 0x9D71AC8FADA6C9B5ull,  -927, -260 },
+			{ 0xEA9C227723EE8BCBull,  -901, -252 },
+			{ 0xAECC49914078536Dull,  -874, -244 },
+			{ 0x823C12795DB6CE57ull,  -847, -236 },
+			{ 0xC21094364DFB5637ull,  -821, -228 },
+			{ 0x9096EA6F3848984Full,  -794, -220 },
+			{ 0xD77485CB25823AC7ull,  -768, -212 },
+			{ 0xA086CFCD97BF97F4ull,  -741, -204 },
+			{ 0xEF340A98172AACE5ull,  -715, -196 },
+			{ 0xB23867FB2A35B28Eull,  -688, -188 },
+			{ 0x84C8D4DFD2C63F3Bull,  -661, -180 },
+			{ 0xC5DD44271AD3CDBAull,  -635, -172 },
+			{ 0x936B9FCEBB25C996ull,  -608, -164 },
+			{ 0xDBAC6C247D62A584ull,  -582, -156 },
+			{ 0xA3AB66580D5FDAF6ull,  -555, -148 },
+			{ 0xF3E2F893DEC3F126ull,  -529, -140 },
+			{ 0xB5B5ADA8AAFF80B8ull,  -502, -132 },
+			{ 0x87625F056C7C4A8Bull,  -475, -124 },
+			{ 0xC9BCFF6034C13053ull,  -449, -116 },
+			{ 0x964E858C91BA2655ull,  -422, -108 },
+			{ 0xDFF9772470297EBDull,  -396, -100 },
+			{ 0xA6DFBD9FB8E5B88Full,  -369,  -92 },
+			{ 0xF8A95FCF88747D94ull,  -343,  -84 },
+			{ 0xB94470938FA89BCFull,  -316,  -76 },
+			{ 0x8A08F0F8BF0F156Bull,  -289,  -68 },
+			{ 0xCDB02555653131B6ull,  -263,  -60 },
+			{ 0x993FE2C6D07B7FACull,  -236,  -52 },
+			{ 0xE45C10C42A2B3B06ull,  -210,  -44 },
+			{ 0xAA242499697392D3ull,  -183,  -36 },
+			{ 0xFD87B5F28300CA0Eull,  -157,  -28 },
+			{ 0xBCE5086492111AEBull,  -130,  -20 },
+			{ 0x8CBCCC096F5088CCull,  -103,  -12 },
+			{ 0xD1B71758E219652Cull,   -77,   -4 },
+			{ 0x9C40000000000000ull,   -50,    4 },
+			{ 0xE8D4A51000000000ull,   -24,   12 },
+			{ 0xAD78EBC5AC620000ull,     3,   20 },
+			{ 0x813F3978F8940984ull,    30,   28 },
+			{ 0xC097CE7BC90715B3ull,    56,   36 },
+			{ 0x8F7E32CE7BEA5C70ull,    83,   44 },
+			{ 0xD5D238A4ABE98068ull,   109,   52 },
+			{ 0x9F4F2726179A2245ull,   136,   60 },
+			{ 0xED63A231D4C4FB27ull,   162,   68 },
+			{ 0xB0DE65388CC8ADA8ull,   189,   76 },
+			{ 0x83C7088E1AAB65DBull,   216,   84 },
+			{ 0xC45D1DF942711D9Aull,   242,   92 },
+			{ 0x924D692CA61BE758ull,   269,  100 },
+			{ 0xDA01EE641A708DEAull,   295,  108 },
+			{ 0xA26DA3999AEF774Aull,   322,  116 },
+			{ 0xF209787BB47D6B85ull,   348,  124 },
+			{ 0xB454E4A179DD1877ull,   375,  132 },
+			{ 0x865B86925B9BC5C2ull,   402,  140 },
+			{ 0xC83553C5C8965D3Dull,   428,  148 },
+			{ 0x952AB45CFA97A0B3ull,   455,  156 },
+			{ 0xDE469FBD99A05FE3ull,   481,  164 },
+			{ 0xA59BC234DB398C25ull,   508,  172 },
+			{ 0xF6C69A72A3989F5Cull,   534,  180 },
+			{ 0xB7DCBF5354E9BECEull,   561,  188 },
+			{ 0x88FCF317F22241E2ull,   588,  196 },
+			{ 0xCC20CE9BD35C78A5ull,   614,  204 },
+			{ 0x98165AF37B2153DFull,   641,  212 },
+			{ 0xE2A0B5DC971F303Aull,   667,  220 },
+			{ 0xA8D9D1535CE3B396ull,   694,  228 },
+			{ 0xFB9B7CD9A4A7443Cull,   720,  236 },
+			{ 0xBB764C4CA7A44410ull,   747,  244 },
+			{ 0x8BAB8EEFB6409C1Aull,   774,  252 },
+			{ 0xD01FEF10A657842Cull,   800,  260 },
+			{ 0x9B10A4E5E9913129ull,   827,  268 },
+			{ 0xE7109BFBA19C0C9Dull,   853,  276 },
+			{ 0xAC2820D9623BF429ull,   880,  284 },
+			{ 0x80444B5E7AA7CF85ull,   907,  292 },
+			{ 0xBF21E44003ACDD2Dull,   933,  300 },
+			{ 0x8E679C2F5E44FF8Full,   960,  308 },
+			{ 0xD433179D9C8CB841ull,   986,  316 },
+			{ 0x9E19DB92B4E31BA9ull,  1013,  324 },
+			{ 0xEB96BF6EBADF77D9ull,  1039,  332 },
+			{ 0xAF87023B9BF0EE6Bull,  1066,  340 }
+		};
 
-	template <
-		typename      _Tp,
-		tools::size_t _Rows,
-		tools::size_t _Cols
-	>
-	std::string to_tsv(const matrix<_Tp, _Rows, _Cols>& mat) {
-		std::stringstream stream;
-		return _mat_to_tsv_impl<
-			_Rows * _Cols, _Tp, _Rows, _Cols
-		>::element_sprint(stream, mat).str();
+		/* the k that brings the product's exponent into [-60, -32] */
+		const int f = -61 - e;
+		const int k = (f * 78913) / (1 << 18) + (0 < f ? 1 : 0);
+		return powers[(300 + k + 7) / 8];
 	}
 
-	template <
-		tools::size_t _Length,
-		typename      _Tp,
-		tools::size_t _Rows,
-		tools::size_t _Cols
-	>
-	struct _mat_to_tsv_impl {
-
-		static std::stringstream& element_sprint(
-			std::stringstream&               stream,
-			const matrix<_Tp, _Rows, _Cols>& src
-		) {
-			const tools::size_t rid = (_Length - 1) / _Cols;
-			const tools::size_t cid = (_Length - 1) % _Cols;
-
-			_mat_to_tsv_impl<
-				_Length - 1, _Tp, _Rows, _Cols
-			>::element_sprint(stream, src)
-				<< src(rid, cid)
-			    << (cid + 1 == _Cols ? tools::ret : tools::tab);
-			return stream;
+	inline void _round_last_digit(
+		char*           digits,
+		int             length,
+		tools::uint64_t distance,
+		tools::uint64_t delta,
+		tools::uint64_t rest,
+		tools::uint64_t ten_k
+	) {
+		while (rest < distance && ten_k <= delta - rest &&
+			   (rest + ten_k < distance || rest + ten_k - distance < distance - rest)) {
+			--digits[length - 1];
+			rest += ten_k;
 		}
-	};
+	}
 
-	template <
-		typename      _Tp,
-		tools::size_t _Rows,
-		tools::size_t _Cols
-	>
-	struct _mat_to_tsv_impl<0, _Tp, _Rows, _Cols> {
+	/* digits of hi until what is left lies within hi - lo, returns how many */
+	inline int _generate_digits(char* digits, int& exponent, _diy_fp lo, _diy_fp w, _diy_fp hi) {
+		tools::uint64_t delta    = hi.f - lo.f;
+		tools::uint64_t distance = hi.f - w.f;
+
+		const int             shift = -hi.e;
+		const tools::uint64_t one   = 1ull << shift;
+
+		tools::uint32_t integral = (tools::uint32_t) (hi.f >> shift);
+		tools::uint64_t fraction = hi.f & (one - 1);
+
+		tools::uint32_t pow10 = 1;
+		int             n     = 1;
+		while (n < 10 && pow10 * 10 <= integral) { pow10 *= 10; ++n; }
+
+		int length = 0;
+		while (0 < n) {
+			digits[length++] = (char) ('0' + integral / pow10);
+			integral %= pow10;
+			--n;
+
+			const tools::uint64_t rest = ((tools::uint64_t) integral << shift) + fraction;
+			if (rest <= delta) {
+				exponent += n;
+				_round_last_digit(digits, length, distance, delta, rest, (tools::uint64_t) pow10 << shift);
+				return length;
+			}
+			pow10 /= 10;
+		}
+
+		int m = 0;
+		do {
+			fraction *= 10;
+			digits[length++] = (char) ('0' + (fraction >> shift));
+			fraction &= one - 1;
+			delta    *= 10;
+			distance *= 10;
+			++m;
+		} while (delta < fraction);
+
+		exponent -= m;
+		_round_last_digit(digits, length, distance, delta, fraction, one);
+		return length;
+	}
+
+	/* value = digits * 10^exponent, value positive and finite */
+	template <typename _Tp>
+	int _shortest_digits(_Tp value, char* digits, int& exponent) {
+		_diy_fp minus, w, plus;
+		_float_boundaries(value, minus, w, plus);
+
+		const _cached_power& power = _cached_power_for(plus.e);
+		const _diy_fp scale = { power.f, power.e };
+
+		/* the products may be off by one unit, so both bounds move one inwards */
+		const _diy_fp lo = _diy_mul(minus, scale), hi = _diy_mul(plus, scale);
+		exponent = -power.k;
+		return _generate_digits(digits, exponent, { lo.f + 1, lo.e }, _diy_mul(w, scale), { hi.f - 1, hi.e });
+	}
 
-		static std::stringstream& element_sprint(
-			std::stringstream&               stream,
-			const matrix<_Tp, _Rows, _Cols>& src
-		) { return stream; }
+	/**
+	 * @note Buffered text writer. Numbers are formatted into a local
+	 *       buffer (integers by hand, float and double with the shortest
+	 *       digits that read back exactly, long double with snprintf)
+	 *       and handed to the stream in large blocks. Without a stream
+	 *       the text is kept in memory and taken with str().
+	 */
+	class tsv_writer {
+	public:
+		static const tools::size_t block_size = 1 << 16;
+
+		explicit tsv_writer(char delim = tools::tab) :
+			m_stream(nullptr), m_delim(delim) { m_buffer.reserve(256); }
+
+		explicit tsv_writer(std::ostream& stream, char delim = tools::tab) :
+			m_stream(&stream), m_delim(delim) { m_buffer.reserve(block_size + 64); }
+
+		tsv_writer(const tsv_writer&) = delete;
+		tsv_writer& operator=(const tsv_writer&) = delete;
+
+		~tsv_writer() { flush(); }
+
+		template <typename _Tp>
+		tsv_writer& write(_Tp value) {
+			_write(value, std::is_integral<_Tp>());
+			return _check_block();
+		}
+
+		tsv_writer& delimiter() { m_buffer.push_back(m_delim); return *this; }
+		tsv_writer& newline() { m_buffer.push_back(tools::ret); return _check_block(); }
+
+		template <typename _Tp, tools::size_t _N>
+		tsv_writer& write(const vector<_Tp, _N>& vec) {
+			for (tools::size_t i = 0; i < _N; ++i) {
+				if (0 < i) { delimiter(); }
+				write(vec[i]);
+			}
+			return *this;
+		}
+
+		template <typename _Tp, tools::size_t _Rows, tools::size_t _Cols>
+		tsv_writer& write(const matrix<_Tp, _Rows, _Cols>& mat) {
+			for (tools::size_t r = 0; r < _Rows; ++r) {
+				write(mat[r]); newline();
+			}
+			return *this;
+		}
+
+		template <typename _Tp, typename _Container>
+		tsv_writer& write(const tools::matrix<_Tp, _Container>& mat) {
+			const _Tp* data = mat.data();
+			for (tools::size_t r = 0; r < mat.rows(); ++r) {
+				for (tools::size_t c = 0; c < mat.cols(); ++c) {
+					if (0 < c) { delimiter(); }
+					write(data[r * mat.cols() + c]);
+				}
+				newline();
+			}
+			return *this;
+		}
+
+		void flush() {
+			if (nullptr == m_stream || m_buffer.empty()) { return; }
+			m_stream->write(m_buffer.data(), (std::streamsize) m_buffer.size());
+			m_buffer.clear();
+		}
+
+		const std::string& str() const { return m_buffer; }
+
+	private:
+		tsv_writer& _check_block() {
+			if (nullptr != m_stream && block_size <= m_buffer.size()) { flush(); }
+			return *this;
+		}
+
+		template <typename _Tp>
+		void _write(_Tp value, std::true_type) {
+			char digits[24];
+			char* itr = digits + sizeof(digits);
+
+			const bool negative = value < 0;
+			tools::uint64_t magnitude = negative ?
+				0 - (tools::uint64_t) value : (tools::uint64_t) value;
+
+			do {
+				*--itr = (char) ('0' + magnitude % 10);
+				magnitude /= 10;
+			} while (0 != magnitude);
+
+			if (negative) { *--itr = '-'; }
+			m_buffer.append(itr, digits + sizeof(digits));
+		}
+
+		template <typename _Tp>
+		void _write(_Tp value, std::false_type) {
+			if ((_Tp) -9007199254740992.0 < value && value < (_Tp) 9007199254740992.0 &&
+				value == (_Tp) (tools::sint64_t) value && !(0 == value && std::signbit(value))) {
+				_write((tools::sint64_t) value, std::true_type());
+				return;
+			}
+
+			if (std::isnan(value)) { m_buffer.append("nan"); return; }
+			if (std::signbit(value)) { m_buffer.push_back('-'); value = -value; }
+			if (std::isinf(value)) { m_buffer.append("inf"); return; }
+			if (0 == value) { m_buffer.push_back('0'); return; }
+
+			_write_float(value);
+		}
+
+		/* the digits in fixed notation as %g would, otherwise in scientific */
+		template <typename _Tp>
+		void _write_float(_Tp value) {
+			char digits[24];
+			int  exponent = 0;
+			const int length = _shortest_digits(value, digits, exponent);
+			const int point  = length + exponent;
+
+			if (-3 <= point && point <= std::numeric_limits<_Tp>::max_digits10) {
+				if (point <= 0) {
+					m_buffer.append("0.");
+					m_buffer.append((tools::size_t) -point, '0');
+					m_buffer.append(digits, (tools::size_t) length);
+				}
+				else if (length <= point) {
+					m_buffer.append(digits, (tools::size_t) length);
+					m_buffer.append((tools::size_t) (point - length), '0');
+				}
+				else {
+					m_buffer.append(digits, (tools::size_t) point);
+					m_buffer.push_back('.');
+					m_buffer.append(digits + point, (tools::size_t) (length - point));
+				}
+				return;
+			}
+
+			m_buffer.push_back(digits[0]);
+			if (1 < length) {
+				m_buffer.push_back('.');
+				m_buffer.append(digits + 1, (tools::size_t) (length - 1));
+			}
+
+			const int power = point - 1;
+			m_buffer.push_back('e');
+			m_buffer.push_back(power < 0 ? '-' : '+');
+			if (-10 < power && power < 10) { m_buffer.push_back('0'); }
+			_write((tools::sint64_t) (power < 0 ? -power : power), std::true_type());
+		}
+
+		/* wider than the 64 bit integers above, max_digits10 always reads back */
+		void _write_float(long double value) {
+			char digits[64];
+			const int length = std::snprintf(digits, sizeof(digits), "%.*Lg", std::numeric_limits<long double>::max_digits10, value);
+			m_buffer.append(digits, (tools::size_t) length);
+		}
+
+		std::ostream* m_stream;
+		char          m_delim;
+		std::string   m_buffer;
 	};
+
+	/* every value is followed by a tab, the last one too */
+	template <typename _Tp, tools::size_t _N>
+	std::string to_tsv(const vector<_Tp, _N>& src) {
+		tsv_writer writer;
+		for (tools::size_t i = 0; i < _N; ++i) { writer.write(src[i]).delimiter(); }
+		return writer.str();
+	}
+
+	template <typename _Tp, tools::size_t _Rows, tools::size_t _Cols>
+	std::string to_tsv(const matrix<_Tp, _Rows, _Cols>& mat) {
+		tsv_writer writer;
+		writer.write(mat);
+		return writer.str();
+	}
+
+	template <typename _Tp, typename _Container>
+	std::string to_tsv(const tools::matrix<_Tp, _Container>& mat) {
+		tsv_writer writer;
+		writer.write(mat);
+		return writer.str();
+	}
 }
 
 namespace math {
 
+	/**
+	 * @note The stream formats the values, so its precision and flags
+	 *       apply: tab separated with a trailing tab as to_tsv gives.
+	 *       to_tsv and tsv_writer are the round-trip exact form.
+	 */
 	template <
 		typename _Tp, tools::size_t _N
 	>
 	std::ostream& operator<<(
 		std::ostream& stream, const math::vector<_Tp, _N>& vec
 	) {
-		return stream << math::to_tsv(vec);
+		for (tools::size_t i = 0; i < _N; ++i) { stream << vec[i] << tools::tab; }
+		return stream;
 	}
 
 	template <typename _Tp, tools::size_t _Rows, tools::size_t _Cols>
 	std::ostream& operator<<(
 		std::ostream& stream, const math::matrix<_Tp, _Rows, _Cols>& mat
 	) {
-		return stream << math::to_tsv(mat);
+		for (tools::size_t r = 0; r < _Rows; ++r) {
+			for (tools::size_t c = 0; c < _Cols; ++c) {
+				stream << mat[r][c] << (c + 1 == _Cols ? tools::ret : tools::tab);
+			}
+		}
+		return stream;
 	}
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -6,6 +6,7 @@
 #define _MATH_MATRIX_H_
 
 #include <cassert>
+#include <initializer_list>
 
 #include "vector.h"
 #include "matrix_algo.h"
@@ -0,0 +1,851 @@
+/*
+ * Created by Maou Lim on 2019/7/2.
+ */
+
+#ifndef _MATRIX_DECOMPOSITION_H_
+#define _MATRIX_DECOMPOSITION_H_
+
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+#include "../common/defines.h"
+#include "../common/parallel.h"
+#include "../container/matrix.h"
+
+#include "matrix.h"
+
+namespace math {
+
+	/**
+	 * @note Results of the factorizations. The fixed-size flavors are
+	 *       plain aggregates over math::matrix, the dynamic flavors own
+	 *       a tools::matrix copy of the input which is overwritten in
+	 *       place, the same layout LAPACK uses:
+	 *         lu       : unit lower L below the diagonal, U on and above,
+	 *                    row i was swapped with row pivots[i] at step i.
+	 *         cholesky : lower triangular L with A = L * L^T.
+	 *         qr       : fixed   -> explicit Q (M x M) and R (M x N).
+	 *                    dynamic -> R on and above the diagonal, the
+	 *                    householder vectors v (v[k] = 1 implied) below
+	 *                    it and their scales in tau, H_k = I - tau v v^T.
+	 */
+	template <typename _Matrix>
+	struct lu_decomposition;
+
+	template <typename _Matrix>
+	struct cholesky_decomposition;
+
+	template <typename _Matrix>
+	struct qr_decomposition;
+
+	template <typename _Tp, tools::size_t _N>
+	struct lu_decomposition<matrix<_Tp, _N, _N>> {
+		typedef matrix<_Tp, _N, _N> matrix_type;
+
+		matrix_type   factors;
+		tools::size_t pivots[_N];
+		bool          singular;
+	};
+
+	template <typename _Tp, tools::size_t _N>
+	struct cholesky_decomposition<matrix<_Tp, _N, _N>> {
+		typedef matrix<_Tp, _N, _N> matrix_type;
+
+		matrix_type lower;
+		bool        positive_definite;
+	};
+
+	template <typename _Tp, tools::size_t _M, tools::size_t _N>
+	struct qr_decomposition<matrix<_Tp, _M, _N>> {
+		typedef matrix<_Tp, _M, _N> matrix_type;
+
+		matrix<_Tp, _M, _M> q;
+		matrix<_Tp, _M, _N> r;
+	};
+
+	/* fixed-size kernels, unrolled over the elimination step */
+
+	template <tools::size_t _Step, typename _Tp, tools::size_t _N>
+	struct _lu_impl {
+
+		static bool factorize(matrix<_Tp, _N, _N>& a, tools::size_t* pivots) {
+			const tools::size_t k = _N - _Step;
+
+			tools::size_t p = k;
+			_Tp max_abs = std::abs(a(k, k));
+			for (tools::size_t r = k + 1; r < _N; ++r) {
+				if (max_abs < std::abs(a(r, k))) {
+					max_abs = std::abs(a(r, k)); p = r;
+				}
+			}
+
+			pivots[k] = p;
+			if (p != k) {
+				for (tools::size_t c = 0; c < _N; ++c) { std::swap(a(p, c), a(k, c)); }
+			}
+
+			const bool regular = static_cast<_Tp>(0) != max_abs;
+			if (regular) {
+				const _Tp pivot = a(k, k);
+				for (tools::size_t r = k + 1; r < _N; ++r) {
+					const _Tp l = (a(r, k) /= pivot);
+					for (tools::size_t c = k + 1; c < _N; ++c) { a(r, c) -= l * a(k, c); }
+				}
+			}
+
+			return _lu_impl<_Step - 1, _Tp, _N>::factorize(a, pivots) && regular;
+		}
+	};
+
+	template <typename _Tp, tools::size_t _N>
+	struct _lu_impl<0, _Tp, _N> {
+		static bool factorize(matrix<_Tp, _N, _N>&, tools::size_t*) { return true; }
+	};
+
+	template <tools::size_t _Step, typename _Tp, tools::size_t _N>
+	struct _triangular_impl {
+
+		/* L * x = b, row (_N - _Step) */
+		static void forward(const matrix<_Tp, _N, _N>& l, vector<_Tp, _N>& x, bool unit) {
+			const tools::size_t i = _N - _Step;
+			for (tools::size_t j = 0; j < i; ++j) { x[i] -= l(i, j) * x[j]; }
+			if (!unit) { x[i] /= l(i, i); }
+			_triangular_impl<_Step - 1, _Tp, _N>::forward(l, x, unit);
+		}
+
+		/* U * x = b, row (_Step - 1) */
+		static void backward(const matrix<_Tp, _N, _N>& u, vector<_Tp, _N>& x) {
+			const tools::size_t i = _Step - 1;
+			for (tools::size_t j = i + 1; j < _N; ++j) { x[i] -= u(i, j) * x[j]; }
+			x[i] /= u(i, i);
+			_triangular_impl<_Step - 1, _Tp, _N>::backward(u, x);
+		}
+
+		/* L^T * x = b, row (_Step - 1) */
+		static void backward_transposed(const matrix<_Tp, _N, _N>& l, vector<_Tp, _N>& x) {
+			const tools::size_t i = _Step - 1;
+			for (tools::size_t j = i + 1; j < _N; ++j) { x[i] -= l(j, i) * x[j]; }
+			x[i] /= l(i, i);
+			_triangular_impl<_Step - 1, _Tp, _N>::backward_transposed(l, x);
+		}
+	};
+
+	template <typename _Tp, tools::size_t _N>
+	struct _triangular_impl<0, _Tp, _N> {
+		static void forward(const matrix<_Tp, _N, _N>&, vector<_Tp, _N>&, bool) { }
+		static void backward(const matrix<_Tp, _N, _N>&, vector<_Tp, _N>&) { }
+		static void backward_transposed(const matrix<_Tp, _N, _N>&, vector<_Tp, _N>&) { }
+	};
+
+	template <tools::size_t _Step, typename _Tp, tools::size_t _N>
+	struct _cholesky_impl {
+
+		static bool factorize(const matrix<_Tp, _N, _N>& a, matrix<_Tp, _N, _N>& l) {
+			const tools::size_t j = _N - _Step;
+
+			_Tp d = a(j, j);
+			for (tools::size_t k = 0; k < j; ++k) { d -= l(j, k) * l(j, k); }
+			if (!(static_cast<_Tp>(0) < d)) { return false; }
+
+			l(j, j) = std::sqrt(d);
+			for (tools::size_t c = j + 1; c < _N; ++c) { l(j, c) = static_cast<_Tp>(0); }
+
+			for (tools::size_t i = j + 1; i < _N; ++i) {
+				_Tp s = a(i, j);
+				for (tools::size_t k = 0; k < j; ++k) { s -= l(i, k) * l(j, k); }
+				l(i, j) = s / l(j, j);
+			}
+
+			return _cholesky_impl<_Step - 1, _Tp, _N>::factorize(a, l);
+		}
+	};
+
+	template <typename _Tp, tools::size_t _N>
+	struct _cholesky_impl<0, _Tp, _N> {
+		static bool factorize(const matrix<_Tp, _N, _N>&, matrix<_Tp, _N, _N>&) { return true; }
+	};
+
+	template <tools::size_t _Step, typename _Tp, tools::size_t _M, tools::size_t _N>
+	struct _qr_impl {
+
+		static void factorize(matrix<_Tp, _M, _M>& q, matrix<_Tp, _M, _N>& r) {
+			const tools::size_t k = _N - _Step;
+
+			_Tp v[_M], norm = static_cast<_Tp>(0);
+			for (tools::size_t i = k; i < _M; ++i) { v[i] = r(i, k); norm += v[i] * v[i]; }
+			norm = std::sqrt(norm);
+
+			if (k + 1 < _M && static_cast<_Tp>(0) < norm) {
+				const _Tp alpha = v[k] < static_cast<_Tp>(0) ? norm : -norm;
+				v[k] -= alpha;
+
+				_Tp vv = static_cast<_Tp>(0);
+				for (tools::size_t i = k; i < _M; ++i) { vv += v[i] * v[i]; }
+
+				for (tools::size_t c = k; c < _N; ++c) {
+					_Tp s = static_cast<_Tp>(0);
+					for (tools::size_t i = k; i < _M; ++i) { s += v[i] * r(i, c); }
+					s = 2 * s / vv;
+					for (tools::size_t i = k; i < _M; ++i) { r(i, c) -= s * v[i]; }
+				}
+
+				for (tools::size_t row = 0; row < _M; ++row) {
+					_Tp s = static_cast<_Tp>(0);
+					for (tools::size_t i = k; i < _M; ++i) { s += q(row, i) * v[i]; }
+					s = 2 * s / vv;
+					for (tools::size_t i = k; i < _M; ++i) { q(row, i) -= s * v[i]; }
+				}
+
+				r(k, k) = alpha;
+				for (tools::size_t i = k + 1; i < _M; ++i) { r(i, k) = static_cast<_Tp>(0); }
+			}
+
+			_qr_impl<_Step - 1, _Tp, _M, _N>::factorize(q, r);
+		}
+	};
+
+	template <typename _Tp, tools::size_t _M, tools::size_t _N>
+	struct _qr_impl<0, _Tp, _M, _N> {
+		static void factorize(matrix<_Tp, _M, _M>&, matrix<_Tp, _M, _N>&) { }
+	};
+
+	/* fixed-size interfaces */
+
+	template <typename _Tp, tools::size_t _N>
+	lu_decomposition<matrix<_Tp, _N, _N>> lu_decompose(const matrix<_Tp, _N, _N>& a) {
+		static_assert(std::is_floating_point<_Tp>::value, "Type not supported.");
+
+		lu_decomposition<matrix<_Tp, _N, _N>> result;
+		result.factors = a;
+		result.singular = !_lu_impl<_N, _Tp, _N>::factorize(result.factors, result.pivots);
+		return result;
+	}
+
+	template <typename _Tp, tools::size_t _N>
+	vector<_Tp, _N> solve(
+		const lu_decomposition<matrix<_Tp, _N, _N>>& lu, const vector<_Tp, _N>& b
+	) {
+		assert(!lu.singular);
+
+		vector<_Tp, _N> x;
+		for (tools::size_t i = 0; i < _N; ++i) { x[i] = b[i]; }
+		for (tools::size_t i = 0; i < _N; ++i) { std::swap(x[i], x[lu.pivots[i]]); }
+
+		_triangular_impl<_N, _Tp, _N>::forward(lu.factors, x, true);
+		_triangular_impl<_N, _Tp, _N>::backward(lu.factors, x);
+		return x;
+	}
+
+	template <typename _Tp, tools::size_t _N>
+	_Tp determinant(const lu_decomposition<matrix<_Tp, _N, _N>>& lu) {
+		_Tp det = static_cast<_Tp>(1);
+		for (tools::size_t i = 0; i < _N; ++i) {
+			det *= lu.factors(i, i);
+			if (i != lu.pivots[i]) { det = -det; }
+		}
+		return det;
+	}
+
+	template <typename _Tp, tools::size_t _N>
+	cholesky_decomposition<matrix<_Tp, _N, _N>> cholesky_decompose(const matrix<_Tp, _N, _N>& a) {
+		static_assert(std::is_floating_point<_Tp>::value, "Type not supported.");
+
+		cholesky_decomposition<matrix<_Tp, _N, _N>> result;
+		result.positive_definite = _cholesky_impl<_N, _Tp, _N>::factorize(a, result.lower);
+		return result;
+	}
+
+	template <typename _Tp, tools::size_t _N>
+	vector<_Tp, _N> solve(
+		const cholesky_decomposition<matrix<_Tp, _N, _N>>& chol, const vector<_Tp, _N>& b
+	) {
+		assert(chol.positive_definite);
+
+		vector<_Tp, _N> x;
+		for (tools::size_t i = 0; i < _N; ++i) { x[i] = b[i]; }
+
+		_triangular_impl<_N, _Tp, _N>::forward(chol.lower, x, false);
+		_triangular_impl<_N, _Tp, _N>::backward_transposed(chol.lower, x);
+		return x;
+	}
+
+	template <typename _Tp, tools::size_t _M, tools::size_t _N>
+	qr_decomposition<matrix<_Tp, _M, _N>> qr_decompose(const matrix<_Tp, _M, _N>& a) {
+		static_assert(std::is_floating_point<_Tp>::value, "Type not supported.");
+		static_assert(_N <= _M, "Under-determined system.");
+
+		qr_decomposition<matrix<_Tp, _M, _N>> result;
+		result.r = a;
+		for (tools::size_t i = 0; i < _M; ++i) {
+			for (tools::size_t j = 0; j < _M; ++j) {
+				result.q(i, j) = static_cast<_Tp>(i == j ? 1 : 0);
+			}
+		}
+
+		_qr_impl<_N, _Tp, _M, _N>::factorize(result.q, result.r);
+		return result;
+	}
+
+	/**
+	 * @note Least-squares solution of A * x = b, exact when A is square
+	 *       and regular. A has to be of full column rank.
+	 */
+	template <typename _Tp, tools::size_t _M, tools::size_t _N>
+	vector<_Tp, _N> solve(
+		const qr_decomposition<matrix<_Tp, _M, _N>>& qr, const vector<_Tp, _M>& b
+	) {
+		vector<_Tp, _N> x;
+		for (tools::size_t j = 0; j < _N; ++j) {
+			_Tp s = static_cast<_Tp>(0);
+			for (tools::size_t i = 0; i < _M; ++i) { s += qr.q(i, j) * b[i]; }
+			x[j] = s;
+		}
+
+		for (tools::size_t i = _N; 0 < i--; ) {
+			for (tools::size_t j = i + 1; j < _N; ++j) { x[i] -= qr.r(i, j) * x[j]; }
+			x[i] /= qr.r(i, i);
+		}
+		return x;
+	}
+
+	template <typename _Tp, tools::size_t _N>
+	bool solve(const matrix<_Tp, _N, _N>& a, const vector<_Tp, _N>& b, vector<_Tp, _N>& x) {
+		auto lu = lu_decompose(a);
+		if (lu.singular) { return false; }
+		x = solve(lu, b);
+		return true;
+	}
+
+	template <typename _Tp, tools::size_t _N>
+	bool inverse(const matrix<_Tp, _N, _N>& a, matrix<_Tp, _N, _N>& result) {
+		auto lu = lu_decompose(a);
+		if (lu.singular) { return false; }
+
+		for (tools::size_t j = 0; j < _N; ++j) {
+			vector<_Tp, _N> e;
+			for (tools::size_t i = 0; i < _N; ++i) { e[i] = static_cast<_Tp>(i == j ? 1 : 0); }
+			e = solve(lu, e);
+			for (tools::size_t i = 0; i < _N; ++i) { result(i, j) = e[i]; }
+		}
+		return true;
+	}
+
+	/* dynamic-size, blocked and multi-threaded */
+
+	const tools::size_t _decomposition_block = 64;
+
+	/* threads worth starting for an n x n problem, one per block row or column at most */
+	inline tools::size_t _decomposition_threads(tools::size_t n) {
+		return std::max<tools::size_t>(1, tools::min(tools::concurrency(), n / _decomposition_block));
+	}
+
+	/* [first, last) cut into blocks of grain, each a task of the pool, op(block_first, block_last) */
+	template <typename _RangeOp>
+	void _run_blocks(tools::thread_pool& pool, tools::size_t first, tools::size_t last, tools::size_t grain, _RangeOp op) {
+		if (last <= first) { return; }
+		pool.run((last - first + grain - 1) / grain, [=, &op](tools::size_t task) {
+			const tools::size_t begin = first + task * grain;
+			op(begin, tools::min(begin + grain, last));
+		});
+	}
+
+	template <typename _Val, typename _Container>
+	struct lu_decomposition<tools::matrix<_Val, _Container>> {
+		typedef tools::matrix<_Val, _Container> matrix_type;
+
+		explicit lu_decomposition(const matrix_type& a) :
+			factors(a), pivots(a.rows(), 0), singular(false) { }
+
+		matrix_type                    factors;
+		tools::sequence<tools::size_t> pivots;
+		bool                           singular;
+	};
+
+	template <typename _Val, typename _Container>
+	struct cholesky_decomposition<tools::matrix<_Val, _Container>> {
+		typedef tools::matrix<_Val, _Container> matrix_type;
+
+		explicit cholesky_decomposition(const matrix_type& a) :
+			lower(a), positive_definite(true) { }
+
+		matrix_type lower;
+		bool        positive_definite;
+	};
+
+	template <typename _Val, typename _Container>
+	struct qr_decomposition<tools::matrix<_Val, _Container>> {
+		typedef tools::matrix<_Val, _Container> matrix_type;
+
+		explicit qr_decomposition(const matrix_type& a) :
+			factors(a), tau(a.cols(), _Val(0)) { }
+
+		matrix_type             factors;
+		tools::sequence<_Val>   tau;
+	};
+
+	/**
+	 * @note Right-looking LU with partial pivoting. Each block column
+	 *       is factorized unblocked, then the block row of U and the
+	 *       trailing sub-matrix are updated tile by tile, the updates
+	 *       being split by rows (columns for U12) among the threads of
+	 *       the pool, which are started once for all the blocks.
+	 */
+	template <typename _Val, typename _Container>
+	lu_decomposition<tools::matrix<_Val, _Container>>
+		lu_decompose(const tools::matrix<_Val, _Container>& a, tools::thread_pool& pool)
+	{
+		static_assert(std::is_floating_point<_Val>::value, "Type not supported.");
+		assert(a.squared());
+
+		const tools::size_t n  = a.rows();
+		const tools::size_t nb = _decomposition_block;
+
+		lu_decomposition<tools::matrix<_Val, _Container>> result(a);
+		_Val* base = result.factors.data();
+
+		for (tools::size_t kb = 0; kb < n; kb += nb) {
+			const tools::size_t kend = tools::min(kb + nb, n);
+
+			/* panel */
+			for (tools::size_t j = kb; j < kend; ++j) {
+				tools::size_t p = j;
+				_Val max_abs = std::abs(base[j * n + j]);
+				for (tools::size_t r = j + 1; r < n; ++r) {
+					if (max_abs < std::abs(base[r * n + j])) {
+						max_abs = std::abs(base[r * n + j]); p = r;
+					}
+				}
+
+				result.pivots[j] = p;
+				if (p != j) { std::swap_ranges(base + p * n, base + (p + 1) * n, base + j * n); }
+				if (_Val(0) == max_abs) { result.singular = true; continue; }
+
+				const _Val* row_j = base + j * n;
+				for (tools::size_t r = j + 1; r < n; ++r) {
+					_Val* row_r = base + r * n;
+					const _Val l = (row_r[j] /= row_j[j]);
+					for (tools::size_t c = j + 1; c < kend; ++c) { row_r[c] -= l * row_j[c]; }
+				}
+			}
+
+			if (n == kend) { break; }
+
+			/* U12 = L11^-1 * A12 */
+			_run_blocks(pool, kend, n, nb, [=](tools::size_t c0, tools::size_t c1) {
+				for (tools::size_t i = kb + 1; i < kend; ++i) {
+					_Val* row_i = base + i * n;
+					for (tools::size_t k = kb; k < i; ++k) {
+						const _Val  l     = row_i[k];
+						const _Val* row_k = base + k * n;
+						for (tools::size_t c = c0; c < c1; ++c) { row_i[c] -= l * row_k[c]; }
+					}
+				}
+			});
+
+			/* A22 -= L21 * U12 */
+			_run_blocks(pool, kend, n, nb, [=](tools::size_t r0, tools::size_t r1) {
+				for (tools::size_t cb = kend; cb < n; cb += nb) {
+					const tools::size_t cend = tools::min(cb + nb, n);
+					for (tools::size_t r = r0; r < r1; ++r) {
+						_Val* row_r = base + r * n;
+						for (tools::size_t k = kb; k < kend; ++k) {
+							const _Val l = row_r[k];
+							if (_Val(0) == l) { continue; }
+							const _Val* row_k = base + k * n;
+							for (tools::size_t c = cb; c < cend; ++c) { row_r[c] -= l * row_k[c]; }
+						}
+					}
+				}
+			});
+		}
+
+		return result;
+	}
+
+	template <typename _Val, typename _Container>
+	lu_decomposition<tools::matrix<_Val, _Container>>
+		lu_decompose(const tools::matrix<_Val, _Container>& a)
+	{
+		tools::thread_pool pool(_decomposition_threads(a.rows()));
+		return lu_decompose(a, pool);
+	}
+
+	template <typename _Val, typename _Container>
+	tools::matrix<_Val, _Container> solve(
+		const lu_decomposition<tools::matrix<_Val, _Container>>& lu,
+		const tools::matrix<_Val, _Container>&                   b
+	) {
+		assert(!lu.singular && lu.factors.rows() == b.rows());
+
+		const tools::size_t n = lu.factors.rows(), m = b.cols();
+
+		tools::matrix<_Val, _Container> x(b);
+		const _Val* f = lu.factors.data();
+		_Val*    base = x.data();
+
+		for (tools::size_t i = 0; i < n; ++i) {
+			const tools::size_t p = lu.pivots[i];
+			if (p != i) { std::swap_ranges(base + p * m, base + (p + 1) * m, base + i * m); }
+		}
+
+		tools::parallel_for(0, m, _decomposition_block, [=](tools::size_t c0, tools::size_t c1) {
+			for (tools::size_t i = 1; i < n; ++i) {
+				_Val* row_i = base + i * m;
+				for (tools::size_t k = 0; k < i; ++k) {
+					const _Val l = f[i * n + k];
+					const _Val* row_k = base + k * m;
+					for (tools::size_t c = c0; c < c1; ++c) { row_i[c] -= l * row_k[c]; }
+				}
+			}
+
+			for (tools::size_t i = n; 0 < i--; ) {
+				_Val* row_i = base + i * m;
+				for (tools::size_t k = i + 1; k < n; ++k) {
+					const _Val u = f[i * n + k];
+					const _Val* row_k = base + k * m;
+					for (tools::size_t c = c0; c < c1; ++c) { row_i[c] -= u * row_k[c]; }
+				}
+				const _Val d = f[i * n + i];
+				for (tools::size_t c = c0; c < c1; ++c) { row_i[c] /= d; }
+			}
+		});
+
+		return x;
+	}
+
+	template <typename _Val, typename _Container>
+	_Val determinant(const lu_decomposition<tools::matrix<_Val, _Container>>& lu) {
+		_Val det = _Val(1);
+		for (tools::size_t i = 0; i < lu.factors.rows(); ++i) {
+			det *= lu.factors(i, i);
+			if (i != lu.pivots[i]) { det = -det; }
+		}
+		return det;
+	}
+
+	/**
+	 * @note Blocked right-looking Cholesky: the diagonal block is
+	 *       factorized unblocked, the panel below it is solved row by
+	 *       row and the lower half of the trailing matrix is updated
+	 *       with row-segment dot products, both by blocks of rows on
+	 *       the pool.
+	 */
+	template <typename _Val, typename _Container>
+	cholesky_decomposition<tools::matrix<_Val, _Container>>
+		cholesky_decompose(const tools::matrix<_Val, _Container>& a, tools::thread_pool& pool)
+	{
+		static_assert(std::is_floating_point<_Val>::value, "Type not supported.");
+		assert(a.squared());
+
+		const tools::size_t n  = a.rows();
+		const tools::size_t nb = _decomposition_block;
+
+		cholesky_decomposition<tools::matrix<_Val, _Container>> result(a);
+		_Val* base = result.lower.data();
+
+		for (tools::size_t kb = 0; kb < n; kb += nb) {
+			const tools::size_t kend = tools::min(kb + nb, n);
+
+			/* L11 */
+			for (tools::size_t j = kb; j < kend; ++j) {
+				_Val* row_j = base + j * n;
+				_Val d = row_j[j];
+				for (tools::size_t k = kb; k < j; ++k) { d -= row_j[k] * row_j[k]; }
+				if (!(_Val(0) < d)) { result.positive_definite = false; return result; }
+				row_j[j] = std::sqrt(d);
+
+				for (tools::size_t i = j + 1; i < kend; ++i) {
+					_Val* row_i = base + i * n;
+					_Val s = row_i[j];
+					for (tools::size_t k = kb; k < j; ++k) { s -= row_i[k] * row_j[k]; }
+					row_i[j] = s / row_j[j];
+				}
+			}
+
+			if (n == kend) { break; }
+
+			/* L21 = A21 * L11^-T, then A22 -= L21 * L21^T */
+			_run_blocks(pool, kend, n, nb, [=](tools::size_t r0, tools::size_t r1) {
+				for (tools::size_t i = r0; i < r1; ++i) {
+					_Val* row_i = base + i * n;
+					for (tools::size_t j = kb; j < kend; ++j) {
+						const _Val* row_j = base + j * n;
+						_Val s = row_i[j];
+						for (tools::size_t k = kb; k < j; ++k) { s -= row_i[k] * row_j[k]; }
+						row_i[j] = s / row_j[j];
+					}
+				}
+			});
+
+			_run_blocks(pool, kend, n, nb, [=](tools::size_t r0, tools::size_t r1) {
+				for (tools::size_t i = r0; i < r1; ++i) {
+					_Val* row_i = base + i * n;
+					for (tools::size_t j = kend; j <= i; ++j) {
+						const _Val* row_j = base + j * n;
+						_Val s = _Val(0);
+						for (tools::size_t k = kb; k < kend; ++k) { s += row_i[k] * row_j[k]; }
+						row_i[j] -= s;
+					}
+				}
+			});
+		}
+
+		for (tools::size_t i = 0; i < n; ++i) {
+			std::fill(base + i * n + i + 1, base + (i + 1) * n, _Val(0));
+		}
+
+		return result;
+	}
+
+	template <typename _Val, typename _Container>
+	cholesky_decomposition<tools::matrix<_Val, _Container>>
+		cholesky_decompose(const tools::matrix<_Val, _Container>& a)
+	{
+		tools::thread_pool pool(_decomposition_threads(a.rows()));
+		return cholesky_decompose(a, pool);
+	}
+
+	template <typename _Val, typename _Container>
+	tools::matrix<_Val, _Container> solve(
+		const cholesky_decomposition<tools::matrix<_Val, _Container>>& chol,
+		const tools::matrix<_Val, _Container>&                         b
+	) {
+		assert(chol.positive_definite && chol.lower.rows() == b.rows());
+
+		const tools::size_t n = chol.lower.rows(), m = b.cols();
+
+		tools::matrix<_Val, _Container> x(b);
+		const _Val* l = chol.lower.data();
+		_Val*    base = x.data();
+
+		tools::parallel_for(0, m, _decomposition_block, [=](tools::size_t c0, tools::size_t c1) {
+			for (tools::size_t i = 0; i < n; ++i) {
+				_Val* row_i = base + i * m;
+				for (tools::size_t k = 0; k < i; ++k) {
+					const _Val f = l[i * n + k];
+					const _Val* row_k = base + k * m;
+					for (tools::size_t c = c0; c < c1; ++c) { row_i[c] -= f * row_k[c]; }
+				}
+				const _Val d = l[i * n + i];
+				for (tools::size_t c = c0; c < c1; ++c) { row_i[c] /= d; }
+			}
+
+			for (tools::size_t i = n; 0 < i--; ) {
+				_Val* row_i = base + i * m;
+				for (tools::size_t k = i + 1; k < n; ++k) {
+					const _Val f = l[k * n + i];
+					const _Val* row_k = base + k * m;
+					for (tools::size_t c = c0; c < c1; ++c) { row_i[c] -= f * row_k[c]; }
+				}
+				const _Val d = l[i * n + i];
+				for (tools::size_t c = c0; c < c1; ++c) { row_i[c] /= d; }
+			}
+		});
+
+		return x;
+	}
+
+	/**
+	 * @note Blocked Householder QR of an m x n matrix (m >= n) in the
+	 *       compact WY form: each block of nb columns is factorized
+	 *       unblocked, its reflectors H_1 ... H_nb are gathered into
+	 *       I - V * T * V^T with T upper triangular, and Q^T reaches the
+	 *       trailing columns C as three matrix products, W = V^T * C,
+	 *       W = T^T * W and C -= V * W, by blocks of columns on the pool.
+	 *       v_k is kept below the diagonal of factors with its leading 1
+	 *       implied, and its scalar in tau, as the solver expects.
+	 */
+	template <typename _Val, typename _Container>
+	qr_decomposition<tools::matrix<_Val, _Container>>
+		qr_decompose(const tools::matrix<_Val, _Container>& a, tools::thread_pool& pool)
+	{
+		static_assert(std::is_floating_point<_Val>::value, "Type not supported.");
+		assert(a.cols() <= a.rows());
+
+		const tools::size_t m  = a.rows(), n = a.cols();
+		const tools::size_t nb = _decomposition_block;
+
+		qr_decomposition<tools::matrix<_Val, _Container>> result(a);
+		_Val* base = result.factors.data();
+
+		/* T of the block, V^T * v_j and the panel's v^T * A, then W for all the trailing columns */
+		tools::sequence<_Val> t_buff(nb * nb, _Val(0)), z_buff(nb, _Val(0)), w_buff(nb * n, _Val(0));
+		_Val* const t = t_buff.data();
+		_Val* const z = z_buff.data();
+		_Val* const w = w_buff.data();
+
+		for (tools::size_t kb = 0; kb < n; kb += nb) {
+			const tools::size_t kend = tools::min(kb + nb, n), size = kend - kb;
+
+			/* panel, the reflectors applied to the rest of the block row by row */
+			for (tools::size_t k = kb; k < kend; ++k) {
+				_Val* row_k = base + k * n;
+
+				_Val norm = _Val(0);
+				for (tools::size_t i = k + 1; i < m; ++i) { norm += base[i * n + k] * base[i * n + k]; }
+				if (_Val(0) == norm) { result.tau[k] = _Val(0); continue; }
+
+				const _Val x0   = row_k[k];
+				const _Val beta = x0 < _Val(0) ? std::sqrt(norm + x0 * x0) : -std::sqrt(norm + x0 * x0);
+				const _Val tau  = (beta - x0) / beta;
+				const _Val div  = x0 - beta;
+
+				for (tools::size_t i = k + 1; i < m; ++i) { base[i * n + k] /= div; }
+				row_k[k] = beta;
+				result.tau[k] = tau;
+
+				for (tools::size_t c = k + 1; c < kend; ++c) { z[c - kb] = row_k[c]; }
+				for (tools::size_t i = k + 1; i < m; ++i) {
+					const _Val* row_i = base + i * n;
+					const _Val  v     = row_i[k];
+					for (tools::size_t c = k + 1; c < kend; ++c) { z[c - kb] += v * row_i[c]; }
+				}
+
+				for (tools::size_t c = k + 1; c < kend; ++c) { row_k[c] -= tau * z[c - kb]; }
+				for (tools::size_t i = k + 1; i < m; ++i) {
+					_Val* row_i = base + i * n;
+					const _Val v = tau * row_i[k];
+					for (tools::size_t c = k + 1; c < kend; ++c) { row_i[c] -= v * z[c - kb]; }
+				}
+			}
+
+			if (n == kend) { break; }
+
+			/* T(0:j, j) = -tau_j * T(0:j, 0:j) * V(:, 0:j)^T * v_j, T(j, j) = tau_j */
+			for (tools::size_t j = 0; j < size; ++j) {
+				const tools::size_t kj  = kb + j;
+				const _Val          tau = result.tau[kj];
+
+				for (tools::size_t l = 0; l < j; ++l) { z[l] = base[kj * n + kb + l]; }
+				for (tools::size_t i = kj + 1; i < m; ++i) {
+					const _Val* row_i = base + i * n;
+					const _Val  v     = row_i[kj];
+					for (tools::size_t l = 0; l < j; ++l) { z[l] += row_i[kb + l] * v; }
+				}
+
+				for (tools::size_t l = 0; l < j; ++l) {
+					_Val s = _Val(0);
+					for (tools::size_t p = l; p < j; ++p) { s += t[l * nb + p] * z[p]; }
+					t[l * nb + j] = -tau * s;
+				}
+				t[j * nb + j] = tau;
+			}
+
+			_run_blocks(pool, kend, n, nb, [=](tools::size_t c0, tools::size_t c1) {
+				/* W = V^T * C, row by row of C, the 1 of v_j sits in row kb + j */
+				for (tools::size_t j = 0; j < size; ++j) { std::fill(w + j * n + c0, w + j * n + c1, _Val(0)); }
+				for (tools::size_t i = kb; i < m; ++i) {
+					const _Val*         row_i = base + i * n;
+					const tools::size_t below = tools::min(i - kb, size);
+					for (tools::size_t j = 0; j < below; ++j) {
+						const _Val v  = row_i[kb + j];
+						_Val*      wj = w + j * n;
+						for (tools::size_t c = c0; c < c1; ++c) { wj[c] += v * row_i[c]; }
+					}
+					if (below < size) {
+						_Val* wj = w + below * n;
+						for (tools::size_t c = c0; c < c1; ++c) { wj[c] += row_i[c]; }
+					}
+				}
+
+				/* W = T^T * W, from the last row up so that the rows read are still the old ones */
+				for (tools::size_t j = size; 0 < j--; ) {
+					_Val* wj = w + j * n;
+					const _Val d = t[j * nb + j];
+					for (tools::size_t c = c0; c < c1; ++c) { wj[c] *= d; }
+					for (tools::size_t l = 0; l < j; ++l) {
+						const _Val  f  = t[l * nb + j];
+						const _Val* wl = w + l * n;
+						for (tools::size_t c = c0; c < c1; ++c) { wj[c] += f * wl[c]; }
+					}
+				}
+
+				/* C -= V * W */
+				for (tools::size_t i = kb; i < m; ++i) {
+					_Val*               row_i = base + i * n;
+					const tools::size_t below = tools::min(i - kb, size);
+					for (tools::size_t j = 0; j < below; ++j) {
+						const _Val  v  = row_i[kb + j];
+						const _Val* wj = w + j * n;
+						for (tools::size_t c = c0; c < c1; ++c) { row_i[c] -= v * wj[c]; }
+					}
+					if (below < size) {
+						const _Val* wj = w + below * n;
+						for (tools::size_t c = c0; c < c1; ++c) { row_i[c] -= wj[c]; }
+					}
+				}
+			});
+		}
+
+		return result;
+	}
+
+	template <typename _Val, typename _Container>
+	qr_decomposition<tools::matrix<_Val, _Container>>
+		qr_decompose(const tools::matrix<_Val, _Container>& a)
+	{
+		tools::thread_pool pool(_decomposition_threads(a.cols()));
+		return qr_decompose(a, pool);
+	}
+
+	/**
+	 * @note Least-squares solution of A * X = B: Q^T is applied to B
+	 *       reflector by reflector, then R is back-substituted.
+	 */
+	template <typename _Val, typename _Container>
+	tools::matrix<_Val, _Container> solve(
+		const qr_decomposition<tools::matrix<_Val, _Container>>& qr,
+		const tools::matrix<_Val, _Container>&                   b
+	) {
+		assert(qr.factors.rows() == b.rows());
+
+		const tools::size_t m = qr.factors.rows(), n = qr.factors.cols(), k = b.cols();
+
+		tools::matrix<_Val, _Container> y(b);
+		const _Val* f = qr.factors.data();
+		_Val*    base = y.data();
+
+		tools::parallel_for(0, k, _decomposition_block, [=, &qr](tools::size_t c0, tools::size_t c1) {
+			for (tools::size_t j = 0; j < n; ++j) {
+				const _Val tau = qr.tau[j];
+				if (_Val(0) == tau) { continue; }
+
+				for (tools::size_t c = c0; c < c1; ++c) {
+					_Val w = base[j * k + c];
+					for (tools::size_t i = j + 1; i < m; ++i) { w += f[i * n + j] * base[i * k + c]; }
+					w *= tau;
+					base[j * k + c] -= w;
+					for (tools::size_t i = j + 1; i < m; ++i) { base[i * k + c] -= w * f[i * n + j]; }
+				}
+			}
+		});
+
+		tools::matrix<_Val, _Container> x(n, k);
+		for (tools::size_t i = n; 0 < i--; ) {
+			for (tools::size_t c = 0; c < k; ++c) {
+				_Val s = base[i * k + c];
+				for (tools::size_t j = i + 1; j < n; ++j) { s -= f[i * n + j] * x(j, c); }
+				x(i, c) = s / f[i * n + i];
+			}
+		}
+
+		return x;
+	}
+
+	template <typename _Val, typename _Container>
+	bool inverse(
+		const tools::matrix<_Val, _Container>& a,
+		tools::matrix<_Val, _Container>&       result
+	) {
+		auto lu = lu_decompose(a);
+		if (lu.singular) { return false; }
+
+		result = solve(lu, tools::matrix<_Val, _Container>(a.rows(), a.cols(), tools::matrix_init::identity));
+		return true;
+	}
+}
+
+#endif //_MATRIX_DECOMPOSITION_H_
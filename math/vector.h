@@ -6,6 +6,7 @@
 #define _VECTOR_H_
 
 #include <cassert>
+#include <cmath>
 
 #include "../common/defines.h"
 #include "../common/type_base.h"
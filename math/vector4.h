@@ -171,6 +171,8 @@ namespace math {
 		const_pointer data() const { return &x; }
 		pointer data() { return const_cast<pointer>(((const self_type*) this)->data()); }
 
+		size_type size() const { return shape_type::dim0; }
+
 		length_type length() const { return static_cast<length_type>(sqrt(sum_of_squares(*this))); }
 
 	private:
@@ -5,6 +5,7 @@
 #ifndef _VECTOR_ALGO_H_
 #define _VECTOR_ALGO_H_
 
+#include <cstddef>
 #include <limits>
 
 #include "../common/functor.h"
@@ -0,0 +1,663 @@
+/*
+ * Created by Maou Lim on 2019/7/20.
+ */
+
+#ifndef _AUTODIFF_H_
+#define _AUTODIFF_H_
+
+#include <cassert>
+#include <vector>
+
+#include "../common/defines.h"
+#include "../math/math_common.h"
+#include "tensor.h"
+
+namespace ml {
+
+	/* element-wise stages a fused chain is made of */
+	enum class unary_op : tools::uint8_t {
+		affine,      // a * x + b
+		square,
+		reciprocal,
+		exp,
+		log,
+		sigmoid,
+		tanh,
+		relu
+	};
+
+	enum class tape_op : tools::uint8_t {
+		leaf, constant, map, add, sub, mul, div, matmul, sum, mean
+	};
+
+	/* most stages one map node fuses, a longer chain starts a new node */
+	constexpr tools::size_t max_fused = 8;
+
+	/* elements a fused chain processes at a time, its stages stay in L1 */
+	constexpr tools::size_t _fusion_block = 256;
+
+	template <typename _Value>
+	struct _stage {
+		unary_op kind;
+		_Value   a, b;
+	};
+
+	/* dst = stage(src) over n elements, src and dst may alias */
+	template <typename _Value>
+	void _stage_forward(const _stage<_Value>& s, const _Value* src, tools::size_t n, _Value* dst) {
+		switch (s.kind) {
+			case unary_op::affine : {
+				const _Value a = s.a, b = s.b;
+				for (tools::size_t i = 0; i < n; ++i) { dst[i] = a * src[i] + b; }
+				break;
+			}
+			case unary_op::square : {
+				for (tools::size_t i = 0; i < n; ++i) { dst[i] = src[i] * src[i]; }
+				break;
+			}
+			case unary_op::reciprocal : {
+				for (tools::size_t i = 0; i < n; ++i) { dst[i] = _Value(1) / src[i]; }
+				break;
+			}
+			case unary_op::exp     : { math::exp(src, n, dst); break; }
+			case unary_op::log     : { math::log(src, n, dst); break; }
+			case unary_op::sigmoid : { math::sigmoid(src, n, dst); break; }
+			case unary_op::tanh    : { math::tanh(src, n, dst); break; }
+			case unary_op::relu : {
+				for (tools::size_t i = 0; i < n; ++i) { dst[i] = _Value(0) < src[i] ? src[i] : _Value(0); }
+				break;
+			}
+			default : { break; }
+		}
+	}
+
+	/* d *= stage'(x), x being the stage input and y its output */
+	template <typename _Value>
+	void _stage_backward(const _stage<_Value>& s, const _Value* x, const _Value* y, tools::size_t n, _Value* d) {
+		switch (s.kind) {
+			case unary_op::affine : {
+				const _Value a = s.a;
+				for (tools::size_t i = 0; i < n; ++i) { d[i] *= a; }
+				break;
+			}
+			case unary_op::square : {
+				for (tools::size_t i = 0; i < n; ++i) { d[i] *= _Value(2) * x[i]; }
+				break;
+			}
+			case unary_op::reciprocal : {
+				for (tools::size_t i = 0; i < n; ++i) { d[i] *= -y[i] * y[i]; }
+				break;
+			}
+			case unary_op::exp : {
+				for (tools::size_t i = 0; i < n; ++i) { d[i] *= y[i]; }
+				break;
+			}
+			case unary_op::log : {
+				for (tools::size_t i = 0; i < n; ++i) { d[i] /= x[i]; }
+				break;
+			}
+			case unary_op::sigmoid : {
+				for (tools::size_t i = 0; i < n; ++i) { d[i] *= y[i] * (_Value(1) - y[i]); }
+				break;
+			}
+			case unary_op::tanh : {
+				for (tools::size_t i = 0; i < n; ++i) { d[i] *= _Value(1) - y[i] * y[i]; }
+				break;
+			}
+			case unary_op::relu : {
+				for (tools::size_t i = 0; i < n; ++i) { d[i] = _Value(0) < x[i] ? d[i] : _Value(0); }
+				break;
+			}
+			default : { break; }
+		}
+	}
+
+	/**
+	 * @note fn(d, x, y, z) over the elements of dims, the four operands
+	 *       broadcast to it. d is written and may be a broadcast view,
+	 *       whose repeated elements then accumulate every write: that is
+	 *       how gradients are summed back onto broadcast inputs.
+	 */
+	template <typename _Value, typename _Fn>
+	void _for_each(
+		const shape&          dims,
+		const tensor<_Value>& d,
+		const tensor<_Value>& x,
+		const tensor<_Value>& y,
+		const tensor<_Value>& z,
+		_Fn                   fn
+	) {
+		if (d.shape() == dims && x.shape() == dims && y.shape() == dims && z.shape() == dims &&
+		    d.contiguous() && x.contiguous() && y.contiguous() && z.contiguous()) {
+			_Value* pd = const_cast<_Value*>(d.data());
+			const _Value* px = x.data();
+			const _Value* py = y.data();
+			const _Value* pz = z.data();
+			const tools::size_t n = dims.size();
+			for (tools::size_t i = 0; i < n; ++i) { fn(pd[i], px[i], py[i], pz[i]); }
+			return;
+		}
+
+		const tensor<_Value> vd = d.broadcast_to(dims);
+		const tensor<_Value> vx = x.broadcast_to(dims);
+		const tensor<_Value> vy = y.broadcast_to(dims);
+		const tensor<_Value> vz = z.broadcast_to(dims);
+
+		tools::size_t strides[4][max_rank];
+		_copy_strides(strides[0], vd);
+		_copy_strides(strides[1], vx);
+		_copy_strides(strides[2], vy);
+		_copy_strides(strides[3], vz);
+
+		tools::size_t offsets[4] = { 0, 0, 0, 0 };
+		_Value* pd = const_cast<_Value*>(vd.data());
+		const _Value* px = vx.data();
+		const _Value* py = vy.data();
+		const _Value* pz = vz.data();
+		_nd_rows<4>(dims, strides, offsets, [=, &fn](const tools::size_t* at, tools::size_t n, const tools::size_t* steps) {
+			for (tools::size_t i = 0; i < n; ++i) {
+				fn(pd[at[0] + i * steps[0]], px[at[1] + i * steps[1]], py[at[2] + i * steps[2]], pz[at[3] + i * steps[3]]);
+			}
+		});
+	}
+
+	/**
+	 * @note c += a * b for rank 2 tensors, c contiguous, a and b any
+	 *       strided views (transposes included). The loop order keeps
+	 *       the innermost loop on unit strides whenever one exists.
+	 */
+	template <typename _Value>
+	void _gemm_add(tensor<_Value>& c, const tensor<_Value>& a, const tensor<_Value>& b) {
+		assert(2 == a.rank() && 2 == b.rank() && a.dim(1) == b.dim(0));
+		assert(c.contiguous() && c.dim(0) == a.dim(0) && c.dim(1) == b.dim(1));
+
+		const tools::size_t rows = a.dim(0), inner = a.dim(1), cols = b.dim(1);
+		const tools::size_t ar = a.stride(0), ak = a.stride(1);
+		const tools::size_t bk = b.stride(0), bc = b.stride(1);
+		const _Value* pa = a.data();
+		const _Value* pb = b.data();
+		_Value* out = c.data();
+
+		if (1 != bc && 1 == ak && 1 == bk) {
+			/* rows of a against columns of b, both unit stride: dot products */
+			for (tools::size_t i = 0; i < rows; ++i) {
+				const _Value* arow = pa + i * ar;
+				for (tools::size_t j = 0; j < cols; ++j) {
+					const _Value* bcol = pb + j * bc;
+					_Value acc = _Value(0);
+					for (tools::size_t k = 0; k < inner; ++k) { acc += arow[k] * bcol[k]; }
+					out[i * cols + j] += acc;
+				}
+			}
+			return;
+		}
+
+		for (tools::size_t i = 0; i < rows; ++i) {
+			_Value* row = out + i * cols;
+			for (tools::size_t k = 0; k < inner; ++k) {
+				const _Value scale = pa[i * ar + k * ak];
+				const _Value* brow = pb + k * bk;
+				if (1 == bc) {
+					for (tools::size_t j = 0; j < cols; ++j) { row[j] += scale * brow[j]; }
+				}
+				else {
+					for (tools::size_t j = 0; j < cols; ++j) { row[j] += scale * brow[j * bc]; }
+				}
+			}
+		}
+	}
+
+	template <typename _Value>
+	class tape;
+
+	/**
+	 * @note Handle to a value recorded on a tape: the node and how many
+	 *       stages of its fused chain it stands for. Handles are plain
+	 *       values and stay valid until the tape is reset.
+	 */
+	template <typename _Value>
+	struct var {
+		tape<_Value>* owner;
+		tools::size_t node;
+		tools::size_t stage;
+	};
+
+	/**
+	 * @note Reverse-mode automatic differentiation. Operations on vars
+	 *       are recorded on the tape, values are computed when asked for
+	 *       (value(), backward()), and backward(loss) sweeps the tape in
+	 *       reverse, accumulating d loss / d node into every node that
+	 *       depends on a variable().
+	 *
+	 *       The tape is its own arena: reset() forgets the records but
+	 *       keeps the node slots and their value and gradient buffers,
+	 *       and a slot recorded again with the same shape reuses them.
+	 *       A training loop that records the same graph every step thus
+	 *       allocates nothing after the first one. A buffer is only
+	 *       reused while the tape is its sole owner, so value() and
+	 *       gradient() results kept across a reset stay intact (and cost
+	 *       that slot a fresh buffer).
+	 *
+	 *       Chains of element-wise unary operations (exp, log, sigmoid,
+	 *       tanh, relu, square, reciprocal, scalar + - * /) are fused into
+	 *       one map node of up to max_fused stages. It runs block by
+	 *       block in L1 sized buffers: forward reads its input and writes
+	 *       its output once, backward recomputes the intermediate stages
+	 *       of the block instead of storing them. A var naming a
+	 *       intermediate stage of a chain stays usable, it is recomputed
+	 *       from the chain input when used.
+	 *
+	 *       Binary operations broadcast, and their gradients are summed
+	 *       back over the broadcast axes in place. The leaves are read
+	 *       when evaluated, so parameters updated in place between steps
+	 *       are picked up by the next recording.
+	 */
+	template <typename _Value>
+	class tape {
+	public:
+		typedef _Value          value_type;
+		typedef tools::size_t   size_type;
+		typedef tensor<_Value>  tensor_type;
+		typedef var<_Value>     var_type;
+
+		tape() : m_size(0), m_evaluated(0) { }
+
+		tape(const tape&) = delete;
+		tape& operator=(const tape&) = delete;
+
+		/* a leaf gradients are computed for */
+		var_type variable(const tensor_type& value) { return _leaf(value, tape_op::leaf); }
+
+		/* a leaf without gradient, e.g. the samples */
+		var_type constant(const tensor_type& value) { return _leaf(value, tape_op::constant); }
+
+		const tensor_type& value(var_type v) {
+			const size_type index = _resolve(v);
+			_evaluate(index + 1);
+			return m_nodes[index].value;
+		}
+
+		/* d loss / d every node, loss must hold a single element */
+		void backward(var_type loss) {
+			const size_type root = _resolve(loss);
+			assert(1 == m_nodes[root].dims.size());
+			_evaluate(root + 1);
+
+			for (size_type i = 0; i <= root; ++i) {
+				_node& each = m_nodes[i];
+				if (!each.needs_grad) { continue; }
+				_acquire(each.grad, each.dims);
+				each.grad.fill(value_type(0));
+			}
+
+			if (!m_nodes[root].needs_grad) { return; }
+			m_nodes[root].grad.fill(value_type(1));
+
+			for (size_type i = root + 1; 0 < i; --i) { _backward(i - 1); }
+		}
+
+		/* after backward(): d loss / d v, zero if v does not reach the loss */
+		const tensor_type& gradient(var_type v) const {
+			assert(v.node < m_size && v.stage == m_nodes[v.node].chain_size);
+			assert(m_nodes[v.node].needs_grad);
+			return m_nodes[v.node].grad;
+		}
+
+		/* forgets the records, keeps the memory */
+		void reset() { m_size = 0; m_evaluated = 0; }
+
+		size_type size() const { return m_size; }
+
+		/* recording, what the operators on var below call */
+
+		var_type record_unary(var_type v, unary_op kind, value_type a = value_type(1), value_type b = value_type(0)) {
+			assert(this == v.owner);
+			const _stage<value_type> stage { kind, a, b };
+
+			_node& source = m_nodes[v.node];
+			if (tape_op::map == source.op && v.stage == source.chain_size &&
+			    0 == source.consumers && m_evaluated <= v.node && source.chain_size < max_fused) {
+				source.chain[source.chain_size++] = stage;
+				return var_type { this, v.node, source.chain_size };
+			}
+
+			const size_type input = _use(v);
+			const size_type index = _push(tape_op::map, input, input, m_nodes[input].dims);
+			_node& node = m_nodes[index];
+			node.chain[0] = stage;
+			node.chain_size = 1;
+			return var_type { this, index, 1 };
+		}
+
+		var_type record_binary(tape_op op, var_type a, var_type b) {
+			assert(this == a.owner && this == b.owner);
+			const size_type lhs = _use(a), rhs = _use(b);
+
+			shape dims;
+			const bool compatible = broadcast_shape(m_nodes[lhs].dims, m_nodes[rhs].dims, dims);
+			assert(compatible); (void) compatible;
+
+			return var_type { this, _push(op, lhs, rhs, dims), 0 };
+		}
+
+		var_type record_matmul(var_type a, var_type b) {
+			assert(this == a.owner && this == b.owner);
+			const size_type lhs = _use(a), rhs = _use(b);
+			const shape& da = m_nodes[lhs].dims;
+			const shape& db = m_nodes[rhs].dims;
+			assert(2 == da.rank() && 2 == db.rank() && da[1] == db[0]);
+
+			return var_type { this, _push(tape_op::matmul, lhs, rhs, shape { da[0], db[1] }), 0 };
+		}
+
+		/* sum or mean of all the elements, a rank 0 result */
+		var_type record_reduce(tape_op op, var_type a) {
+			assert(this == a.owner && (tape_op::sum == op || tape_op::mean == op));
+			const size_type input = _use(a);
+			return var_type { this, _push(op, input, input, shape()), 0 };
+		}
+
+	private:
+		struct _node {
+			tape_op            op;
+			size_type          lhs, rhs;
+			size_type          consumers;
+			bool               needs_grad;
+			shape              dims;
+			tensor_type        value, grad;
+			_stage<value_type> chain[max_fused];
+			size_type          chain_size;
+		};
+
+		/* a buffer of dims in slot, the old one when the tape owns it alone */
+		static void _acquire(tensor_type& slot, const shape& dims) {
+			if (!slot.empty() && slot.unique() && slot.shape() == dims && slot.contiguous()) { return; }
+			slot = tensor_type(dims);
+		}
+
+		size_type _push(tape_op op, size_type lhs, size_type rhs, const shape& dims) {
+			if (m_nodes.size() == m_size) { m_nodes.emplace_back(); }
+
+			_node& node = m_nodes[m_size];
+			node.op         = op;
+			node.lhs        = lhs;
+			node.rhs        = rhs;
+			node.consumers  = 0;
+			node.dims       = dims;
+			node.chain_size = 0;
+			node.needs_grad = tape_op::leaf == op || (
+				tape_op::constant != op && (m_nodes[lhs].needs_grad || m_nodes[rhs].needs_grad)
+			);
+			return m_size++;
+		}
+
+		var_type _leaf(const tensor_type& value, tape_op op) {
+			const size_type index = _push(op, 0, 0, value.shape());
+			m_nodes[index].value = value;
+			return var_type { this, index, 0 };
+		}
+
+		/* the node holding v, a recomputed prefix of a chain if v names one */
+		size_type _resolve(var_type v) {
+			assert(this == v.owner && v.node < m_size);
+			const _node& node = m_nodes[v.node];
+			if (v.stage == node.chain_size) { return v.node; }
+
+			assert(tape_op::map == node.op && 0 < v.stage && v.stage < node.chain_size);
+			const size_type input = node.lhs;
+			++m_nodes[input].consumers;
+
+			const size_type index = _push(tape_op::map, input, input, m_nodes[input].dims);
+			for (size_type i = 0; i < v.stage; ++i) { m_nodes[index].chain[i] = m_nodes[v.node].chain[i]; }
+			m_nodes[index].chain_size = v.stage;
+			return index;
+		}
+
+		size_type _use(var_type v) {
+			const size_type index = _resolve(v);
+			++m_nodes[index].consumers;
+			return index;
+		}
+
+		void _evaluate(size_type last) {
+			for (; m_evaluated < last; ++m_evaluated) { _forward(m_evaluated); }
+		}
+
+		void _forward(size_type index) {
+			_node& node = m_nodes[index];
+			if (tape_op::leaf == node.op || tape_op::constant == node.op) { return; }
+
+			_acquire(node.value, node.dims);
+			tensor_type& out = node.value;
+			const tensor_type& a = m_nodes[node.lhs].value;
+			const tensor_type& b = m_nodes[node.rhs].value;
+
+			switch (node.op) {
+				case tape_op::map : {
+					const tensor_type src = a.compact();
+					const value_type* in = src.data();
+					value_type* dst = out.data();
+					const size_type n = node.dims.size();
+					for (size_type first = 0; first < n; first += _fusion_block) {
+						const size_type count = n - first < _fusion_block ? n - first : _fusion_block;
+						_stage_forward(node.chain[0], in + first, count, dst + first);
+						for (size_type k = 1; k < node.chain_size; ++k) {
+							_stage_forward(node.chain[k], dst + first, count, dst + first);
+						}
+					}
+					break;
+				}
+				case tape_op::add : {
+					_for_each(node.dims, out, a, b, b, [](value_type& r, value_type x, value_type y, value_type) { r = x + y; });
+					break;
+				}
+				case tape_op::sub : {
+					_for_each(node.dims, out, a, b, b, [](value_type& r, value_type x, value_type y, value_type) { r = x - y; });
+					break;
+				}
+				case tape_op::mul : {
+					_for_each(node.dims, out, a, b, b, [](value_type& r, value_type x, value_type y, value_type) { r = x * y; });
+					break;
+				}
+				case tape_op::div : {
+					_for_each(node.dims, out, a, b, b, [](value_type& r, value_type x, value_type y, value_type) { r = x / y; });
+					break;
+				}
+				case tape_op::matmul : {
+					out.fill(value_type(0));
+					_gemm_add(out, a, b);
+					break;
+				}
+				case tape_op::sum : {
+					out.data()[0] = ml::sum(a);
+					break;
+				}
+				case tape_op::mean : {
+					out.data()[0] = ml::sum(a) / (value_type) a.size();
+					break;
+				}
+				default : { break; }
+			}
+		}
+
+		void _backward(size_type index) {
+			_node& node = m_nodes[index];
+			if (!node.needs_grad || tape_op::leaf == node.op || tape_op::constant == node.op) { return; }
+
+			const tensor_type& g = node.grad;
+			_node& lhs = m_nodes[node.lhs];
+			_node& rhs = m_nodes[node.rhs];
+			const tensor_type& a = lhs.value;
+			const tensor_type& b = rhs.value;
+
+			switch (node.op) {
+				case tape_op::map : {
+					if (lhs.needs_grad) { _map_backward(node, lhs); }
+					break;
+				}
+				case tape_op::add : case tape_op::sub : {
+					const value_type sign = tape_op::add == node.op ? value_type(1) : value_type(-1);
+					if (lhs.needs_grad) {
+						_for_each(node.dims, lhs.grad, g, g, g, [](value_type& d, value_type dy, value_type, value_type) { d += dy; });
+					}
+					if (rhs.needs_grad) {
+						_for_each(node.dims, rhs.grad, g, g, g, [sign](value_type& d, value_type dy, value_type, value_type) { d += sign * dy; });
+					}
+					break;
+				}
+				case tape_op::mul : {
+					if (lhs.needs_grad) {
+						_for_each(node.dims, lhs.grad, g, b, b, [](value_type& d, value_type dy, value_type y, value_type) { d += dy * y; });
+					}
+					if (rhs.needs_grad) {
+						_for_each(node.dims, rhs.grad, g, a, a, [](value_type& d, value_type dy, value_type x, value_type) { d += dy * x; });
+					}
+					break;
+				}
+				case tape_op::div : {
+					if (lhs.needs_grad) {
+						_for_each(node.dims, lhs.grad, g, b, b, [](value_type& d, value_type dy, value_type y, value_type) { d += dy / y; });
+					}
+					if (rhs.needs_grad) {
+						_for_each(node.dims, rhs.grad, g, node.value, b, [](value_type& d, value_type dy, value_type r, value_type y) { d -= dy * r / y; });
+					}
+					break;
+				}
+				case tape_op::matmul : {
+					/* dA += G * B^T, dB += A^T * G */
+					if (lhs.needs_grad) { _gemm_add(lhs.grad, g, b.transpose()); }
+					if (rhs.needs_grad) { _gemm_add(rhs.grad, a.transpose(), g); }
+					break;
+				}
+				case tape_op::sum : case tape_op::mean : {
+					if (lhs.needs_grad) {
+						const value_type dy = tape_op::sum == node.op ? g.data()[0] : g.data()[0] / (value_type) a.size();
+						lhs.grad += dy;
+					}
+					break;
+				}
+				default : { break; }
+			}
+		}
+
+		/* recomputes the chain block by block and pulls the gradient through it */
+		void _map_backward(const _node& node, _node& input) {
+			const tensor_type src = input.value.compact();
+			const value_type* in = src.data();
+			const value_type* g = node.grad.data();
+			value_type* d_in = input.grad.data();
+
+			value_type stages[max_fused][_fusion_block];
+			value_type d[_fusion_block];
+
+			const size_type n = node.dims.size();
+			const size_type last = node.chain_size - 1;
+			for (size_type first = 0; first < n; first += _fusion_block) {
+				const size_type count = n - first < _fusion_block ? n - first : _fusion_block;
+				const value_type* x = in + first;
+
+				/* stages[k] holds the output of stage k, the last one is node.value */
+				for (size_type k = 0; k < last; ++k) {
+					_stage_forward(node.chain[k], 0 == k ? x : stages[k - 1], count, stages[k]);
+				}
+				const value_type* y_last = node.value.data() + first;
+
+				for (size_type i = 0; i < count; ++i) { d[i] = g[first + i]; }
+				for (size_type k = node.chain_size; 0 < k; --k) {
+					const value_type* stage_in  = 1 == k ? x : stages[k - 2];
+					const value_type* stage_out = k - 1 == last ? y_last : stages[k - 1];
+					_stage_backward(node.chain[k - 1], stage_in, stage_out, count, d);
+				}
+
+				value_type* out = d_in + first;
+				for (size_type i = 0; i < count; ++i) { out[i] += d[i]; }
+			}
+		}
+
+		std::vector<_node> m_nodes;
+		size_type          m_size;
+		size_type          m_evaluated;
+	};
+
+	/* operators recording on the tape of their operands */
+
+	template <typename _Value>
+	var<_Value> operator+(var<_Value> a, var<_Value> b) { return a.owner->record_binary(tape_op::add, a, b); }
+
+	template <typename _Value>
+	var<_Value> operator-(var<_Value> a, var<_Value> b) { return a.owner->record_binary(tape_op::sub, a, b); }
+
+	template <typename _Value>
+	var<_Value> operator*(var<_Value> a, var<_Value> b) { return a.owner->record_binary(tape_op::mul, a, b); }
+
+	template <typename _Value>
+	var<_Value> operator/(var<_Value> a, var<_Value> b) { return a.owner->record_binary(tape_op::div, a, b); }
+
+	template <typename _Value>
+	var<_Value> operator+(var<_Value> a, typename tape<_Value>::value_type s) {
+		return a.owner->record_unary(a, unary_op::affine, _Value(1), s);
+	}
+
+	template <typename _Value>
+	var<_Value> operator-(var<_Value> a, typename tape<_Value>::value_type s) {
+		return a.owner->record_unary(a, unary_op::affine, _Value(1), -s);
+	}
+
+	template <typename _Value>
+	var<_Value> operator*(var<_Value> a, typename tape<_Value>::value_type s) {
+		return a.owner->record_unary(a, unary_op::affine, s, _Value(0));
+	}
+
+	template <typename _Value>
+	var<_Value> operator/(var<_Value> a, typename tape<_Value>::value_type s) {
+		return a.owner->record_unary(a, unary_op::affine, _Value(1) / s, _Value(0));
+	}
+
+	template <typename _Value>
+	var<_Value> operator+(typename tape<_Value>::value_type s, var<_Value> a) { return a + s; }
+
+	template <typename _Value>
+	var<_Value> operator-(typename tape<_Value>::value_type s, var<_Value> a) {
+		return a.owner->record_unary(a, unary_op::affine, _Value(-1), s);
+	}
+
+	template <typename _Value>
+	var<_Value> operator*(typename tape<_Value>::value_type s, var<_Value> a) { return a * s; }
+
+	template <typename _Value>
+	var<_Value> operator/(typename tape<_Value>::value_type s, var<_Value> a) {
+		return a.owner->record_unary(a.owner->record_unary(a, unary_op::reciprocal), unary_op::affine, s, _Value(0));
+	}
+
+	template <typename _Value>
+	var<_Value> operator-(var<_Value> a) { return a.owner->record_unary(a, unary_op::affine, _Value(-1), _Value(0)); }
+
+	template <typename _Value>
+	var<_Value> square(var<_Value> a) { return a.owner->record_unary(a, unary_op::square); }
+
+	template <typename _Value>
+	var<_Value> exp(var<_Value> a) { return a.owner->record_unary(a, unary_op::exp); }
+
+	template <typename _Value>
+	var<_Value> log(var<_Value> a) { return a.owner->record_unary(a, unary_op::log); }
+
+	template <typename _Value>
+	var<_Value> sigmoid(var<_Value> a) { return a.owner->record_unary(a, unary_op::sigmoid); }
+
+	template <typename _Value>
+	var<_Value> tanh(var<_Value> a) { return a.owner->record_unary(a, unary_op::tanh); }
+
+	template <typename _Value>
+	var<_Value> relu(var<_Value> a) { return a.owner->record_unary(a, unary_op::relu); }
+
+	template <typename _Value>
+	var<_Value> matmul(var<_Value> a, var<_Value> b) { return a.owner->record_matmul(a, b); }
+
+	template <typename _Value>
+	var<_Value> sum(var<_Value> a) { return a.owner->record_reduce(tape_op::sum, a); }
+
+	template <typename _Value>
+	var<_Value> mean(var<_Value> a) { return a.owner->record_reduce(tape_op::mean, a); }
+}
+
+#endif //_AUTODIFF_H_
@@ -8,8 +8,22 @@
 #include <vector>
 #include <list>
 #include <cassert>
+#include <algorithm>
+#include <exception>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <ostream>
+#include <stdexcept>
+#include <unordered_set>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../common/defines.h"
+#include "../common/parallel.h"
+#include "../common/trace.h"
 
 namespace ml {
 
@@ -47,7 +61,7 @@ namespace ml {
 	) {
 		typedef typename _Constraint::value_type val_t1;
 		typedef typename _Candidate::value_type  val_t2;
-		static_assert(std::is_same<val_t1, val_t2>::value);
+		static_assert(std::is_same<val_t1, val_t2>::value, "");
 
 		const auto nil = meta_info<val_t1>::nil;
 		const auto all = meta_info<val_t1>::all;
@@ -83,7 +97,7 @@ namespace ml {
 	) {
 		typedef typename _Constraint::value_type val_t1;
 		typedef typename _Candidate::value_type  val_t2;
-		static_assert(std::is_same<val_t1, val_t2>::value);
+		static_assert(std::is_same<val_t1, val_t2>::value, "");
 
 		const auto nil = meta_info<val_t1>::nil;
 		const auto all = meta_info<val_t1>::all;
@@ -99,83 +113,427 @@ namespace ml {
 		}
 	}
 
-	template <typename _EnumTp>
-	class version_space {
+	/* a rule or a candidate as allowed-value bitmasks, see rule_layout */
+	typedef std::vector<tools::uint64_t> packed_rule;
+
+	/* every value b allows, a allows too: a is at least as general as b, or a matches the candidate b */
+	inline bool covers(const packed_rule& a, const packed_rule& b) {
+		assert(a.size() == b.size());
+		const tools::size_t words = a.size();
+		for (tools::size_t w = 0; w < words; ++w) {
+			if (0 != (b[w] & ~a[w])) { return false; }
+		}
+		return true;
+	}
+
+	struct packed_rule_hash {
+		tools::size_t operator()(const packed_rule& rule) const {
+			tools::uint64_t h = 0x9e3779b97f4a7c15ull;
+			for (auto word : rule) {
+				h ^= word + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+				h *= 0xff51afd7ed558ccdull;
+			}
+			return h ^ (h >> 33);
+		}
+	};
 
-		typedef constraint<_EnumTp> rule_type;
-		typedef sample<_EnumTp>     sample_type;
-		typedef meta_info<_EnumTp>  meta_info;
-		typedef meta<_EnumTp>       meta_type;
-		typedef _EnumTp             value_type;
+	/**
+	 * @note covers(rule, candidate) for a candidate packed into words
+	 *       of scratch, two words per SSE2 and-not. The misses of all
+	 *       words are or'ed before the one test, the rules are a few
+	 *       words long so a branch per word would cost more.
+	 */
+	inline bool covers(const packed_rule& rule, const tools::uint64_t* candidate) {
+		const tools::size_t words = rule.size();
+		tools::uint64_t miss = 0;
+		tools::size_t w = 0;
+#ifdef __SSE2__
+		__m128i misses = _mm_setzero_si128();
+		for (; w + 2 <= words; w += 2) {
+			const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidate + w));
+			misses = _mm_or_si128(misses, _mm_andnot_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rule.data() + w)), x));
+		}
+		alignas(16) tools::uint64_t lanes[2];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes), misses);
+		miss = lanes[0] | lanes[1];
+#endif
+		for (; w < words; ++w) { miss |= candidate[w] & ~rule[w]; }
+		return 0 == miss;
+	}
 
+	/* what the version space says of a candidate: every rule of it agrees, or they do not */
+	enum class vote { negative, positive, unknown };
+
+	/* bits allowed over all the fields, a rule covering another has at least as many */
+	inline tools::size_t allowed(const packed_rule& rule) {
+		tools::size_t count = 0;
+		for (auto word : rule) { count += __builtin_popcountll(word); }
+		return count;
+	}
+
+	/**
+	 * @note Where the attributes sit in a packed_rule: a field of
+	 *       limit + 1 bits per attribute, bit v allowing the value v and
+	 *       the top one the values beyond the limit, so `all` is the
+	 *       full field, nil the empty one and a value a single bit.
+	 *       Fields are packed into 64 bit words without straddling two,
+	 *       but for the fields wider than a word: such a field starts a
+	 *       word of its own and runs over as many as it needs, all of
+	 *       them full but the last. A candidate packs like a rule of
+	 *       single values, then consistency and generality both are
+	 *       covers(), and taking a positive candidate in is an or of the
+	 *       words. A value neither nil, all nor below the limit of its
+	 *       attribute throws std::out_of_range.
+	 */
+	template <typename _EnumTp>
+	class rule_layout {
 	public:
-		explicit version_space(const meta_type& limit) :
-			m_limit(limit) {
-			m_special.emplace_back(limit.size(), meta_info::nil);
-			m_general.emplace_back(limit.size(), meta_info::all);
+		typedef _EnumTp value_type;
+
+		explicit rule_layout(const meta<_EnumTp>& limit) :
+			m_limit(limit), m_word(limit.size()), m_first(limit.size()), m_span(limit.size()), m_field(limit.size()), m_words(0)
+		{
+			tools::size_t used = 64;
+			for (tools::size_t i = 0; i < limit.size(); ++i) {
+				if (!(0 < limit[i])) { throw std::invalid_argument("The limit of an attribute must be positive."); }
+				const tools::size_t width = (tools::size_t) limit[i] + 1;
+
+				if (64 < used + width) { ++m_words; used = 0; }
+				m_word[i] = m_words - 1;
+				m_first[i] = 64 * m_word[i] + used;
+				m_span[i] = (used + width + 63) / 64;
+				m_words += m_span[i] - 1;
+
+				/* the bits of the field in its last word end at `last` */
+				const tools::size_t last = used + width - 64 * (m_span[i] - 1);
+				m_field[i] = (64 == last ? ~0ull : (1ull << last) - 1) & ~((1ull << used) - 1);
+				used = last;
+			}
+
+			m_owner.assign(m_words * 64, (tools::uint32_t) limit.size());
+			m_full.assign(m_words, 0);
+			for (tools::size_t i = 0; i < limit.size(); ++i) {
+				for (tools::size_t b = 0; b <= (tools::size_t) limit[i]; ++b) { m_owner[m_first[i] + b] = (tools::uint32_t) i; }
+				for (tools::size_t k = 0; k < m_span[i]; ++k) { m_full[m_word[i] + k] |= _field(i, k); }
+			}
 		}
 
-		void fit(const sample_type& s) {
-			if (s.second) {
-				// this is a positive sample
-				m_general.remove_if([&s](const rule_type& r) { return !consistent(r, s.first); });
+		tools::size_t attributes() const { return m_limit.size(); }
+		tools::size_t words() const { return m_words; }
+		const meta<_EnumTp>& limit() const { return m_limit; }
 
-				for (auto& each : m_special) {
-					do_if_mismatch(each, s.first, &generalize);
+		/* the most general rule, all everywhere, and the most special one, nil everywhere */
+		packed_rule general() const { return m_full; }
+		packed_rule special() const { return packed_rule(m_words, 0); }
+
+		/* a rule or a candidate, whose values are nil, all or below the limits */
+		template <typename _Constraint>
+		packed_rule pack(const _Constraint& rule) const {
+			packed_rule result(m_words);
+			pack(rule, result.data());
+			return result;
+		}
+
+		/* the same into words out[0], ..., out[words() - 1] */
+		template <typename _Constraint>
+		void pack(const _Constraint& rule, tools::uint64_t* out) const {
+			assert(rule.size() == m_limit.size());
+
+			/* a bit or a field per attribute or'ed into words zeroed first, they are few and stay in L1 */
+			std::fill(out, out + m_words, 0);
+			for (tools::size_t i = 0; i < m_limit.size(); ++i) {
+				if (_valid(i, rule[i])) { out[_word(i, rule[i])] |= _bit(i, rule[i]); }
+				else if (meta_info<_EnumTp>::all == rule[i]) { _fill(out, i); }
+				else if (meta_info<_EnumTp>::nil != rule[i]) { _check(i, rule[i]); }
+			}
+		}
+
+		/* pack() of a candidate, one value per field and no nil or all to look for */
+		template <typename _Candidate>
+		void pack_candidate(const _Candidate& candidate, tools::uint64_t* out) const {
+			assert(candidate.size() == m_limit.size());
+
+			/* the attributes fill the words in order, a word is built in a register and stored once */
+			tools::uint64_t word = 0;
+			tools::size_t w = 0;
+			for (tools::size_t i = 0; i < m_limit.size(); ++i) {
+				_check(i, candidate[i]);
+				const tools::size_t at = _word(i, candidate[i]);
+				if (w != at) {
+					out[w] = word; word = 0;
+					while (++w != at) { out[w] = 0; }
 				}
+				word |= _bit(i, candidate[i]);
+			}
+			for (; w < m_words; ++w) { out[w] = word; word = 0; }
+		}
 
-				m_special.remove_if([this](const rule_type& r) {
-					for (auto& each : m_general) {
-						if (general_than(each, r)) { return false; }
-					}
-					return true;
-				});
+		/* covers(rule, pack(candidate)) without packing, stopping at the first value the rule does not allow */
+		template <typename _Candidate>
+		bool covers_candidate(const packed_rule& rule, const _Candidate& candidate) const {
+			assert(rule.size() == m_words && candidate.size() == m_limit.size());
+
+			for (tools::size_t i = 0; i < m_limit.size(); ++i) {
+				_check(i, candidate[i]);
+				if (0 == (rule[_word(i, candidate[i])] & _bit(i, candidate[i]))) { return false; }
 			}
-			else {
-				// this is a negative sample
+			return true;
+		}
+
+		constraint<_EnumTp> unpack(const packed_rule& rule) const {
+			assert(rule.size() == m_words);
+
+			constraint<_EnumTp> result(m_limit.size());
+			for (tools::size_t i = 0; i < m_limit.size(); ++i) {
+				bool empty = true, full = true;
+				tools::size_t value = 0;
+				for (tools::size_t k = 0; k < m_span[i]; ++k) {
+					const tools::uint64_t field = rule[m_word[i] + k] & _field(i, k);
+					full = full && _field(i, k) == field;
+					if (empty && 0 != field) { empty = false; value = 64 * (m_word[i] + k) + __builtin_ctzll(field) - m_first[i]; }
+				}
+				result[i] = empty ? meta_info<_EnumTp>::nil : full ? meta_info<_EnumTp>::all : (_EnumTp) value;
+			}
+			return result;
+		}
 
-				m_special.remove_if([&s](const rule_type& r) { return consistent(r, s.first); });
-
-				std::list<rule_type> tmp;
-				for (auto& each : m_general) {
-					if (consistent(each, s.first)) {
-						auto num_of_attrs = m_limit.size();
-						for (size_t i = 0; i < num_of_attrs; ++i) {
-							for (_EnumTp e = 0; e < m_limit[i]; ++e) {
-								if (s.first[i] == e) { continue; }
-								rule_type r(each); r[i] = e;
-								tmp.emplace_back(std::move(r));
-							}
-						}
+		/**
+		 * @note The least generalization of rule that covers the
+		 *       candidate: nil fields take the candidate's value and a
+		 *       field holding another value becomes all. An or of the
+		 *       words, then only the fields of the mismatching bits are
+		 *       looked at, there are few once the rule has settled. The
+		 *       candidate holds one value of a field or all of it, so of
+		 *       a wide field only word w may have been or'ed yet, or it
+		 *       ends up full anyway.
+		 */
+		void generalize(packed_rule& rule, const packed_rule& candidate) const {
+			assert(rule.size() == m_words && candidate.size() == m_words);
+
+			for (tools::size_t w = 0; w < m_words; ++w) {
+				tools::uint64_t mismatch = candidate[w] & ~rule[w];
+				const tools::uint64_t before = rule[w];
+				rule[w] |= candidate[w];
+
+				for (; 0 != mismatch; mismatch &= mismatch - 1) {
+					const tools::size_t i = m_owner[w * 64 + __builtin_ctzll(mismatch)];
+
+					tools::uint64_t held = 0;
+					for (tools::size_t k = 0; k < m_span[i]; ++k) {
+						const tools::size_t at = m_word[i] + k;
+						held |= (at == w ? before : rule[at]) & _field(i, k);
 					}
-					else { tmp.emplace_back(std::move(each)); }
+					if (0 != held) { _fill(rule.data(), i); }
 				}
+			}
+		}
 
-				m_general.swap(tmp);
+		/* the most general rule covered by both, false when a field of it allows nothing */
+		bool intersect(packed_rule& rule, const packed_rule& other) const {
+			assert(rule.size() == m_words && other.size() == m_words);
 
-				m_general.remove_if([this](const rule_type& r) {
-					for (auto & each : m_special) {
-						if (general_than(r, each)) { return false; }
-					}
-					return true;
-				});
+			for (tools::size_t w = 0; w < m_words; ++w) { rule[w] &= other[w]; }
+			for (tools::size_t i = 0; i < m_limit.size(); ++i) {
+				tools::uint64_t field = 0;
+				for (tools::size_t k = 0; k < m_span[i]; ++k) { field |= rule[m_word[i] + k] & _field(i, k); }
+				if (0 == field) { return false; }
 			}
+			return true;
+		}
+
+		/**
+		 * @note op(specialization) for each least specialization of
+		 *       rule that excludes the candidate: an `all` field fixed to
+		 *       each of the other values. A field already holding the
+		 *       candidate's value has no specialization short of nil.
+		 */
+		template <typename _Op>
+		void specialize(const packed_rule& rule, const packed_rule& candidate, _Op op) const {
+			for (tools::size_t i = 0; i < m_limit.size(); ++i) {
+				bool full = true;
+				for (tools::size_t k = 0; full && k < m_span[i]; ++k) { full = _field(i, k) == (rule[m_word[i] + k] & _field(i, k)); }
+				if (!full) { continue; }
+
+				for (tools::size_t v = 0; v < (tools::size_t) m_limit[i]; ++v) {
+					const tools::size_t at = _word(i, (_EnumTp) v);
+					const tools::uint64_t bit = _bit(i, (_EnumTp) v);
+					if (0 != (candidate[at] & bit)) { continue; }
+
+					packed_rule result(rule);
+					for (tools::size_t k = 0; k < m_span[i]; ++k) { result[m_word[i] + k] &= ~_field(i, k); }
+					result[at] |= bit;
+					op(std::move(result));
+				}
+			}
+		}
+
+	private:
+		/* the bits of field i in its k-th word */
+		tools::uint64_t _field(tools::size_t i, tools::size_t k) const { return k + 1 < m_span[i] ? ~0ull : m_field[i]; }
+
+		void _fill(tools::uint64_t* rule, tools::size_t i) const {
+			for (tools::size_t k = 0; k < m_span[i]; ++k) { rule[m_word[i] + k] |= _field(i, k); }
+		}
+
+		/* a negative value, nil and all among them, wraps around to a huge one */
+		bool _valid(tools::size_t i, _EnumTp value) const { return (tools::size_t) value < (tools::size_t) m_limit[i]; }
+
+		void _check(tools::size_t i, _EnumTp value) const {
+			if (!_valid(i, value)) { throw std::out_of_range("A value is beyond the limit of its attribute."); }
+		}
+
+		/* the word and the bit of value in field i */
+		tools::size_t _word(tools::size_t i, _EnumTp value) const { return (m_first[i] + (tools::size_t) value) / 64; }
+		tools::uint64_t _bit(tools::size_t i, _EnumTp value) const { return 1ull << ((m_first[i] + (tools::size_t) value) % 64); }
+
+		meta<_EnumTp>                m_limit;
+		std::vector<tools::size_t>   m_word;    // first word of every field
+		std::vector<tools::size_t>   m_first;   // bit of value 0 of every field, over all the words
+		std::vector<tools::size_t>   m_span;    // words of every field
+		std::vector<tools::uint64_t> m_field;   // bits of every field in its last word
+		std::vector<tools::uint32_t> m_owner;   // attribute of every bit
+		packed_rule                  m_full;
+		tools::size_t                m_words;
+	};
+
+	/**
+	 * @note The boundaries are kept packed (rule_layout), so testing a
+	 *       rule against a sample or another rule is a few word-wide
+	 *       and-nots however many attributes there are.
+	 *
+	 *       G is kept free of duplicates and of rules less general than
+	 *       another one of G, as the specializations are filtered when
+	 *       they are made rather than pruned from a grown list: see
+	 *       _specialize.
+	 *
+	 *       With threads, fit_all fits chunks of the samples concurrently
+	 *       and merges their boundaries, and classify spreads runs of
+	 *       candidates over the threads; neither may be called while
+	 *       another call is running on the same space. Nor may the
+	 *       rules be read then, they are unpacked on the first read
+	 *       after a fit.
+	 */
+	template <typename _EnumTp>
+	class version_space {
+
+		typedef constraint<_EnumTp>     rule_type;
+		typedef sample<_EnumTp>         sample_type;
+		typedef ml::meta_info<_EnumTp>  info_type;
+		typedef meta<_EnumTp>           meta_type;
+		typedef _EnumTp                 value_type;
+
+	public:
+		explicit version_space(const meta_type& limit) :
+			m_limit(limit), m_layout(limit), m_unpacked(false), m_threads(1) {
+			m_special.push_back(m_layout.special());
+			m_general.push_back(m_layout.general());
+		}
+
+		/* threads specializing G on a negative sample, the caller's included */
+		size_t threads() const { return m_threads; }
+		void set_threads(size_t threads) {
+			m_threads = 0 == threads ? 1 : threads;
+			m_pool.reset(1 < m_threads ? new tools::thread_pool(m_threads) : nullptr);
 		}
 
+		void fit(const sample_type& s) {
+			_fit(m_layout.pack(s.first), s.second);
+			m_unpacked = false;
+		}
+
+		/**
+		 * @note The samples in one go. The boundaries the space ends
+		 *       with do not depend on the order of the samples, which
+		 *       lets them be split into a chunk per thread:
+		 *
+		 *       - S is the least generalization of the positives, one
+		 *         per chunk merged by generalize, and it must cover no
+		 *         negative, of the batch or fitted before (then no rule
+		 *         of G covers it), else the space collapses;
+		 *       - G is what it was less the rules not covering the new S,
+		 *         merged with the G of every chunk, which is fitted to
+		 *         the negatives of the chunk from the new S already: the
+		 *         merge keeps the maximal intersections of two rules
+		 *         that still cover S.
+		 *
+		 *       A batch without any positive, or collapsing the space,
+		 *       is fitted sample by sample instead.
+		 */
 		template <typename _SampleItr>
 		void fit_all(_SampleItr first, _SampleItr last) {
-			while (first != last) {
-				this->fit(*first);
-				++first;
+			std::vector<packed_rule> xs;
+			std::vector<bool> labels;
+			for (; first != last; ++first) {
+				xs.push_back(m_layout.pack(first->first));
+				labels.push_back(first->second);
+			}
+
+			if (!m_pool || xs.size() < 2 * _chunk_samples || m_special.empty() || !_fit_chunks(xs, labels)) {
+				for (size_t k = 0; k < xs.size(); ++k) { _fit(xs[k], labels[k]); }
+			}
+			m_unpacked = false;
+		}
+
+		/* what every rule between S and G says of each candidate */
+		template <typename _CandidateItr>
+		std::vector<vote> classify(_CandidateItr first, _CandidateItr last) const {
+			TOOLS_TRACE_SCOPE("version_space::classify");
+			const size_t n = (size_t) std::distance(first, last);
+			const size_t tasks = m_pool ? std::max<size_t>(1, std::min<size_t>(m_pool->size(), n / _classify_block)) : 1;
+			std::vector<vote> result(n);
+
+			/**
+			 * A task takes a run of candidates. Against a few rules a
+			 * candidate is tested value by value, stopping at its first
+			 * mismatch, otherwise it is packed once into the task's
+			 * scratch and tested a rule at a time. Either way S is left
+			 * at its first rule missing it and G at its first covering.
+			 */
+			auto op = [this, first, &result, n, tasks](size_t task) {
+				const size_t begin = task * n / tasks, end = (task + 1) * n / tasks;
+				const bool direct = m_special.size() + m_general.size() < _packed_rules;
+				packed_rule scratch(direct ? 0 : m_layout.words());
+
+				_CandidateItr itr = std::next(first, begin);
+				for (size_t k = begin; k < end; ++k, ++itr) {
+					auto covered = [this, direct, &scratch, &itr](const packed_rule& rule) {
+						return direct ? m_layout.covers_candidate(rule, *itr) : covers(rule, scratch.data());
+					};
+					if (!direct) { m_layout.pack_candidate(*itr, scratch.data()); }
+
+					bool positive = !m_special.empty(), negative = true;
+					for (auto it = m_special.begin(); positive && it != m_special.end(); ++it) { positive = covered(*it); }
+					for (auto it = m_general.begin(); !positive && negative && it != m_general.end(); ++it) { negative = !covered(*it); }
+					result[k] = positive ? vote::positive : negative ? vote::negative : vote::unknown;
+				}
+			};
+
+			/* a value beyond its limit throws in a task, it is thrown again on the caller's thread */
+			if (1 < tasks) {
+				std::vector<std::exception_ptr> errors(tasks);
+				m_pool->run(tasks, [&op, &errors](size_t task) {
+					try { op(task); }
+					catch (...) { errors[task] = std::current_exception(); }
+				});
+				for (auto& each : errors) { if (each) { std::rethrow_exception(each); } }
 			}
+			else if (0 < n) { op(0); }
+			return result;
 		}
 
-		const std::list<rule_type>& general_rules() const { return m_general; }
-		const std::list<rule_type>& special_rules() const { return m_special; }
+		vote classify(const candidate<_EnumTp>& c) const {
+			const std::vector<candidate<_EnumTp>> one(1, c);
+			return classify(one.begin(), one.end())[0];
+		}
+
+		const std::list<rule_type>& general_rules() const { _unpack(); return m_general_rules; }
+		const std::list<rule_type>& special_rules() const { _unpack(); return m_special_rules; }
+
+		const rule_layout<_EnumTp>& layout() const { return m_layout; }
 
 		void print(std::ostream& stream) const {
 			stream << "Version Space - Special Rules" << std::endl;
-			for (auto& rule : m_special) {
+			for (auto& rule : special_rules()) {
 				for (auto& attr : rule) {
 					stream << attr << ",";
 				}
@@ -183,7 +541,7 @@ namespace ml {
 			}
 
 			stream << "Version Space - General Rules" << std::endl;
-			for (auto& rule : m_general) {
+			for (auto& rule : general_rules()) {
 				for (auto& attr : rule) {
 					stream << attr << ",";
 				}
@@ -192,25 +550,205 @@ namespace ml {
 		}
 
 	private:
-		static value_type generalize(
-			const value_type& constraint, const value_type& candidate
-		) {
-			if (meta_info::nil == constraint) {
-				return candidate;
+		void _fit(const packed_rule& x, bool positive) {
+			if (positive) {
+				// this is a positive sample
+				m_general.remove_if([&x](const packed_rule& r) { return !covers(r, x); });
+
+				for (auto& each : m_special) {
+					m_layout.generalize(each, x);
+				}
+
+				m_special.remove_if([this](const packed_rule& r) {
+					for (auto& each : m_general) {
+						if (covers(each, r)) { return false; }
+					}
+					return true;
+				});
 			}
-			if (
-				meta_info::all == constraint ||
-			         candidate != constraint
-			) { return meta_info::all; }
-			return candidate;
+			else {
+				// this is a negative sample
+
+				m_special.remove_if([&x](const packed_rule& r) { return covers(r, x); });
+				_specialize(x, m_special, m_general, m_pool.get());
+			}
+		}
+
+		/* fit_all on the pool, false when the batch has to be fitted sample by sample */
+		bool _fit_chunks(const std::vector<packed_rule>& xs, const std::vector<bool>& labels) {
+			TOOLS_TRACE_SCOPE("version_space::_fit_chunks");
+			const size_t n = xs.size();
+			const size_t chunks = std::min<size_t>(m_pool->size(), n / _chunk_samples);
+			auto range = [n, chunks](size_t c) { return std::make_pair(c * n / chunks, (c + 1) * n / chunks); };
+
+			std::vector<packed_rule> lgg(chunks, m_layout.special());
+			m_pool->run(chunks, [this, &xs, &labels, &lgg, &range](size_t c) {
+				for (size_t k = range(c).first; k < range(c).second; ++k) {
+					if (labels[k]) { m_layout.generalize(lgg[c], xs[k]); }
+				}
+			});
+
+			packed_rule special = m_special.front();
+			for (auto& each : lgg) { m_layout.generalize(special, each); }
+			if (0 == allowed(special)) { return false; }
+
+			std::vector<tools::uint8_t> collapsed(chunks, 0);
+			m_pool->run(chunks, [&xs, &labels, &special, &collapsed, &range](size_t c) {
+				for (size_t k = range(c).first; k < range(c).second && 0 == collapsed[c]; ++k) {
+					if (!labels[k] && covers(special, xs[k])) { collapsed[c] = 1; }
+				}
+			});
+			for (auto each : collapsed) { if (0 != each) { return false; } }
+
+			/* a negative fitted before the batch may be covered too, then no rule of G is left over the new S */
+			std::list<packed_rule> kept(m_general);
+			kept.remove_if([&special](const packed_rule& r) { return !covers(r, special); });
+			if (kept.empty()) { return false; }
+
+			const std::list<packed_rule> boundary(1, special);
+			std::vector<std::list<packed_rule>> general(chunks, std::list<packed_rule>(1, m_layout.general()));
+			m_pool->run(chunks, [this, &xs, &labels, &boundary, &general, &range](size_t c) {
+				for (size_t k = range(c).first; k < range(c).second; ++k) {
+					if (!labels[k]) { _specialize(xs[k], boundary, general[c], nullptr); }
+				}
+			});
+
+			m_general.swap(kept);
+			for (auto& each : general) { _merge(m_general, each, special); }
+			m_special = boundary;
+			return true;
 		}
 
+		/* the maximal intersections of a rule of general and one of other covering special, into general */
+		void _merge(std::list<packed_rule>& general, const std::list<packed_rule>& other, const packed_rule& special) const {
+			std::vector<packed_rule> meets;
+			for (auto& a : general) {
+				for (auto& b : other) {
+					packed_rule meet(a);
+					if (m_layout.intersect(meet, b) && covers(meet, special)) { meets.push_back(std::move(meet)); }
+				}
+			}
+
+			general.clear();
+			_take_maximal(meets, general);
+		}
+
+		/* the rules no other covers, without duplicates, from the most general down into out */
+		static void _take_maximal(std::vector<packed_rule>& rules, std::list<packed_rule>& out) {
+			std::vector<std::pair<tools::size_t, packed_rule*>> order;
+			for (auto& each : rules) { order.emplace_back(allowed(each), &each); }
+			std::stable_sort(order.begin(), order.end(),
+				[](const std::pair<tools::size_t, packed_rule*>& a, const std::pair<tools::size_t, packed_rule*>& b) {
+					return a.first > b.first;
+				}
+			);
+
+			std::unordered_set<packed_rule, packed_rule_hash> seen;
+			std::vector<packed_rule*> taken;
+			for (auto& each : order) {
+				if (!seen.insert(*each.second).second) { continue; }
+
+				bool covered = false;
+				for (auto r : taken) {
+					if (covers(*r, *each.second)) { covered = true; break; }
+				}
+				if (!covered) { taken.push_back(each.second); }
+			}
+
+			for (auto r : taken) { out.push_back(std::move(*r)); }
+		}
+
+		/**
+		 * @note G on a negative sample x. The rules not covering x stay
+		 *       as they are, each one covering it is replaced by its
+		 *       least specializations, of which a child is kept only if
+		 *       it is still more general than some rule of S and no
+		 *       staying rule covers it. The staying rules are the only
+		 *       ones a child need be tested against from there on: none
+		 *       of them is covered by a child, which would mean it was
+		 *       covered by the child's parent in G already.
+		 *
+		 *       The rules covering x are specialized concurrently, each
+		 *       into its own list. The children are then merged from the
+		 *       most general down, through a hash set for the duplicates
+		 *       several parents give, and each is dropped if one already
+		 *       taken covers it, so G stays maximal.
+		 */
+		void _specialize(
+			const packed_rule& x, const std::list<packed_rule>& special, std::list<packed_rule>& general, tools::thread_pool* pool
+		) const {
+			std::vector<packed_rule> parents, kept;
+			for (auto& each : general) {
+				if (covers(each, x)) { parents.push_back(std::move(each)); }
+				else { kept.push_back(std::move(each)); }
+			}
+			general.clear();
+			for (auto& each : kept) { general.push_back(each); }
+			if (parents.empty()) { return; }
+
+			std::vector<std::vector<packed_rule>> children(parents.size());
+			auto op = [this, &x, &special, &parents, &kept, &children](size_t k) {
+				m_layout.specialize(parents[k], x, [&special, &kept, &children, k](packed_rule&& r) {
+					for (auto& each : kept) {
+						if (covers(each, r)) { return; }
+					}
+					for (auto& each : special) {
+						if (covers(r, each)) { children[k].push_back(std::move(r)); return; }
+					}
+				});
+			};
+
+			if (pool && _parallel_rules <= parents.size()) { pool->run(parents.size(), op); }
+			else { for (size_t k = 0; k < parents.size(); ++k) { op(k); } }
+
+			std::vector<packed_rule> all;
+			for (auto& list : children) {
+				for (auto& each : list) { all.push_back(std::move(each)); }
+			}
+			_take_maximal(all, general);
+		}
+
+		void _unpack() const {
+			if (m_unpacked) { return; }
+
+			m_general_rules.clear();
+			m_special_rules.clear();
+			for (auto& each : m_general) { m_general_rules.push_back(m_layout.unpack(each)); }
+			for (auto& each : m_special) { m_special_rules.push_back(m_layout.unpack(each)); }
+			m_unpacked = true;
+		}
 
 	private:
-		const meta_type      m_limit;
-		std::list<rule_type> m_general;
-		std::list<rule_type> m_special; /* whether the size of m_special is equal to 1? */
+		const meta_type        m_limit;
+		rule_layout<_EnumTp>   m_layout;
+		std::list<packed_rule> m_general;
+		std::list<packed_rule> m_special; /* whether the size of m_special is equal to 1? */
+
+		/* the boundaries as rule vectors, for general_rules and special_rules */
+		mutable std::list<rule_type> m_general_rules;
+		mutable std::list<rule_type> m_special_rules;
+		mutable bool                 m_unpacked;
+
+		size_t                              m_threads;
+		std::unique_ptr<tools::thread_pool> m_pool;
+
+		static const size_t _parallel_rules = 16;
+		static const size_t _chunk_samples  = 4096;
+		static const size_t _classify_block = 256; // the fewest candidates a thread classifies
+		static const size_t _packed_rules   = 3;
 	};
+
+	template <typename _EnumTp>
+	const size_t version_space<_EnumTp>::_parallel_rules;
+
+	template <typename _EnumTp>
+	const size_t version_space<_EnumTp>::_chunk_samples;
+
+	template <typename _EnumTp>
+	const size_t version_space<_EnumTp>::_classify_block;
+
+	template <typename _EnumTp>
+	const size_t version_space<_EnumTp>::_packed_rules;
 }
 
 namespace std {
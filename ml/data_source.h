@@ -0,0 +1,195 @@
+/*
+ * Created by Maou Lim on 2019/7/16.
+ */
+
+#ifndef _DATA_SOURCE_H_
+#define _DATA_SOURCE_H_
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/defines.h"
+#include "../common/mapped_file.h"
+#include "../common/trace.h"
+
+namespace ml {
+
+	/**
+	 * @note Samples produced one at a time, for datasets that are not
+	 *       kept in memory. next() fills in the following sample and
+	 *       returns false at the end, rewind() starts a new pass.
+	 */
+	template <typename _Sample>
+	class data_source {
+	public:
+		typedef _Sample sample_type;
+
+		virtual ~data_source() = default;
+
+		virtual bool next(sample_type& sample) = 0;
+		virtual bool rewind() = 0;
+	};
+
+	/**
+	 * @note One sample per line of a text file, decoded by
+	 *       _Parser()(line_first, line_last, sample) -> bool; lines it
+	 *       rejects are skipped. The file is memory mapped and walked
+	 *       sequentially, so the kernel can drop pages already read and
+	 *       the file may be larger than RAM.
+	 */
+	template <typename _Sample, typename _Parser>
+	class line_source : public data_source<_Sample> {
+	public:
+		typedef _Sample sample_type;
+
+		explicit line_source(const std::string& path, _Parser parser = _Parser()) :
+			m_parser(parser), m_cursor(nullptr)
+		{
+			if (m_file.open(path)) { m_cursor = m_file.begin(); }
+		}
+
+		bool is_open() const { return m_file.is_open(); }
+
+		bool next(sample_type& sample) override {
+			const char* last = m_file.end();
+			while (nullptr != m_cursor && m_cursor != last) {
+				const char* line_end = static_cast<const char*>(
+					std::memchr(m_cursor, '\n', (tools::size_t) (last - m_cursor))
+				);
+				if (nullptr == line_end) { line_end = last; }
+
+				const char* line = m_cursor;
+				m_cursor = line_end == last ? last : line_end + 1;
+
+				if (line != line_end && m_parser(line, line_end, sample)) { return true; }
+			}
+			return false;
+		}
+
+		bool rewind() override {
+			if (!m_file.is_open()) { return false; }
+			m_cursor = m_file.begin();
+			return true;
+		}
+
+	private:
+		tools::mapped_file m_file;
+		_Parser            m_parser;
+		const char*        m_cursor;
+	};
+
+	/**
+	 * @note Reads batches from a data_source on a producer thread while
+	 *       the consumer works on the previous ones. At most `depth`
+	 *       filled batches wait in the queue, so memory stays bounded
+	 *       however large the source is; the batch containers are
+	 *       recycled (clear() keeps their storage) instead of being
+	 *       allocated per batch.
+	 *
+	 *       next() hands out the following batch and takes back the one
+	 *       it handed out before, nullptr marks the end of the pass.
+	 *       The source must not be touched elsewhere until the
+	 *       prefetcher is destroyed.
+	 */
+	template <typename _Container>
+	class prefetcher {
+	public:
+		typedef _Container                      container_type;
+		typedef typename _Container::value_type sample_type;
+
+		prefetcher(data_source<sample_type>& source, tools::size_t batch, tools::size_t depth = 2) :
+			m_source(source), m_batch(0 == batch ? 1 : batch),
+			m_buffers(0 == depth ? 2 : depth + 1), m_current(npos),
+			m_done(false), m_stop(false)
+		{
+			for (tools::size_t i = 0; i < m_buffers.size(); ++i) {
+				m_buffers[i].reserve(m_batch);
+				m_free.push_back(i);
+			}
+			m_producer = std::thread([this]() { _produce(); });
+		}
+
+		prefetcher(const prefetcher&) = delete;
+		prefetcher& operator=(const prefetcher&) = delete;
+
+		~prefetcher() {
+			{
+				std::lock_guard<std::mutex> guard(m_mutex);
+				m_stop = true;
+			}
+			m_has_free.notify_all();
+			m_producer.join();
+		}
+
+		const container_type* next() {
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (npos != m_current) {
+				m_free.push_back(m_current);
+				m_current = npos;
+				m_has_free.notify_one();
+			}
+
+			m_has_full.wait(lock, [this]() { return !m_full.empty() || m_done; });
+			if (m_full.empty()) { return nullptr; }
+
+			m_current = m_full.front();
+			m_full.pop_front();
+			return &m_buffers[m_current];
+		}
+
+	private:
+		static const tools::size_t npos = (tools::size_t) -1;
+
+		void _produce() {
+			sample_type sample;
+			bool exhausted = false;
+
+			while (!exhausted) {
+				tools::size_t slot;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_has_free.wait(lock, [this]() { return !m_free.empty() || m_stop; });
+					if (m_stop) { break; }
+					slot = m_free.front();
+					m_free.pop_front();
+				}
+
+				TOOLS_TRACE_SCOPE("data_source::_produce");
+				container_type& buffer = m_buffers[slot];
+				buffer.clear();
+				while (buffer.size() < m_batch && !(exhausted = !m_source.next(sample))) {
+					buffer.push_back(sample);
+				}
+
+				std::lock_guard<std::mutex> guard(m_mutex);
+				if (buffer.empty()) { m_free.push_back(slot); }
+				else { m_full.push_back(slot); }
+				m_has_full.notify_one();
+			}
+
+			std::lock_guard<std::mutex> guard(m_mutex);
+			m_done = true;
+			m_has_full.notify_all();
+		}
+
+		data_source<sample_type>&   m_source;
+		tools::size_t               m_batch;
+		std::vector<container_type> m_buffers;
+		tools::size_t               m_current;
+
+		std::deque<tools::size_t> m_free, m_full;
+		bool                      m_done, m_stop;
+
+		std::mutex              m_mutex;
+		std::condition_variable m_has_free, m_has_full;
+		std::thread             m_producer;
+	};
+}
+
+#endif //_DATA_SOURCE_H_
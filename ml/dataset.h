@@ -0,0 +1,478 @@
+/*
+ * Created by Maou Lim on 2019/7/10.
+ */
+
+#ifndef _DATASET_H_
+#define _DATASET_H_
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../common/defines.h"
+#include "../common/mapped_file.h"
+#include "../common/trace.h"
+#include "../container/matrix.h"
+
+namespace ml {
+
+	/**
+	 * @note Binary columnar dataset file, native byte order:
+	 *
+	 *         header (32 bytes)   "TBDS", version, rows, columns,
+	 *                             offset of the column table
+	 *         payloads            one per column, each starting on a
+	 *                             64 byte boundary
+	 *         column table        one 64 byte entry per column: name,
+	 *                             element type, codec, payload range
+	 *
+	 *       The table is written last so columns can be streamed out
+	 *       one at a time. Uncompressed columns are read straight from
+	 *       the mapping; adjacent columns of one type share a stride,
+	 *       which is what makes the zero-copy matrix_view possible.
+	 */
+	enum class column_type : tools::uint8_t {
+		int8, uint8, int32, uint32, int64, uint64, float32, float64
+	};
+
+	/**
+	 * @note none : the raw array.
+	 *       rle  : (uint32 run, value) records, for label or category
+	 *              columns with long runs. Decoded on first access.
+	 */
+	enum class column_codec : tools::uint8_t { none, rle };
+
+	template <typename _Tp>
+	struct column_type_of;
+
+	template <> struct column_type_of<tools::sint8_t>    { static constexpr column_type value = column_type::int8;    };
+	template <> struct column_type_of<tools::uint8_t>    { static constexpr column_type value = column_type::uint8;   };
+	template <> struct column_type_of<tools::sint32_t>   { static constexpr column_type value = column_type::int32;   };
+	template <> struct column_type_of<tools::uint32_t>   { static constexpr column_type value = column_type::uint32;  };
+	template <> struct column_type_of<tools::sint64_t>   { static constexpr column_type value = column_type::int64;   };
+	template <> struct column_type_of<tools::uint64_t>   { static constexpr column_type value = column_type::uint64;  };
+	template <> struct column_type_of<tools::float32_t>  { static constexpr column_type value = column_type::float32; };
+	template <> struct column_type_of<tools::float64_t>  { static constexpr column_type value = column_type::float64; };
+
+	constexpr tools::uint32_t _dataset_version = 1;
+	constexpr tools::size_t   _dataset_align   = 64;
+	constexpr tools::size_t   _dataset_name_sz = 40;
+
+	struct _dataset_header {
+		char            magic[4];
+		tools::uint32_t version;
+		tools::uint64_t rows;
+		tools::uint64_t columns;
+		tools::uint64_t table_offset;
+	};
+
+	struct _column_entry {
+		char            name[_dataset_name_sz];
+		column_type     type;
+		column_codec    codec;
+		tools::uint8_t  reserved[6];
+		tools::uint64_t offset;
+		tools::uint64_t bytes;
+	};
+
+	/* the most rows whose widest column still has a size_t byte count */
+	constexpr tools::size_t _max_rows = std::numeric_limits<tools::size_t>::max() / sizeof(tools::uint64_t);
+
+	static_assert(32 == sizeof(_dataset_header), "unexpected header layout.");
+	static_assert(64 == sizeof(_column_entry), "unexpected column entry layout.");
+
+	class dataset_writer {
+	public:
+		dataset_writer() : m_rows(0), m_offset(0) { }
+
+		dataset_writer(const std::string& path, tools::size_t rows) :
+			m_rows(0), m_offset(0) { open(path, rows); }
+
+		dataset_writer(const dataset_writer&) = delete;
+		dataset_writer& operator=(const dataset_writer&) = delete;
+
+		~dataset_writer() { close(); }
+
+		bool open(const std::string& path, tools::size_t rows) {
+			close();
+
+			/* every column is rows * (at most 8) bytes, that has to fit */
+			if (_max_rows < rows) { return false; }
+
+			m_file.open(path, std::ios::binary | std::ios::trunc);
+			if (!m_file) { return false; }
+
+			m_rows   = rows;
+			m_offset = 0;
+			m_entries.clear();
+
+			_dataset_header header;
+			std::memset(&header, 0, sizeof(header));
+			return _write(&header, sizeof(header));
+		}
+
+		bool is_open() const { return m_file.is_open(); }
+
+		/**
+		 * @note Appends one column of rows() values. A rle column that
+		 *       would not get smaller is stored raw instead.
+		 */
+		template <typename _Tp>
+		bool add_column(
+			const std::string& name,
+			const _Tp*         values,
+			column_codec       codec = column_codec::none
+		) {
+			assert(is_open());
+
+			_column_entry entry;
+			std::memset(&entry, 0, sizeof(entry));
+			std::strncpy(entry.name, name.c_str(), _dataset_name_sz - 1);
+			entry.type  = column_type_of<_Tp>::value;
+			entry.codec = column_codec::none;
+
+			if (!_pad()) { return false; }
+			entry.offset = m_offset;
+
+			const tools::size_t raw_bytes = m_rows * sizeof(_Tp);
+
+			if (column_codec::rle == codec) {
+				std::vector<char> encoded = _rle_encode(values, m_rows);
+				if (encoded.size() < raw_bytes) {
+					entry.codec = column_codec::rle;
+					entry.bytes = encoded.size();
+					m_entries.push_back(entry);
+					return _write(encoded.data(), encoded.size());
+				}
+			}
+
+			entry.bytes = raw_bytes;
+			m_entries.push_back(entry);
+			return _write(values, raw_bytes);
+		}
+
+		/* every column of mat, named prefix0, prefix1, ... */
+		template <typename _Tp, typename _Container>
+		bool add_columns(
+			const tools::matrix<_Tp, _Container>& mat,
+			const std::string&                    prefix = "x"
+		) {
+			assert(mat.rows() == m_rows);
+
+			std::vector<_Tp> column(m_rows);
+			for (tools::size_t c = 0; c < mat.cols(); ++c) {
+				for (tools::size_t r = 0; r < m_rows; ++r) { column[r] = mat(r, c); }
+				if (!add_column(prefix + std::to_string(c), column.data())) { return false; }
+			}
+			return true;
+		}
+
+		/* writes the column table and the header, the file is complete */
+		bool close() {
+			if (!m_file.is_open()) { return true; }
+
+			bool ok = _pad();
+
+			_dataset_header header;
+			std::memcpy(header.magic, "TBDS", 4);
+			header.version      = _dataset_version;
+			header.rows         = m_rows;
+			header.columns      = m_entries.size();
+			header.table_offset = m_offset;
+
+			if (!m_entries.empty()) {
+				ok = ok && _write(m_entries.data(), m_entries.size() * sizeof(_column_entry));
+			}
+
+			m_file.seekp(0);
+			ok = ok && m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)).good();
+
+			m_file.close();
+			return ok;
+		}
+
+	private:
+		bool _write(const void* data, tools::size_t bytes) {
+			m_file.write(static_cast<const char*>(data), (std::streamsize) bytes);
+			m_offset += bytes;
+			return m_file.good();
+		}
+
+		bool _pad() {
+			static const char zeros[_dataset_align] = { 0 };
+			const tools::size_t rest = m_offset % _dataset_align;
+			return 0 == rest || _write(zeros, _dataset_align - rest);
+		}
+
+		template <typename _Tp>
+		static std::vector<char> _rle_encode(const _Tp* values, tools::size_t n) {
+			const tools::size_t record = sizeof(tools::uint32_t) + sizeof(_Tp);
+
+			std::vector<char> encoded;
+			tools::size_t i = 0;
+			while (i < n) {
+				tools::uint32_t run = 1;
+				while (i + run < n && run < 0xffffffffu &&
+				       0 == std::memcmp(values + i + run, values + i, sizeof(_Tp))) { ++run; }
+
+				const tools::size_t at = encoded.size();
+				encoded.resize(at + record);
+				std::memcpy(encoded.data() + at, &run, sizeof(run));
+				std::memcpy(encoded.data() + at + sizeof(run), values + i, sizeof(_Tp));
+
+				i += run;
+				if (n * sizeof(_Tp) <= encoded.size()) { break; }
+			}
+			return encoded;
+		}
+
+		std::ofstream              m_file;
+		tools::size_t              m_rows;
+		tools::size_t              m_offset;
+		std::vector<_column_entry> m_entries;
+	};
+
+	template <typename _Feature, typename _Label>
+	struct labeled_sample {
+		tools::strided_view<_Feature> features;
+		_Label                        label;
+	};
+
+	/**
+	 * @note Rows of a feature matrix_view paired with a label column,
+	 *       both pointing into the dataset's mapping.
+	 */
+	template <typename _Feature, typename _Label>
+	class sample_view {
+	public:
+		typedef labeled_sample<_Feature, _Label> value_type;
+		typedef tools::size_t                    size_type;
+
+		sample_view() = default;
+
+		sample_view(
+			const tools::matrix_view<_Feature>& features,
+			const tools::strided_view<_Label>&  labels
+		) : m_features(features), m_labels(labels) {
+			assert(features.rows() == labels.size());
+		}
+
+		size_type size() const { return m_labels.size(); }
+
+		value_type operator[](size_type r) const {
+			return value_type { m_features.row(r), m_labels[r] };
+		}
+
+		const tools::matrix_view<_Feature>& features() const { return m_features; }
+		const tools::strided_view<_Label>&  labels()   const { return m_labels; }
+
+	private:
+		tools::matrix_view<_Feature> m_features;
+		tools::strided_view<_Label>  m_labels;
+	};
+
+	/**
+	 * @note Memory mapped reader. open() only validates the header and
+	 *       the column table, the payload pages are faulted in when they
+	 *       are touched, so opening costs the same for any file size.
+	 *       Compressed columns are decoded into a private buffer the
+	 *       first time they are asked for; that lazy decoding is the
+	 *       only part that is not safe to call from several threads.
+	 */
+	class dataset {
+	public:
+		dataset() : m_rows(0), m_entries(nullptr), m_columns(0) { }
+
+		explicit dataset(const std::string& path) :
+			m_rows(0), m_entries(nullptr), m_columns(0) { open(path); }
+
+		bool open(const std::string& path) {
+			close();
+			if (!m_file.open(path)) { return false; }
+			if (!_validate()) { close(); return false; }
+
+			m_decoded.resize(m_columns);
+			return true;
+		}
+
+		void close() {
+			m_file.close();
+			m_rows = 0; m_entries = nullptr; m_columns = 0;
+			m_decoded.clear();
+		}
+
+		bool is_open() const { return m_file.is_open(); }
+
+		tools::size_t rows()    const { return m_rows; }
+		tools::size_t columns() const { return m_columns; }
+
+		std::string  name(tools::size_t c)  const { assert(c < m_columns); return std::string(m_entries[c].name); }
+		column_type  type(tools::size_t c)  const { assert(c < m_columns); return m_entries[c].type; }
+		column_codec codec(tools::size_t c) const { assert(c < m_columns); return m_entries[c].codec; }
+
+		/* index of the column called name, columns() if there is none */
+		tools::size_t find(const std::string& name) const {
+			for (tools::size_t c = 0; c < m_columns; ++c) {
+				if (name == m_entries[c].name) { return c; }
+			}
+			return m_columns;
+		}
+
+		template <typename _Tp>
+		tools::strided_view<_Tp> column(tools::size_t c) const {
+			assert(c < m_columns);
+			assert(column_type_of<_Tp>::value == m_entries[c].type);
+
+			return tools::strided_view<_Tp>(_column_data<_Tp>(c), m_rows, 1);
+		}
+
+		/**
+		 * @note Columns [first, last) as a column-major matrix_view over
+		 *       the mapping. Fails when they differ in type, are
+		 *       compressed, or are not laid out back to back.
+		 */
+		template <typename _Tp>
+		bool features(tools::size_t first, tools::size_t last, tools::matrix_view<_Tp>& view) const {
+			TOOLS_TRACE_SCOPE("dataset::features");
+			if (last <= first || m_columns < last) { return false; }
+
+			for (tools::size_t c = first; c < last; ++c) {
+				if (column_type_of<_Tp>::value != m_entries[c].type ||
+					column_codec::none != m_entries[c].codec) { return false; }
+			}
+
+			tools::size_t stride = 0;
+			if (first + 1 < last) {
+				const tools::size_t bytes = m_entries[first + 1].offset - m_entries[first].offset;
+				if (0 != bytes % sizeof(_Tp)) { return false; }
+				stride = bytes / sizeof(_Tp);
+
+				for (tools::size_t c = first + 1; c < last; ++c) {
+					if (m_entries[c].offset - m_entries[c - 1].offset != bytes) { return false; }
+				}
+			}
+
+			view = tools::matrix_view<_Tp>(
+				_column_data<_Tp>(first), m_rows, last - first, 1, stride
+			);
+			return true;
+		}
+
+		template <typename _Feature, typename _Label>
+		bool samples(
+			tools::size_t                first,
+			tools::size_t                last,
+			tools::size_t                label,
+			sample_view<_Feature, _Label>& view
+		) const {
+			tools::matrix_view<_Feature> feature_view;
+			if (!features(first, last, feature_view)) { return false; }
+			if (m_columns <= label || column_type_of<_Label>::value != m_entries[label].type) { return false; }
+
+			view = sample_view<_Feature, _Label>(feature_view, column<_Label>(label));
+			return true;
+		}
+
+	private:
+		/**
+		 * @note Everything later reads trusts what is checked here: the
+		 *       table and every payload lie inside the file and start on
+		 *       the 64 byte boundary the writer pads to, so the typed
+		 *       reads through the mapping are aligned, no byte count
+		 *       overflows, and a raw column holds exactly rows values.
+		 *       A rle column cannot claim more rows than its records
+		 *       could describe, so decoding it allocates no more than
+		 *       the file accounts for.
+		 */
+		bool _validate() {
+			if (m_file.size() < sizeof(_dataset_header)) { return false; }
+
+			_dataset_header header;
+			std::memcpy(&header, m_file.data(), sizeof(header));
+
+			if (0 != std::memcmp(header.magic, "TBDS", 4) || _dataset_version != header.version) { return false; }
+			if (_max_rows < header.rows) { return false; }
+			if (0 != header.table_offset % _dataset_align || m_file.size() < header.table_offset ||
+				(m_file.size() - header.table_offset) / sizeof(_column_entry) < header.columns) { return false; }
+
+			m_rows    = header.rows;
+			m_columns = header.columns;
+			m_entries = reinterpret_cast<const _column_entry*>(m_file.data() + header.table_offset);
+
+			for (tools::size_t c = 0; c < m_columns; ++c) {
+				const _column_entry& entry = m_entries[c];
+				if (0 != entry.offset % _dataset_align) { return false; }
+				if (m_file.size() < entry.offset || m_file.size() - entry.offset < entry.bytes) { return false; }
+				if ('\0' != entry.name[_dataset_name_sz - 1]) { return false; }
+				if (column_type::float64 < entry.type) { return false; }
+
+				const tools::size_t size = _element_size(entry.type);
+				if (column_codec::none == entry.codec) {
+					if (entry.bytes != m_rows * size) { return false; }
+				}
+				else if (column_codec::rle == entry.codec) {
+					const tools::size_t records = entry.bytes / (sizeof(tools::uint32_t) + size);
+					if (records < m_rows / 0xffffffffull + (0 == m_rows % 0xffffffffull ? 0 : 1)) { return false; }
+				}
+				else { return false; }
+			}
+			return true;
+		}
+
+		static tools::size_t _element_size(column_type type) {
+			switch (type) {
+				case column_type::int8    :
+				case column_type::uint8   : return 1;
+				case column_type::int32   :
+				case column_type::uint32  :
+				case column_type::float32 : return 4;
+				default                   : return 8;
+			}
+		}
+
+		template <typename _Tp>
+		const _Tp* _column_data(tools::size_t c) const {
+			const _column_entry& entry = m_entries[c];
+			if (column_codec::none == entry.codec) {
+				return reinterpret_cast<const _Tp*>(m_file.data() + entry.offset);
+			}
+
+			std::vector<char>& decoded = m_decoded[c];
+			if (decoded.empty() && 0 != m_rows) { _rle_decode<_Tp>(entry, decoded); }
+			return reinterpret_cast<const _Tp*>(decoded.data());
+		}
+
+		template <typename _Tp>
+		void _rle_decode(const _column_entry& entry, std::vector<char>& decoded) const {
+			TOOLS_TRACE_SCOPE("dataset::_rle_decode");
+			const tools::size_t record = sizeof(tools::uint32_t) + sizeof(_Tp);
+
+			decoded.assign(m_rows * sizeof(_Tp), 0);
+			_Tp* out = reinterpret_cast<_Tp*>(decoded.data());
+
+			const char*   itr   = m_file.data() + entry.offset;
+			const char*   last  = itr + entry.bytes;
+			tools::size_t count = 0;
+
+			for (; record <= (tools::size_t) (last - itr) && count < m_rows; itr += record) {
+				tools::uint32_t run; _Tp value;
+				std::memcpy(&run, itr, sizeof(run));
+				std::memcpy(&value, itr + sizeof(run), sizeof(_Tp));
+
+				for (tools::uint32_t i = 0; i < run && count < m_rows; ++i) { out[count++] = value; }
+			}
+		}
+
+		tools::mapped_file                     m_file;
+		tools::size_t                          m_rows;
+		const _column_entry*                   m_entries;
+		tools::size_t                          m_columns;
+		mutable std::vector<std::vector<char>> m_decoded;
+	};
+}
+
+#endif //_DATASET_H_
@@ -12,9 +12,15 @@
 #include <ostream>
 #include <limits>
 
-#include <map>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
 #include <vector>
-#include <set>
+
+#include "../container/matrix.h"
+#include "../common/parallel.h"
+#include "../common/trace.h"
+#include "histogram.h"
 
 namespace ml {
 
@@ -37,7 +43,10 @@ namespace ml {
 		value_type             choice;
 		value_type             value;
 
-		_dt_node() : attribute(invalid_attr), choice(invalid_value), value(invalid_value) { }
+		/* children[0] takes the attribute values <= their choice, children[1] the greater ones */
+		bool                   numeric;
+
+		_dt_node() : attribute(invalid_attr), choice(invalid_value), value(invalid_value), numeric(false) { }
 	};
 
 	template <typename _Attr, typename _Val>
@@ -46,6 +55,79 @@ namespace ml {
 	template <typename _Attr, typename _Val>
 	const _Val _dt_node<_Attr, _Val>::invalid_value(-1); // no-numeric _Label will throw compiling error
 
+	/* nodes with fewer rows are grown serially, a task would cost more than it saves */
+	constexpr tools::size_t dt_task_rows = 1 << 15;
+
+	/**
+	 * @note A matrix re-coded for growing trees: the bins of every
+	 *       column (the last one holds the labels), the codes row by
+	 *       row, and the numeric attributes presorted, their codes all 0
+	 *       as they are one bin in the histograms. Made once, it is read
+	 *       by any number of trees grown on samples of its rows. Throws
+	 *       std::length_error for a categorical or the label column of
+	 *       more than max_bins distinct values, a numeric column being
+	 *       ranked instead may have any number of them.
+	 */
+	template <typename _Val>
+	class tree_data {
+	public:
+		typedef _Val                    value_type;
+		typedef tools::matrix<bin_type> code_matrix;
+
+		/* numeric[a] for an attribute split by thresholds, the missing ones are categorical */
+		template <typename _Matrix2D>
+		tree_data(const _Matrix2D& matrix, std::vector<bool> numeric) :
+			m_bins(matrix.cols()), m_codes(matrix.rows(), matrix.cols()),
+			m_numeric(std::move(numeric)), m_sorted(matrix.cols() - 1)
+		{
+			assert(0 < matrix.rows() && 1 < matrix.cols());
+
+			const size_t rows = matrix.rows(), cols = matrix.cols();
+			m_numeric.resize(cols - 1, false);
+
+			std::vector<value_type> column(rows), distinct;
+			for (size_t c = 0; c < cols; ++c) {
+				if (c + 1 < cols && m_numeric[c]) { continue; }
+				for (size_t r = 0; r < rows; ++r) { column[r] = matrix[r][c]; }
+				m_bins[c].assign(column.begin(), column.end());
+			}
+
+			for (size_t r = 0; r < rows; ++r) {
+				for (size_t c = 0; c < cols; ++c) { m_codes(r, c) = c + 1 < cols && m_numeric[c] ? 0 : m_bins[c].code(matrix[r][c]); }
+			}
+
+			for (size_t c = 0; c + 1 < cols; ++c) {
+				if (!m_numeric[c]) { continue; }
+
+				for (size_t r = 0; r < rows; ++r) { column[r] = matrix[r][c]; }
+				m_sorted[c].resize(rows);
+				presort(column.data(), rows, &m_codes(0, cols - 1), cols, m_sorted[c].data(), distinct);
+				m_bins[c].assign_sorted(std::move(distinct));
+			}
+		}
+
+		size_t rows() const { return m_codes.rows(); }
+		size_t cols() const { return m_codes.cols(); }
+		size_t attributes() const { return m_codes.cols() - 1; }
+
+		bool numeric(size_t attr) const { return m_numeric[attr]; }
+		const std::vector<bool>& numeric() const { return m_numeric; }
+
+		const std::vector<value_bins<value_type>>& bins() const { return m_bins; }
+		const value_bins<value_type>& labels() const { return m_bins.back(); }
+
+		const code_matrix& codes() const { return m_codes; }
+
+		/* the rows in ascending order of a numeric attribute */
+		const std::vector<sorted_row>& sorted(size_t attr) const { assert(m_numeric[attr]); return m_sorted[attr]; }
+
+	private:
+		std::vector<value_bins<value_type>>  m_bins;
+		code_matrix                          m_codes;
+		std::vector<bool>                    m_numeric;
+		std::vector<std::vector<sorted_row>> m_sorted;
+	};
+
 	template <typename _Attr, typename _Val>
 	class decision_tree {
 	public:
@@ -56,34 +138,338 @@ namespace ml {
 	private:
 		typedef _dt_node<_Attr, _Val> node_type;
 		typedef node_type*            link_type;
+		typedef typename tree_data<_Val>::code_matrix code_matrix;
+
+		/**
+		 * @note What the nodes of one build share. A node owns the same
+		 *       range [offset, offset + rows) of index, of every sorted
+		 *       column, of their spares and of side, offset being where
+		 *       its rows start in index.
+		 */
+		struct _context {
+			const code_matrix&         codes;
+			row_index*                 index;
+			std::vector<sorted_row*>   sorted;       // the numeric attributes' presorted rows, null for the others
+			sorted_row*                sorted_spare;
+			bin_type*                  side;         // child of each row of the node being split
+			tools::work_stealing_pool* pool;
+			tools::task_group*         group;
+		};
 
 	public:
-		decision_tree() : m_root(nullptr) { }
+		typedef tree_data<_Val> data_type;
+
+		decision_tree() : m_root(nullptr), m_threads(tools::concurrency()), m_max_features(0), m_seed(0) { }
 
 		template <typename _Matrix2D>
-		explicit decision_tree(const _Matrix2D& matrix) : m_root(nullptr) {
-			_build(matrix, m_root);
+		explicit decision_tree(const _Matrix2D& matrix) :
+			m_root(nullptr), m_threads(tools::concurrency()), m_max_features(0), m_seed(0)
+		{
+			build(matrix);
 		}
 
 		~decision_tree() { _destroy(m_root); }
 
+		/* threads a build uses, 1 grows the tree serially */
+		size_t threads() const { return m_threads; }
+		void set_threads(size_t threads) { m_threads = 0 == threads ? 1 : threads; }
+
+		/* an ordered attribute is split by a threshold instead of one child per value */
+		bool numeric(attr_type attr) const { return (size_t) attr < m_numeric.size() && m_numeric[attr]; }
+		void set_numeric(attr_type attr, bool numeric = true) {
+			assert(0 <= attr);
+			if (m_numeric.size() <= (size_t) attr) { m_numeric.resize(attr + 1, false); }
+			m_numeric[attr] = numeric;
+		}
+
+		/**
+		 * @note Attributes a node draws at random to choose its split
+		 *       from, 0 for all of them (the default). The draw depends
+		 *       on the seed and on the node's rows only, so the tree is
+		 *       still the same whatever the number of threads.
+		 */
+		size_t max_features() const { return m_max_features; }
+		void set_max_features(size_t features) { m_max_features = features; }
+		void set_seed(tools::uint64_t seed) { m_seed = seed; }
+
+		/**
+		 * @note The last column holds the labels, the others are
+		 *       categorical attributes. Every column is first re-coded
+		 *       into bins (one per distinct value, at most max_bins of
+		 *       them or std::length_error) and the tree is grown on the
+		 *       codes: a node's
+		 *       class_histogram, filled in one pass over its rows, scores
+		 *       all the attributes, and of the children of a split only
+		 *       the largest is not scanned, its histogram being the
+		 *       parent's minus its siblings'.
+		 *
+		 *       A node is a range of one permutation of the row ids, and
+		 *       a split partitions that range (partition_by_key) so the
+		 *       children get consecutive sub-ranges: after the coding
+		 *       only row ids move, never rows, whatever the depth.
+		 *
+		 *       A numeric attribute (set_numeric) is split in two at the
+		 *       threshold of most gain instead, and may be split again
+		 *       further down. Its column is presorted once by value, the
+		 *       rows ranked instead of binned so there is no limit to
+		 *       its distinct values, and each
+		 *       split partitions the sorted rows stably as well, so a
+		 *       node's rows are always at hand in value order and its
+		 *       thresholds are scored in one sweep (threshold_gain):
+		 *       O(rows) per node however many distinct values there are,
+		 *       where bins or a child per value would cost O(values).
+		 *
+		 *       That makes sibling subtrees independent, so with more
+		 *       than one thread a child of at least dt_task_rows rows is
+		 *       grown as a task of a work_stealing_pool, and such large
+		 *       nodes also fill their histograms by blocks of rows and
+		 *       score the attributes concurrently. The tree is the same
+		 *       whatever the number of threads.
+		 */
 		template <typename _Matrix2D>
 		void build(const _Matrix2D& matrix) {
-			assert(0 < matrix.rows() && 0 < matrix.cols());
+			assert(0 < matrix.rows() && 1 < matrix.cols());
+			build(data_type(matrix, m_numeric));
+		}
 
-			// to clear the old decision tree
-			_destroy(m_root);
+		/* on data already coded, its numeric attributes replacing the ones set */
+		void build(const data_type& data) {
+			_grow(data, nullptr);
+		}
+
+		/* on the rows sample[0, n) of data, a row being there as many times as it is drawn */
+		void build(const data_type& data, const std::vector<row_index>& sample) {
+			assert(!sample.empty());
+			_grow(data, &sample);
+		}
 
-			std::vector<bool> blacklist(matrix.cols(), false);
-			blacklist.back() = true;
-			size_t count_list = 1;
+		/**
+		 * @note Labels of the rows of matrix, whose first columns are
+		 *       the attributes (a label column after them is ignored).
+		 *       Rows go through the flat tree by blocks: each level moves
+		 *       every row of the block one node down, so the loads of
+		 *       different rows are independent and overlap instead of
+		 *       one walk waiting on each of its own cache misses.
+		 */
+		template <typename _Matrix2D>
+		std::vector<label_type> predict(const _Matrix2D& matrix) const {
+			std::vector<label_type> labels(matrix.rows());
+			predict(matrix, 0, matrix.rows(), labels.data());
+			return labels;
+		}
+
+		/* labels of the rows [first, last) of matrix into out[0, last - first) */
+		template <typename _Matrix2D>
+		void predict(const _Matrix2D& matrix, size_t first, size_t last, label_type* out) const {
+			assert(!m_nodes.empty() && m_codes.size() <= matrix.cols() && first <= last);
+
+			tools::uint32_t current[_predict_block];
+			for (size_t begin = first; begin < last; begin += _predict_block) {
+				const size_t n = std::min<size_t>(_predict_block, last - begin);
+				std::fill(current, current + n, 0);
+
+				for (bool moving = true; moving; ) {
+					moving = false;
+					for (size_t k = 0; k < n; ++k) {
+						const _flat_node& node = m_nodes[current[k]];
+						if (_leaf == node.attribute) { continue; }
+						current[k] = _next(node, matrix[begin + k][node.attribute]);
+						moving = true;
+					}
+				}
+
+				for (size_t k = 0; k < n; ++k) { out[begin - first + k] = m_nodes[current[k]].label; }
+			}
+		}
+
+		/* the label of one row, row[a] being the value of attribute a */
+		template <typename _Row>
+		label_type predict_one(const _Row& row) const {
+			assert(!m_nodes.empty());
 
-			_build(matrix, m_root, node_type::invalid_value, blacklist, count_list);
+			tools::uint32_t current = 0;
+			while (_leaf != m_nodes[current].attribute) {
+				const _flat_node& node = m_nodes[current];
+				current = _next(node, row[node.attribute]);
+			}
+			return m_nodes[current].label;
 		}
 
 		void print(std::ostream& stream) const { _print(stream, m_root, 0); }
 
 	private:
+		/**
+		 * @note A node of the compiled tree. An inner node's children
+		 *       are m_links[children, children + bins], one per bin of
+		 *       its attribute plus a last one for values it never saw,
+		 *       so a step down is an index instead of a scan of the
+		 *       children's choices. A numeric node has bins == _numeric
+		 *       and its threshold in label, a value <= it going to the
+		 *       first of its two children.
+		 */
+		struct _flat_node {
+			tools::uint32_t attribute;
+			tools::uint32_t children;
+			tools::uint32_t bins;
+			label_type      label;
+		};
+
+		/* value to bin of one attribute, by a table when its values are dense integers */
+		struct _value_codes {
+			value_type            low;
+			std::vector<bin_type> table;
+		};
+
+		static const tools::uint32_t _leaf = (tools::uint32_t) -1;
+		static const tools::uint32_t _numeric = (tools::uint32_t) -1;
+		static const size_t          _predict_block = 64;
+
+		bin_type _code(tools::uint32_t attr, const value_type& value) const {
+			const _value_codes& codes = m_codes[attr];
+			if (codes.table.empty()) { return m_bins[attr].code(value); }
+			if (value < codes.low) { return value_bins<value_type>::npos; }
+
+			const tools::size_t offset = (tools::size_t) (value - codes.low);
+			return offset < codes.table.size() ? codes.table[offset] : value_bins<value_type>::npos;
+		}
+
+		tools::uint32_t _next(const _flat_node& node, const value_type& value) const {
+			if (_numeric == node.bins) { return m_links[node.children + (node.label < value ? 1 : 0)]; }
+
+			const tools::uint32_t bin = _code(node.attribute, value);
+			return m_links[node.children + std::min(bin, node.bins)];
+		}
+
+		/**
+		 * @note Flattens the nodes into m_nodes breadth first, so the top
+		 *       levels that every row visits share a few cache lines. A
+		 *       bin without a child, and the unseen values, lead to an
+		 *       extra leaf with the inner node's most frequent label.
+		 */
+		void _compile() {
+			const size_t attrs = m_bins.size() - 1;
+
+			m_codes.assign(attrs, _value_codes());
+			for (size_t a = 0; a < attrs; ++a) {
+				const value_bins<value_type>& bins = m_bins[a];
+				if (!std::is_integral<value_type>::value || m_numeric[a] || 0 == bins.size()) { continue; }
+
+				const value_type low = bins.value(0), high = bins.value(bins.size() - 1);
+				const tools::size_t span = (tools::size_t) (high - low) + 1;
+				if (4 * bins.size() + 256 < span) { continue; }
+
+				m_codes[a].low = low;
+				m_codes[a].table.assign(span, value_bins<value_type>::npos);
+				for (tools::size_t b = 0; b < bins.size(); ++b) {
+					m_codes[a].table[(tools::size_t) (bins.value(b) - low)] = (bin_type) b;
+				}
+			}
+
+			m_nodes.clear();
+			m_links.clear();
+
+			/* order[i] is compiled into m_nodes[slot[i]], its children right after one another */
+			std::vector<link_type> order(1, m_root);
+			std::vector<tools::uint32_t> slot(1, 0);
+			m_nodes.push_back(_flat_node { _leaf, 0, 0, m_root->value });
+			for (size_t i = 0; i < order.size(); ++i) {
+				const link_type node = order[i];
+				if (node->children.empty()) { continue; }
+
+				const tools::uint32_t attr = (tools::uint32_t) node->attribute;
+				const tools::uint32_t children = (tools::uint32_t) m_links.size();
+
+				if (node->numeric) {
+					m_nodes[slot[i]] = _flat_node { attr, children, _numeric, node->children.front()->choice };
+					for (const link_type child : node->children) {
+						m_links.push_back((tools::uint32_t) m_nodes.size());
+						order.push_back(child);
+						slot.push_back((tools::uint32_t) m_nodes.size());
+						m_nodes.push_back(_flat_node { _leaf, 0, 0, child->value });
+					}
+					continue;
+				}
+
+				const tools::uint32_t bins = (tools::uint32_t) m_bins[attr].size();
+				m_nodes[slot[i]] = _flat_node { attr, children, bins, node->value };
+
+				/* every bin and the unseen values go to the fallback leaf unless a child has them */
+				const tools::uint32_t fallback = (tools::uint32_t) m_nodes.size();
+				m_nodes.push_back(_flat_node { _leaf, 0, 0, node->value });
+				m_links.insert(m_links.end(), bins + 1, fallback);
+
+				for (const link_type child : node->children) {
+					m_links[children + m_bins[attr].code(child->choice)] = (tools::uint32_t) m_nodes.size();
+					order.push_back(child);
+					slot.push_back((tools::uint32_t) m_nodes.size());
+					m_nodes.push_back(_flat_node { _leaf, 0, 0, child->value });
+				}
+			}
+		}
+
+		/* the tree of data's rows, all of them once when sample is null */
+		void _grow(const data_type& data, const std::vector<row_index>* sample) {
+			TOOLS_TRACE_SCOPE("decision_tree::_grow");
+			// to clear the old decision tree
+			_destroy(m_root);
+
+			const size_t rows = data.rows(), attrs = data.attributes();
+			m_bins = data.bins();
+			m_numeric = data.numeric();
+
+			/* the sample in ascending row order, and so are the sorted columns taken from data's */
+			std::vector<tools::uint32_t> times;
+			std::vector<row_index> index;
+			if (nullptr == sample) {
+				index.resize(rows);
+				for (size_t r = 0; r < rows; ++r) { index[r] = (row_index) r; }
+			}
+			else {
+				times.assign(rows, 0);
+				for (row_index each : *sample) { assert(each < rows); ++times[each]; }
+				index.reserve(sample->size());
+				for (size_t r = 0; r < rows; ++r) { index.insert(index.end(), times[r], (row_index) r); }
+			}
+
+			const size_t n = index.size();
+			std::vector<row_index> spare(n);
+			std::vector<bin_type> side(rows);
+
+			const size_t numerics = (size_t) std::count(m_numeric.begin(), m_numeric.end(), true);
+			std::vector<sorted_row> sorted(numerics * n), sorted_spare(0 == numerics ? 0 : n);
+
+			std::vector<tools::size_t> bins(attrs);
+			std::vector<sorted_row*> columns(attrs, nullptr);
+			for (size_t c = 0, k = 0; c < attrs; ++c) {
+				bins[c] = m_numeric[c] ? 1 : m_bins[c].size();
+				if (!m_numeric[c]) { continue; }
+
+				columns[c] = sorted.data() + n * k++;
+				const std::vector<sorted_row>& all = data.sorted(c);
+				if (nullptr == sample) { std::copy(all.begin(), all.end(), columns[c]); continue; }
+
+				sorted_row* out = columns[c];
+				for (const sorted_row& each : all) { out = std::fill_n(out, times[each.row], each); }
+			}
+
+			std::unique_ptr<tools::work_stealing_pool> pool;
+			if (1 < m_threads) { pool.reset(new tools::work_stealing_pool(m_threads)); }
+
+			tools::task_group group;
+			const _context context {
+				data.codes(), index.data(), std::move(columns), sorted_spare.data(), side.data(), pool.get(), &group
+			};
+
+			class_histogram histogram(bins, data.labels().size());
+			_fill(context, histogram, index.data(), index.data() + n);
+
+			std::vector<bool> blacklist(attrs, false);
+			_build(context, index.data(), spare.data(), std::move(histogram), m_root, node_type::invalid_value, std::move(blacklist), 0);
+			if (nullptr != pool) { pool->wait(group); }
+
+			_compile();
+		}
+
 		static link_type _create_node(
 			const attr_type&  attr,
 			const value_type& choice,
@@ -96,175 +482,249 @@ namespace ml {
 			return p;
 		}
 
-		template <typename _Matrix2D>
-		static double _info_gain(const _Matrix2D& matrix, const attr_type& attr) {
-
-			double gain = 0.0;
-			std::map<label_type, size_t> count_label_vals;
-
-			for (auto r = 0; r < matrix.rows(); ++r) {
-				label_type label = matrix[r][matrix.cols() - 1];
-				auto lab_itr = count_label_vals.find(label);
-				if (count_label_vals.end() == lab_itr) {
-					count_label_vals.insert(
-						lab_itr, std::make_pair((label_type) label, (size_t) 1)
-					);
-				}
-				else { ++lab_itr->second; }
+		static bool _concurrent(const _context& context, tools::size_t rows) {
+			return nullptr != context.pool && dt_task_rows <= rows;
+		}
+
+		/* a large range is counted by blocks, each into its own histogram, then summed */
+		static void _fill(const _context& context, class_histogram& histogram, const row_index* first, const row_index* last) {
+			const code_matrix& codes = context.codes;
+			const tools::size_t rows = (tools::size_t) (last - first);
+			if (!_concurrent(context, rows)) {
+				histogram.add(&codes(0, 0), codes.cols(), codes.cols() - 1, first, last);
+				return;
 			}
 
-			for (const auto& label_count : count_label_vals) {
-				double p = (double) label_count.second / matrix.rows();
-				gain -= p * std::log2(p);
+			/* only the large ranges, a probe would cost as much as a small one */
+			TOOLS_TRACE_SCOPE("decision_tree::_fill");
+
+			const tools::size_t blocks = std::min<tools::size_t>(context.pool->size(), rows / dt_task_rows);
+			std::vector<class_histogram> parts(blocks, histogram);
+
+			tools::task_group group;
+			for (tools::size_t k = 0; k < blocks; ++k) {
+				const row_index* begin = first + rows * k / blocks;
+				const row_index* end = first + rows * (k + 1) / blocks;
+				class_histogram* part = &parts[k];
+				part->clear();
+				context.pool->spawn(group, [&codes, part, begin, end]() {
+					part->add(&codes(0, 0), codes.cols(), codes.cols() - 1, begin, end);
+				});
 			}
+			context.pool->wait(group);
 
-			count_label_vals.clear();
-			std::map<value_type, size_t> count_attr_vals;
+			for (auto& each : parts) { histogram.add(each); }
+		}
 
-			for (auto r = 0; r < matrix.rows(); ++r) {
-				value_type val = matrix[r][attr];
-				auto attr_itr = count_attr_vals.find(val);
-				if (count_attr_vals.end() == attr_itr) {
-					count_attr_vals.insert(
-						attr_itr, std::make_pair((value_type) val, (size_t) 1)
-					);
+		/**
+		 * @note The attribute of most gain, invalid_attr when none of
+		 *       them splits the rows, with `split` the last bin of the
+		 *       lower side for a numeric one. The gains are computed
+		 *       concurrently for a large node, the pick is the serial one.
+		 *
+		 *       With max_features, only that many attributes drawn at
+		 *       random are scored, the others only if none of those
+		 *       splits the rows.
+		 */
+		attr_type _max_gain_attr(
+			const _context&          context,
+			const class_histogram&   histogram,
+			const row_index*         first,
+			const std::vector<bool>& blacklist,
+			tools::size_t&           split
+		) const {
+			TOOLS_TRACE_SCOPE("decision_tree::_max_gain_attr");
+			const double entropy = histogram.entropy();
+			const double none = -std::numeric_limits<double>::max();
+			std::vector<double> gains(blacklist.size(), none);
+			std::vector<tools::size_t> splits(blacklist.size(), 0);
+
+			std::vector<class_histogram::count_type> totals;
+			histogram.label_counts(totals);
+
+			const tools::size_t offset = (tools::size_t) (first - context.index), rows = histogram.rows();
+			auto score = [&](size_t i) {
+				if (m_numeric[i]) {
+					const sorted_row* column = context.sorted[i] + offset;
+					gains[i] = threshold_gain(column, column + rows, totals, entropy, splits[i]);
 				}
-				else { ++attr_itr->second; }
-			}
-
-			for (const auto& val_count : count_attr_vals) {
-				int total = 0;
-				double entropy = 0.0;
-				count_label_vals.clear();
-
-				for (auto r = 0; r < matrix.rows(); ++r) {
-					if (val_count.first == matrix[r][attr]) {
-						label_type label = matrix[r][matrix.cols() - 1];
-						auto lab_itr = count_label_vals.find(label);
-						if (count_label_vals.end() == lab_itr) {
-							count_label_vals.insert(
-								lab_itr, std::make_pair((label_type) label, (size_t) 1)
-							);
-						}
-						else { ++lab_itr->second; }
-						++total;
+				else { gains[i] = histogram.gain(i, entropy); }
+			};
+
+			auto pick = [&](const std::vector<size_t>& candidates) {
+				if (_concurrent(context, rows)) {
+					tools::task_group group;
+					for (size_t i : candidates) {
+						context.pool->spawn(group, [&score, i]() { score(i); });
 					}
+					context.pool->wait(group);
+				}
+				else {
+					for (size_t i : candidates) { score(i); }
 				}
 
-				for (const auto& label_count : count_label_vals) {
-					double p = (double) label_count.second / total;
-					entropy -= p * std::log2(p);
+				attr_type max_attr = node_type::invalid_attr;
+				double max_gain = none;
+				for (size_t i : candidates) {
+					if (max_gain < gains[i]) { max_gain = gains[i]; max_attr = (attr_type) i; }
 				}
+				return max_attr;
+			};
 
-				gain -= (double) total / matrix.rows() * entropy;
+			std::vector<size_t> candidates;
+			for (size_t i = 0; i < blacklist.size(); ++i) {
+				if (m_numeric[i] || !blacklist[i]) { candidates.push_back(i); }
 			}
 
-			return gain;
-		}
-
-		template <typename _Matrix2D>
-		static attr_type _max_gain_attr(const _Matrix2D& matrix, const std::vector<bool>& blacklist) {
-			assert(matrix.cols() == blacklist.size());
-
 			attr_type max_attr = node_type::invalid_attr;
-			double max_gain = -std::numeric_limits<double>::max();
+			if (0 < m_max_features && m_max_features < candidates.size()) {
+				/* a partial shuffle, seeded by the node */
+				tools::uint64_t state = m_seed ^ (offset * 0x9e3779b97f4a7c15ull) ^ rows;
+				for (size_t k = 0; k < m_max_features; ++k) {
+					std::swap(candidates[k], candidates[k + _random(state) % (candidates.size() - k)]);
+				}
 
-			for (attr_type i = 0; i < matrix.cols(); ++i) {
-				if (blacklist[i]) { continue; }
+				std::vector<size_t> drawn(candidates.begin(), candidates.begin() + m_max_features);
+				std::sort(drawn.begin(), drawn.end());
+				max_attr = pick(drawn);
 
-				double gain = _info_gain(matrix, i);
-				if (max_gain < gain) { max_gain = gain; max_attr = i; }
+				candidates.erase(candidates.begin(), candidates.begin() + m_max_features);
+				std::sort(candidates.begin(), candidates.end());
 			}
+			if (node_type::invalid_attr == max_attr) { max_attr = pick(candidates); }
 
+			if (node_type::invalid_attr != max_attr) { split = splits[max_attr]; }
 			return max_attr;
 		}
 
-		template <typename _Matrix2D>
-		static label_type _most_label(const _Matrix2D& matrix) {
-			std::map<label_type, size_t> count_label_vals;
-
-			label_type most_label = node_type::invalid_value;
-			size_t     most_count = 0;
-
-			for (auto r = 0; r < matrix.rows(); ++r) {
-				label_type label = matrix[r][matrix.cols() - 1];
-				auto itr = count_label_vals.find(label);
-				if (count_label_vals.end() == itr) {
-					count_label_vals.insert(
-						itr, std::make_pair((label_type) label, (size_t) 1));
-				}
-				else { ++itr->second; }
-
-				if (most_count < itr->second) {
-					most_count = itr->second;
-					most_label = label;
-				}
-			}
-
-			return most_label;
+		/* splitmix64, a few cycles per draw and any seed will do */
+		static tools::uint64_t _random(tools::uint64_t& state) {
+			tools::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
 		}
 
-		template <typename _Matrix2D>
-		static bool _same_label(const _Matrix2D& matrix) {
-			for (size_t r = 1; r < matrix.rows(); ++r) {
-				if (matrix[  r  ][matrix.cols() - 1] !=
-				    matrix[r - 1][matrix.cols() - 1]) {
-					return false;
-				}
-			}
+		/* the label of most rows and how many labels occur at all */
+		value_type _most_label(const class_histogram& histogram, size_t& present) const {
+			std::vector<class_histogram::count_type> counts;
+			histogram.label_counts(counts);
 
-			return true;
+			size_t most = 0;
+			present = 0;
+			for (size_t l = 0; l < counts.size(); ++l) {
+				if (0 != counts[l]) { ++present; }
+				if (counts[most] < counts[l]) { most = l; }
+			}
+			return m_bins.back().value((bin_type) most);
 		}
 
-		template <typename _Matrix2D>
-		static void _build(
-			const _Matrix2D&   matrix,
-			link_type&         root,
-			value_type         choice,
-			std::vector<bool>  blacklist,
-			size_t             count_list
+		/**
+		 * @note The node of the rows first[0, histogram.rows()), spare
+		 *       being as much scratch. A large child is spawned into
+		 *       context.group rather than grown in place: it owns its
+		 *       sub-ranges of first and spare and its slot in
+		 *       root->children, so no two tasks touch the same memory.
+		 */
+		void _build(
+			const _context&   context,
+			row_index*        first,
+			row_index*        spare,
+			class_histogram   histogram,
+			link_type&        root,
+			value_type        choice,
+			std::vector<bool> blacklist,
+			size_t            count_list
 		) {
-			if (_same_label(matrix)) {
-				root = _create_node(
-					node_type::invalid_attr,
-					choice,
-					matrix[0][matrix.cols() - 1]
-				);
-				return;
-			}
+			const code_matrix& codes = context.codes;
 
-			if (blacklist.size() == count_list) {
-				root = _create_node(
-					node_type::invalid_attr,
-				    choice,
-				    _most_label(matrix)
-				);
-				return;
-			}
+			size_t present = 0;
+			const value_type most_label = _most_label(histogram, present);
 
-			attr_type id = _max_gain_attr(matrix, blacklist);
-			assert(node_type::invalid_attr != id);
-			blacklist[id] = true; ++count_list;
+			tools::size_t split = 0;
+			const attr_type id = 1 == present || blacklist.size() == count_list ?
+				node_type::invalid_attr : _max_gain_attr(context, histogram, first, blacklist, split);
 
-			root = _create_node(id, choice, node_type::invalid_value);
-
-			std::set<attr_type> value_set;
+			if (node_type::invalid_attr == id) {
+				root = _create_node(node_type::invalid_attr, choice, most_label);
+				return;
+			}
 
-			for (auto r = 0; r < matrix.rows(); ++r) {
-				auto val = matrix[r][id];
-				auto itr = value_set.find(val);
-				if (value_set.end() == itr) {
-					value_set.insert(itr, val);
+			/* the label is what a row with a value not seen here gets */
+			root = _create_node(id, choice, most_label);
+			root->numeric = m_numeric[id];
+
+			/* rows and choice of every child, a non-empty bin each or the two sides of the threshold */
+			const tools::size_t offset = (tools::size_t) (first - context.index), rows = histogram.rows();
+			std::vector<tools::size_t> counts;
+			std::vector<value_type> values;
+			if (root->numeric) {
+				const sorted_row* column = context.sorted[id] + offset;
+				tools::size_t below = 0;
+				while (column[below].rank <= split) { context.side[column[below++].row] = 0; }
+				for (tools::size_t i = below; i < rows; ++i) { context.side[column[i].row] = 1; }
+
+				counts = { below, rows - below };
+				values.assign(2, m_bins[id].value(split));
+			}
+			else {
+				blacklist[id] = true; ++count_list;
+
+				std::vector<bin_type> child(histogram.bins(id), 0);
+				for (size_t b = 0; b < child.size(); ++b) {
+					const tools::size_t count = histogram.count(id, b);
+					if (0 == count) { continue; }
+					child[b] = (bin_type) counts.size();
+					counts.push_back(count);
+					values.push_back(m_bins[id].value(b));
+				}
+				for (tools::size_t i = 0; i < rows; ++i) { context.side[first[i]] = child[codes(first[i], id)]; }
+			}
 
-					typedef typename _Matrix2D::const_row_iterator iterator;
+			size_t largest = 0;
+			for (size_t i = 1; i < counts.size(); ++i) {
+				if (counts[largest] < counts[i]) { largest = i; }
+			}
 
-					auto sub = matrix.select(
-						[id, val](size_t, iterator first, iterator) { return val == first[id]; }
-					);
+			/* children as consecutive sub-ranges, in bin order, in the index and in every sorted column */
+			const bin_type* side = context.side;
+			partition_by_key(first, spare, counts, [side](row_index row) { return side[row]; });
+			for (sorted_row* column : context.sorted) {
+				if (nullptr == column) { continue; }
+				partition_by_key(column + offset, context.sorted_spare + offset, counts, [side](const sorted_row& each) { return side[each.row]; });
+			}
 
-					root->children.emplace_back(nullptr);
-					_build(sub, root->children.back(), val, blacklist, count_list);
+			std::vector<row_index*> ranges(counts.size() + 1, first);
+			for (size_t i = 0; i < counts.size(); ++i) { ranges[i + 1] = ranges[i] + counts[i]; }
+
+			/* every child's histogram is filled but the largest one's, that is what remains */
+			std::vector<class_histogram> children(values.size());
+			for (size_t i = 0; i < values.size(); ++i) {
+				if (largest == i) { continue; }
+				children[i] = histogram;
+				children[i].clear();
+				_fill(context, children[i], ranges[i], ranges[i + 1]);
+				histogram.subtract(children[i]);
+			}
+			children[largest] = std::move(histogram);
+
+			root->children.assign(values.size(), nullptr);
+			for (size_t i = 0; i < values.size(); ++i) {
+				row_index* begin = ranges[i];
+				row_index* scratch = spare + (ranges[i] - first);
+				link_type* slot = &root->children[i];
+				const value_type value = values[i];
+
+				if (!_concurrent(context, children[i].rows())) {
+					_build(context, begin, scratch, std::move(children[i]), *slot, value, blacklist, count_list);
+					continue;
 				}
+
+				/* copies, the task outlives this frame */
+				const _context* shared = &context;
+				context.pool->spawn(*context.group, [this, shared, begin, scratch, slot, value, blacklist, count_list, child = std::move(children[i])]() mutable {
+					_build(*shared, begin, scratch, std::move(child), *slot, value, blacklist, count_list);
+				});
 			}
 		}
 
@@ -277,13 +737,14 @@ namespace ml {
 			root = nullptr;
 		}
 
-		static void _print(std::ostream& stream, link_type root, size_t indent) {
+		/* relation is how the choice of root compares to the values it takes */
+		static void _print(std::ostream& stream, link_type root, size_t indent, const char* relation = "") {
 			if (nullptr == root) { return; }
 
 			for (size_t i = 0; i < indent; ++i) { stream << ' '; }
 
 			if (node_type::invalid_value != root->choice) {
-				stream << "choice: " << root->choice << "->";
+				stream << "choice: " << relation << root->choice << "->";
 			}
 
 			if (root->children.empty()) {
@@ -294,14 +755,33 @@ namespace ml {
 			stream << "attr: " << root->attribute << std::endl;
 			indent += 4;
 
-			for (auto& each : root->children) {
-				_print(stream, each, indent);
+			for (size_t i = 0; i < root->children.size(); ++i) {
+				_print(stream, root->children[i], indent, !root->numeric ? "" : 0 == i ? "<= " : "> ");
 			}
 		}
 
 	private:
-		link_type m_root;
+		link_type                           m_root;
+		std::vector<value_bins<value_type>> m_bins;
+		size_t                              m_threads;
+		std::vector<bool>                   m_numeric;
+		size_t                              m_max_features;
+		tools::uint64_t                     m_seed;
+
+		/* the compiled tree predict walks */
+		std::vector<_flat_node>      m_nodes;
+		std::vector<tools::uint32_t> m_links;
+		std::vector<_value_codes>    m_codes;
 	};
+
+	template <typename _Attr, typename _Val>
+	const tools::uint32_t decision_tree<_Attr, _Val>::_leaf;
+
+	template <typename _Attr, typename _Val>
+	const tools::uint32_t decision_tree<_Attr, _Val>::_numeric;
+
+	template <typename _Attr, typename _Val>
+	const size_t decision_tree<_Attr, _Val>::_predict_block;
 }
 
 namespace std {
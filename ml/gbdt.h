@@ -0,0 +1,330 @@
+/*
+ * Created by Maou Lim on 2019/7/25.
+ */
+
+#ifndef _GBDT_H_
+#define _GBDT_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "../common/parallel.h"
+#include "../common/trace.h"
+#include "histogram.h"
+
+namespace ml {
+
+	enum class boosting_loss { squared_error, logistic };
+
+	/**
+	 * @note Gradient boosted regression trees on real valued features,
+	 *       with the squared error or the logistic loss (labels 0/1).
+	 *
+	 *       Training codes every feature once into at most 256
+	 *       quantile bins, one byte per cell, row by row. A tree is
+	 *       grown depth first on a permutation of the row ids as the
+	 *       decision trees are: a node is a range of it, its
+	 *       gradient_histogram is filled in one pass over its rows
+	 *       (by fixed blocks of rows over the thread pool for a large
+	 *       node, summed in block order, so the model does not depend on
+	 *       the number of threads), a split is found by one sweep of
+	 *       each feature's bins, and of the two children only the
+	 *       smaller is scanned, the larger one's histogram being the
+	 *       parent's minus it.
+	 *
+	 *       The trees are scored from one flat node array. A leaf loops
+	 *       onto itself with an infinite threshold, so a row takes
+	 *       exactly depth steps node = left + (x[feature] > threshold)
+	 *       in every tree: no branch on the data, and a block of rows
+	 *       walked a level at a time keeps many loads in flight.
+	 */
+	template <typename _Value>
+	class gbdt {
+		static_assert(std::is_floating_point<_Value>::value, "features and scores are floating point");
+
+	public:
+		typedef _Value         value_type;
+		typedef tools::uint8_t code_type;
+
+		explicit gbdt(boosting_loss loss = boosting_loss::squared_error) :
+			m_loss(loss), m_rounds(100), m_max_depth(6), m_learning_rate(0.1), m_lambda(1.0),
+			m_min_hessian(1.0), m_bins(256), m_threads(tools::concurrency()), m_base(0.0) { }
+
+		void set_rounds(size_t rounds) { m_rounds = rounds; }
+		void set_max_depth(size_t depth) { assert(0 < depth); m_max_depth = depth; }
+		void set_learning_rate(double rate) { assert(0.0 < rate); m_learning_rate = rate; }
+		void set_lambda(double lambda) { assert(0.0 <= lambda); m_lambda = lambda; }
+
+		/* the least hessian sum a leaf may have, rows for the squared error */
+		void set_min_hessian(double hessian) { assert(0.0 < hessian); m_min_hessian = hessian; }
+
+		/* quantile bins per feature, 256 at most */
+		void set_bins(size_t bins) { assert(1 < bins && bins <= 256); m_bins = bins; }
+
+		void set_threads(size_t threads) { m_threads = 0 == threads ? 1 : threads; }
+
+		size_t trees() const { return m_roots.size(); }
+
+		/* rows of x and their targets y, one feature per column */
+		template <typename _Matrix2D>
+		void train(const _Matrix2D& x, const std::vector<value_type>& y) {
+			const size_t rows = x.rows(), features = x.cols();
+			assert(0 < rows && 0 < features && y.size() == rows);
+			assert(rows <= std::numeric_limits<row_index>::max());
+
+			tools::thread_pool pool(m_threads);
+			const size_t blocks = (rows + _block - 1) / _block;
+
+			/* cuts from a strided sample of the rows, then the codes */
+			const size_t step = std::max<size_t>(1, rows / _cut_sample);
+			m_cuts.assign(features, quantile_bins<value_type>());
+			pool.run(features, [this, &x, rows, step](size_t f) {
+				std::vector<value_type> values;
+				values.reserve(rows / step + 1);
+				for (size_t r = 0; r < rows; r += step) { values.push_back(x[r][f]); }
+				m_cuts[f].assign(values.data(), values.size(), m_bins);
+			});
+
+			std::vector<code_type> codes(rows * features);
+			pool.run(blocks, [this, &x, &codes, rows, features](size_t block) {
+				const size_t last = std::min(rows, (block + 1) * _block);
+				for (size_t r = block * _block; r < last; ++r) {
+					for (size_t f = 0; f < features; ++f) { codes[r * features + f] = (code_type) m_cuts[f].code(x[r][f]); }
+				}
+			});
+
+			m_base = _base_score(y);
+			m_nodes.clear();
+			m_values.clear();
+			m_roots.clear();
+			m_depths.clear();
+
+			std::vector<double> scores(rows, m_base);
+			std::vector<gradient_pair> pairs(rows);
+			std::vector<row_index> index(rows), spare(rows);
+			std::vector<gradient_histogram> parts(blocks, gradient_histogram(features, m_bins));
+
+			_context context { codes.data(), pairs.data(), scores.data(), index.data(), features, &pool, &parts };
+
+			for (size_t round = 0; round < m_rounds; ++round) {
+				TOOLS_TRACE_SCOPE("gbdt::round");
+				pool.run(blocks, [this, &y, &scores, &pairs, rows](size_t block) {
+					const size_t last = std::min(rows, (block + 1) * _block);
+					for (size_t r = block * _block; r < last; ++r) { pairs[r] = _gradient(scores[r], y[r]); }
+				});
+
+				for (size_t r = 0; r < rows; ++r) { index[r] = (row_index) r; }
+
+				gradient_histogram histogram(features, m_bins);
+				_fill(context, histogram, index.data(), index.data() + rows);
+
+				const tools::uint32_t root = _new_nodes(1);
+				m_roots.push_back(root);
+				m_depths.push_back(_grow(context, root, index.data(), spare.data(), rows, std::move(histogram), 0));
+			}
+		}
+
+		/* predictions for the rows of x: the value, or the probability of 1 for the logistic loss */
+		template <typename _Matrix2D>
+		std::vector<value_type> predict(const _Matrix2D& x) const {
+			const size_t rows = x.rows();
+			const size_t blocks = (rows + _block - 1) / _block;
+			std::vector<value_type> result(rows);
+
+			tools::thread_pool pool(std::max<size_t>(1, std::min(m_threads, blocks)));
+			pool.run(blocks, [this, &x, &result, rows](size_t block) {
+				const size_t first = block * _block;
+				predict(x, first, std::min(rows, first + _block), result.data() + first);
+			});
+			return result;
+		}
+
+		template <typename _Matrix2D>
+		void predict(const _Matrix2D& x, size_t first, size_t last, value_type* out) const {
+			assert(m_cuts.size() <= x.cols() && first <= last);
+
+			double sums[_walk_block];
+			tools::uint32_t current[_walk_block];
+			for (size_t begin = first; begin < last; begin += _walk_block) {
+				const size_t n = std::min<size_t>(_walk_block, last - begin);
+				std::fill(sums, sums + n, m_base);
+
+				for (size_t t = 0; t < m_roots.size(); ++t) {
+					std::fill(current, current + n, m_roots[t]);
+					for (size_t d = 0; d < m_depths[t]; ++d) {
+						for (size_t k = 0; k < n; ++k) {
+							const _node& node = m_nodes[current[k]];
+							current[k] = node.left + (node.threshold < x[begin + k][node.feature] ? 1 : 0);
+						}
+					}
+					for (size_t k = 0; k < n; ++k) { sums[k] += m_values[current[k]]; }
+				}
+
+				for (size_t k = 0; k < n; ++k) {
+					out[begin - first + k] = (value_type) (boosting_loss::logistic == m_loss ? 1.0 / (1.0 + std::exp(-sums[k])) : sums[k]);
+				}
+			}
+		}
+
+	private:
+		/* right child at left + 1, a leaf is its own left child */
+		struct _node {
+			value_type      threshold;
+			tools::uint32_t feature;
+			tools::uint32_t left;
+		};
+
+		/* what the nodes of one tree share */
+		struct _context {
+			const code_type*                 codes;
+			const gradient_pair*             pairs;
+			double*                          scores;
+			row_index*                       index;
+			size_t                           features;
+			tools::thread_pool*              pool;
+			std::vector<gradient_histogram>* parts;
+		};
+
+		static const size_t _block      = 1 << 16;
+		static const size_t _cut_sample = 1 << 16;
+		static const size_t _walk_block = 64;
+
+		double _base_score(const std::vector<value_type>& y) const {
+			double mean = 0.0;
+			for (value_type each : y) { mean += each; }
+			mean /= y.size();
+
+			if (boosting_loss::squared_error == m_loss) { return mean; }
+			mean = std::min(std::max(mean, 1e-6), 1.0 - 1e-6);
+			return std::log(mean / (1.0 - mean));
+		}
+
+		gradient_pair _gradient(double score, double target) const {
+			if (boosting_loss::squared_error == m_loss) { return gradient_pair { score - target, 1.0 }; }
+
+			const double p = 1.0 / (1.0 + std::exp(-score));
+			return gradient_pair { p - target, std::max(p * (1.0 - p), 1e-16) };
+		}
+
+		/* n consecutive leaves, the first one's index */
+		tools::uint32_t _new_nodes(size_t n) {
+			const tools::uint32_t first = (tools::uint32_t) m_nodes.size();
+			for (size_t i = 0; i < n; ++i) {
+				m_nodes.push_back(_node { std::numeric_limits<value_type>::infinity(), 0, (tools::uint32_t) (first + i) });
+				m_values.push_back(0.0);
+			}
+			return first;
+		}
+
+		/* a large range is summed by fixed blocks of rows, each into its own histogram, in block order, on one thread as well */
+		static void _fill(const _context& context, gradient_histogram& histogram, const row_index* first, const row_index* last) {
+			TOOLS_TRACE_SCOPE("gbdt::_fill");
+			const size_t rows = (size_t) (last - first);
+			if (rows < 2 * _block) {
+				histogram.add(context.codes, context.pairs, first, last);
+				return;
+			}
+
+			std::vector<gradient_histogram>& parts = *context.parts;
+			const size_t blocks = (rows + _block - 1) / _block;
+			context.pool->run(blocks, [&context, &parts, first, last](size_t block) {
+				const row_index* begin = first + block * _block;
+				const row_index* end = std::min(last, begin + _block);
+				parts[block].clear();
+				parts[block].add(context.codes, context.pairs, begin, end);
+			});
+			for (size_t block = 0; block < blocks; ++block) { histogram.add(parts[block]); }
+		}
+
+		/* the subtree of the rows first[0, rows) at node, its depth */
+		size_t _grow(
+			const _context&    context,
+			tools::uint32_t    node,
+			row_index*         first,
+			row_index*         spare,
+			size_t             rows,
+			gradient_histogram histogram,
+			size_t             depth
+		) {
+			const gradient_pair total = histogram.total();
+
+			size_t feature = 0;
+			tools::size_t split = 0;
+			double gain = 0.0;
+			if (depth < m_max_depth) {
+				for (size_t f = 0; f < context.features; ++f) {
+					tools::size_t s = 0;
+					const double g = histogram.best_split(f, m_cuts[f].size(), m_lambda, m_min_hessian, s);
+					if (gain < g) { gain = g; feature = f; split = s; }
+				}
+			}
+
+			if (0.0 >= gain) {
+				const double value = -m_learning_rate * total.gradient / (total.hessian + m_lambda);
+				m_values[node] = value;
+				for (size_t i = 0; i < rows; ++i) { context.scores[first[i]] += value; }
+				return depth;
+			}
+
+			/* rows with a code <= split to the left, stably */
+			const code_type* column = context.codes + feature;
+			const size_t stride = context.features;
+			size_t below = 0;
+			for (size_t i = 0; i < rows; ++i) { below += column[(size_t) first[i] * stride] <= split ? 1 : 0; }
+
+			const std::vector<size_t> sizes { below, rows - below };
+			partition_by_key(first, spare, sizes, [column, stride, split](row_index row) {
+				return column[(size_t) row * stride] <= split ? 0 : 1;
+			});
+
+			const tools::uint32_t left = _new_nodes(2);
+			m_nodes[node] = _node { m_cuts[feature].cut(split), (tools::uint32_t) feature, left };
+
+			/* the smaller side is scanned, the larger one is what remains of the parent */
+			const bool small_left = below <= rows - below;
+			gradient_histogram smaller(context.features, m_bins);
+			if (small_left) { _fill(context, smaller, first, first + below); }
+			else { _fill(context, smaller, first + below, first + rows); }
+			histogram.subtract(smaller);
+
+			gradient_histogram& left_histogram = small_left ? smaller : histogram;
+			gradient_histogram& right_histogram = small_left ? histogram : smaller;
+
+			const size_t l = _grow(context, left, first, spare, below, std::move(left_histogram), depth + 1);
+			const size_t r = _grow(context, left + 1, first + below, spare + below, rows - below, std::move(right_histogram), depth + 1);
+			return std::max(l, r);
+		}
+
+		boosting_loss m_loss;
+		size_t        m_rounds;
+		size_t        m_max_depth;
+		double        m_learning_rate;
+		double        m_lambda;
+		double        m_min_hessian;
+		size_t        m_bins;
+		size_t        m_threads;
+
+		/* the model: the cuts of the features and the trees */
+		std::vector<quantile_bins<value_type>> m_cuts;
+		double                                 m_base;
+		std::vector<_node>                     m_nodes;
+		std::vector<double>                    m_values;
+		std::vector<tools::uint32_t>           m_roots;
+		std::vector<size_t>                    m_depths;
+	};
+
+	template <typename _Value>
+	const size_t gbdt<_Value>::_block;
+
+	template <typename _Value>
+	const size_t gbdt<_Value>::_cut_sample;
+
+	template <typename _Value>
+	const size_t gbdt<_Value>::_walk_block;
+}
+
+#endif //_GBDT_H_
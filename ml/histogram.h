@@ -0,0 +1,470 @@
+/*
+ * Created by Maou Lim on 2019/7/22.
+ */
+
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../common/defines.h"
+
+namespace ml {
+
+	/* the small integer an attribute value is re-coded to */
+	typedef tools::uint16_t bin_type;
+
+	/* a row of the dataset, trees are grown on ranges of a permutation of them */
+	typedef tools::uint32_t row_index;
+
+	/* most bins a column may have, the last code is kept for unseen values */
+	constexpr tools::size_t max_bins = 65535;
+
+	/**
+	 * @note Bins of one column: its distinct values in ascending order,
+	 *       bin b standing for value(b). Coding is a binary search, done
+	 *       once per cell when the data is loaded. A column of more
+	 *       than max_bins distinct values cannot be coded, assign
+	 *       throws std::length_error for it.
+	 */
+	template <typename _Val>
+	class value_bins {
+	public:
+		typedef _Val value_type;
+
+		static const bin_type npos = (bin_type) max_bins;
+
+		template <typename _InputIterator>
+		void assign(_InputIterator first, _InputIterator last) {
+			/* distinct values first, sorting all of them would dominate the load */
+			std::unordered_set<value_type> distinct(first, last);
+			if (max_bins < distinct.size()) { throw std::length_error("Too many distinct values to bin."); }
+			m_values.assign(distinct.begin(), distinct.end());
+			std::sort(m_values.begin(), m_values.end());
+		}
+
+		/* values already distinct and ascending, any number of them: a column split by thresholds is ranked (presort), never coded */
+		void assign_sorted(std::vector<value_type> values) { m_values = std::move(values); }
+
+		tools::size_t size() const { return m_values.size(); }
+
+		const value_type& value(tools::size_t bin) const { assert(bin < m_values.size()); return m_values[bin]; }
+
+		/* npos for a value that was not seen */
+		bin_type code(const value_type& value) const {
+			assert(m_values.size() <= max_bins);
+			auto itr = std::lower_bound(m_values.begin(), m_values.end(), value);
+			return m_values.end() == itr || value < *itr ? npos : (bin_type) (itr - m_values.begin());
+		}
+
+	private:
+		std::vector<value_type> m_values;
+	};
+
+	template <typename _Val>
+	const bin_type value_bins<_Val>::npos;
+
+	/**
+	 * @note Bins of a real valued column by quantiles: at most `bins`
+	 *       bins of about as many rows each, bin b holding the values
+	 *       in (cut(b - 1), cut(b)], the last one everything above. The
+	 *       cuts are taken from a sample of the column, a split "bin <=
+	 *       b" is then the threshold "value <= cut(b)" for any value.
+	 */
+	template <typename _Val>
+	class quantile_bins {
+	public:
+		typedef _Val value_type;
+
+		/* values[0, n) being the sample, reordered */
+		void assign(value_type* values, tools::size_t n, tools::size_t bins) {
+			assert(1 < bins);
+			std::sort(values, values + n);
+
+			m_cuts.clear();
+			for (tools::size_t b = 1; b < bins && 0 < n; ++b) {
+				const value_type cut = values[std::min(n - 1, n * b / bins)];
+				if (m_cuts.empty() || m_cuts.back() < cut) { m_cuts.push_back(cut); }
+			}
+			/* the largest value is no cut, nothing would be above it */
+			if (!m_cuts.empty() && !(m_cuts.back() < values[n - 1])) { m_cuts.pop_back(); }
+		}
+
+		tools::size_t size() const { return m_cuts.size() + 1; }
+
+		/* the largest value of bin, the last bin has none */
+		const value_type& cut(tools::size_t bin) const { assert(bin < m_cuts.size()); return m_cuts[bin]; }
+
+		tools::size_t code(const value_type& value) const {
+			return (tools::size_t) (std::lower_bound(m_cuts.begin(), m_cuts.end(), value) - m_cuts.begin());
+		}
+
+	private:
+		std::vector<value_type> m_cuts;
+	};
+
+	/* entropy (bits) of `total` rows spread over labels as counts[0, labels) */
+	template <typename _Count>
+	double label_entropy(const _Count* counts, tools::size_t labels, tools::size_t total) {
+		double result = 0.0;
+		for (tools::size_t l = 0; l < labels; ++l) {
+			if (0 == counts[l]) { continue; }
+			const double p = (double) counts[l] / total;
+			result -= p * std::log2(p);
+		}
+		return result;
+	}
+
+	/**
+	 * @note Label counts per (attribute, bin) of a set of rows, in one
+	 *       flat array: the counts of bin b of attribute a start at
+	 *       offset(a) + b * labels(). Filling it is a single pass over
+	 *       the rows, and a split can then be scored from the counts
+	 *       alone, without touching the rows again.
+	 */
+	class class_histogram {
+	public:
+		typedef tools::uint32_t count_type;
+
+		class_histogram() : m_labels(0), m_rows(0) { }
+
+		/* bins[a] bins for attribute a, the counts zeroed */
+		class_histogram(const std::vector<tools::size_t>& bins, tools::size_t labels) :
+			m_labels(labels), m_rows(0)
+		{
+			std::vector<tools::size_t> offsets;
+			offsets.reserve(bins.size() + 1);
+			tools::size_t offset = 0;
+			for (tools::size_t each : bins) {
+				offsets.push_back(offset);
+				offset += each * labels;
+			}
+			offsets.push_back(offset);
+			m_offsets = std::make_shared<const std::vector<tools::size_t>>(std::move(offsets));
+			m_counts.assign(offset, 0);
+		}
+
+		tools::size_t attributes() const { return nullptr == m_offsets ? 0 : m_offsets->size() - 1; }
+		tools::size_t bins(tools::size_t attr) const { return (_offset(attr + 1) - _offset(attr)) / m_labels; }
+		tools::size_t labels() const { return m_labels; }
+		tools::size_t rows() const { return m_rows; }
+
+		count_type* at(tools::size_t attr, tools::size_t bin) { return m_counts.data() + _offset(attr) + bin * m_labels; }
+		const count_type* at(tools::size_t attr, tools::size_t bin) const { return m_counts.data() + _offset(attr) + bin * m_labels; }
+
+		/**
+		 * @note Adds the rows index[first, last). Codes are stored row
+		 *       by row, row r's at codes + r * stride with its label code
+		 *       at offset `label`, so each row costs one cache miss
+		 *       however scattered the ids become after partitioning.
+		 */
+		void add(
+			const bin_type*  codes,
+			tools::size_t    stride,
+			tools::size_t    label,
+			const row_index* first,
+			const row_index* last
+		) {
+			count_type* counts = m_counts.data();
+			const tools::size_t* offsets = m_offsets->data();
+			const tools::size_t attrs = attributes();
+			for (const row_index* p = first; p != last; ++p) {
+				const bin_type* row = codes + (tools::size_t) *p * stride;
+				const tools::size_t l = row[label];
+				for (tools::size_t a = 0; a < attrs; ++a) {
+					++counts[offsets[a] + (tools::size_t) row[a] * m_labels + l];
+				}
+			}
+			m_rows += (tools::size_t) (last - first);
+		}
+
+		/* the counts zeroed, the layout kept */
+		void clear() {
+			std::fill(m_counts.begin(), m_counts.end(), 0);
+			m_rows = 0;
+		}
+
+		/* this += other, the histograms of disjoint row sets summed */
+		void add(const class_histogram& other) {
+			assert(m_counts.size() == other.m_counts.size());
+			m_rows += other.m_rows;
+			count_type* out = m_counts.data();
+			const count_type* c = other.m_counts.data();
+			const tools::size_t n = m_counts.size();
+			for (tools::size_t i = 0; i < n; ++i) { out[i] += c[i]; }
+		}
+
+		/* this -= other, the sibling trick: parent minus child, no pass over the sibling's rows */
+		void subtract(const class_histogram& other) {
+			assert(m_counts.size() == other.m_counts.size());
+			m_rows -= other.m_rows;
+			count_type* out = m_counts.data();
+			const count_type* c = other.m_counts.data();
+			const tools::size_t n = m_counts.size();
+			for (tools::size_t i = 0; i < n; ++i) { out[i] -= c[i]; }
+		}
+
+		/* rows falling in bin of attr */
+		count_type count(tools::size_t attr, tools::size_t bin) const {
+			const count_type* counts = at(attr, bin);
+			count_type total = 0;
+			for (tools::size_t l = 0; l < m_labels; ++l) { total += counts[l]; }
+			return total;
+		}
+
+		/* rows per label, read off any attribute since every row is in one of its bins */
+		void label_counts(std::vector<count_type>& out) const {
+			out.assign(m_labels, 0);
+			if (0 == attributes()) { return; }
+			for (tools::size_t b = 0; b < bins(0); ++b) {
+				const count_type* counts = at(0, b);
+				for (tools::size_t l = 0; l < m_labels; ++l) { out[l] += counts[l]; }
+			}
+		}
+
+		/* information gain (bits) of splitting the rows by the bins of attr */
+		double gain(tools::size_t attr, double entropy) const {
+			double result = entropy;
+			for (tools::size_t b = 0; b < bins(attr); ++b) {
+				const count_type* counts = at(attr, b);
+				count_type total = 0;
+				for (tools::size_t l = 0; l < m_labels; ++l) { total += counts[l]; }
+				if (0 == total) { continue; }
+				result -= (double) total / m_rows * _entropy(counts, total);
+			}
+			return result;
+		}
+
+		double entropy() const {
+			std::vector<count_type> counts;
+			label_counts(counts);
+			return _entropy(counts.data(), m_rows);
+		}
+
+	private:
+		tools::size_t _offset(tools::size_t attr) const { return (*m_offsets)[attr]; }
+
+		double _entropy(const count_type* counts, count_type total) const {
+			return label_entropy(counts, m_labels, total);
+		}
+
+		/* the layout is shared by the histograms copied from one another */
+		std::shared_ptr<const std::vector<tools::size_t>> m_offsets;
+		std::vector<count_type>                           m_counts;
+		tools::size_t                                     m_labels;
+		tools::size_t                                     m_rows;
+	};
+
+	/* first and second derivative of the loss of one row */
+	struct gradient_pair {
+		double gradient;
+		double hessian;
+	};
+
+	/**
+	 * @note Sums of the gradient pairs per (feature, bin) of a set of
+	 *       rows, for boosting: bin b of feature f at f * bins() + b.
+	 *       Like class_histogram, filled in one pass over the rows of
+	 *       a node, a sibling's being the parent's minus this one.
+	 */
+	class gradient_histogram {
+	public:
+		gradient_histogram() : m_features(0), m_bins(0) { }
+
+		gradient_histogram(tools::size_t features, tools::size_t bins) :
+			m_sums(features * bins, gradient_pair { 0.0, 0.0 }), m_features(features), m_bins(bins) { }
+
+		tools::size_t features() const { return m_features; }
+		tools::size_t bins() const { return m_bins; }
+
+		const gradient_pair* at(tools::size_t feature) const { return m_sums.data() + feature * m_bins; }
+
+		/* adds the rows index[first, last), row r's codes at codes + r * features() */
+		template <typename _Code>
+		void add(const _Code* codes, const gradient_pair* pairs, const row_index* first, const row_index* last) {
+			gradient_pair* sums = m_sums.data();
+			for (const row_index* p = first; p != last; ++p) {
+				const _Code* row = codes + (tools::size_t) *p * m_features;
+				const gradient_pair pair = pairs[*p];
+				for (tools::size_t f = 0; f < m_features; ++f) {
+					gradient_pair& sum = sums[f * m_bins + row[f]];
+					sum.gradient += pair.gradient;
+					sum.hessian += pair.hessian;
+				}
+			}
+		}
+
+		void clear() { std::fill(m_sums.begin(), m_sums.end(), gradient_pair { 0.0, 0.0 }); }
+
+		void add(const gradient_histogram& other) {
+			assert(m_sums.size() == other.m_sums.size());
+			for (tools::size_t i = 0; i < m_sums.size(); ++i) {
+				m_sums[i].gradient += other.m_sums[i].gradient;
+				m_sums[i].hessian += other.m_sums[i].hessian;
+			}
+		}
+
+		void subtract(const gradient_histogram& other) {
+			assert(m_sums.size() == other.m_sums.size());
+			for (tools::size_t i = 0; i < m_sums.size(); ++i) {
+				m_sums[i].gradient -= other.m_sums[i].gradient;
+				m_sums[i].hessian -= other.m_sums[i].hessian;
+			}
+		}
+
+		/* the sums over all the rows, read off any feature */
+		gradient_pair total() const {
+			gradient_pair result { 0.0, 0.0 };
+			if (0 == m_features) { return result; }
+			for (tools::size_t b = 0; b < m_bins; ++b) {
+				result.gradient += m_sums[b].gradient;
+				result.hessian += m_sums[b].hessian;
+			}
+			return result;
+		}
+
+		/**
+		 * @note The best split of feature into the bins [0, split] and
+		 *       (split, bins), bins being how many of the histogram's
+		 *       the feature uses, by one sweep, scored by the second order
+		 *       gain G_l^2 / (H_l + lambda) + G_r^2 / (H_r + lambda)
+		 *       - G^2 / (H + lambda), a side needing a hessian sum of
+		 *       min_hessian (> 0, empty sides being rounded sums) at
+		 *       least. The lowest double if none.
+		 */
+		double best_split(
+			tools::size_t  feature,
+			tools::size_t  bins,
+			double         lambda,
+			double         min_hessian,
+			tools::size_t& split
+		) const {
+			assert(0.0 < min_hessian);
+			const gradient_pair all = total();
+			const gradient_pair* sums = at(feature);
+			const double parent = all.gradient * all.gradient / (all.hessian + lambda);
+
+			double best = -std::numeric_limits<double>::max();
+			double gl = 0.0, hl = 0.0;
+			for (tools::size_t b = 0; b + 1 < std::min(bins, m_bins); ++b) {
+				gl += sums[b].gradient; hl += sums[b].hessian;
+				const double gr = all.gradient - gl, hr = all.hessian - hl;
+				if (hl < min_hessian || hr < min_hessian) { continue; }
+
+				const double gain = gl * gl / (hl + lambda) + gr * gr / (hr + lambda) - parent;
+				if (best < gain) { best = gain; split = b; }
+			}
+			return best;
+		}
+
+	private:
+		std::vector<gradient_pair> m_sums;
+		tools::size_t              m_features;
+		tools::size_t              m_bins;
+	};
+
+	/**
+	 * @note Groups first[0, n) by key(element), in ascending key order,
+	 *       sizes[k] being how many of them have key k (a histogram has
+	 *       that already), so a node's children end up as consecutive
+	 *       sub-ranges of its own range. A stable counting sort through
+	 *       spare[0, n): the order inside every child is kept, ascending
+	 *       row ids or ascending values, whichever the range had. Nodes
+	 *       own disjoint ranges of first and spare, so they can be
+	 *       partitioned concurrently.
+	 */
+	template <typename _Elem, typename _Count, typename _Key>
+	void partition_by_key(_Elem* first, _Elem* spare, const std::vector<_Count>& sizes, _Key key) {
+		std::vector<tools::size_t> heads(sizes.size());
+
+		tools::size_t n = 0;
+		for (tools::size_t k = 0; k < sizes.size(); ++k) {
+			heads[k] = n;
+			n += sizes[k];
+		}
+
+		for (tools::size_t i = 0; i < n; ++i) { spare[heads[key(first[i])]++] = first[i]; }
+		std::copy(spare, spare + n, first);
+	}
+
+	/* a row of a presorted ordered column: its id, the rank (bin) of its value and its label */
+	/* rank is the number of smaller distinct values, 32 bits like the row ids so it never runs out */
+	struct sorted_row {
+		row_index       row;
+		tools::uint32_t rank;
+		bin_type        label;
+	};
+
+	/**
+	 * @note The rows [0, rows) in ascending order of values[row], ties
+	 *       in row order, the label code labels[row * stride] carried
+	 *       along so sweeping the result never goes back to the rows.
+	 *       The distinct values are left in `distinct`, the one of rank
+	 *       k at k. Ranking by the values themselves instead of by bin
+	 *       codes, a numeric column may have any number of them.
+	 */
+	template <typename _Val>
+	void presort(
+		const _Val*        values,
+		tools::size_t      rows,
+		const bin_type*    labels,
+		tools::size_t      stride,
+		sorted_row*        out,
+		std::vector<_Val>& distinct
+	) {
+		std::vector<std::pair<_Val, row_index>> order(rows);
+		for (tools::size_t r = 0; r < rows; ++r) { order[r] = std::make_pair(values[r], (row_index) r); }
+		std::sort(order.begin(), order.end());
+
+		distinct.clear();
+		for (tools::size_t i = 0; i < rows; ++i) {
+			const row_index row = order[i].second;
+			if (distinct.empty() || distinct.back() < order[i].first) { distinct.push_back(order[i].first); }
+			out[i] = sorted_row { row, (tools::uint32_t) (distinct.size() - 1), labels[(tools::size_t) row * stride] };
+		}
+	}
+
+	/**
+	 * @note The best binary split of the rows first[0, n), sorted by
+	 *       value, into the ranks [0, split] and (split, ...): one sweep
+	 *       keeping the label counts left of the cut, the right ones
+	 *       being totals minus those, scoring a cut wherever the value
+	 *       changes. O(n) whatever the number of distinct values.
+	 *       Returns the gain (bits), or the lowest double when all the
+	 *       rows have one value.
+	 */
+	template <typename _Count>
+	double threshold_gain(
+		const sorted_row*          first,
+		const sorted_row*          last,
+		const std::vector<_Count>& totals,
+		double                     entropy,
+		tools::size_t&             split
+	) {
+		const tools::size_t labels = totals.size(), n = (tools::size_t) (last - first);
+		std::vector<tools::size_t> left(labels, 0), right(totals.begin(), totals.end());
+
+		double best = -std::numeric_limits<double>::max();
+		for (tools::size_t i = 0; i + 1 < n; ++i) {
+			++left[first[i].label]; --right[first[i].label];
+			if (first[i].rank == first[i + 1].rank) { continue; }
+
+			const tools::size_t below = i + 1, above = n - below;
+			const double gain = entropy
+			                  - (double) below / n * label_entropy(left.data(), labels, below)
+			                  - (double) above / n * label_entropy(right.data(), labels, above);
+			if (best < gain) { best = gain; split = first[i].rank; }
+		}
+		return best;
+	}
+}
+
+#endif //_HISTOGRAM_H_
@@ -0,0 +1,183 @@
+/*
+ * Created by Maou Lim on 2019/7/14.
+ */
+
+#ifndef _HOGWILD_H_
+#define _HOGWILD_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../common/defines.h"
+#include "../common/parallel.h"
+
+namespace ml {
+
+	/**
+	 * @note Parameter vector shared by all the hogwild workers. Reads
+	 *       and writes are relaxed atomics, which on the usual targets
+	 *       compile to plain loads and stores: no locks and no
+	 *       read-modify-write, so concurrent updates of one coordinate
+	 *       may overwrite each other. That loss is what Hogwild! trades
+	 *       for speed and is harmless when samples touch few
+	 *       coordinates each.
+	 */
+	template <typename _Value>
+	class shared_parameters {
+	public:
+		typedef _Value        value_type;
+		typedef tools::size_t size_type;
+
+		explicit shared_parameters(size_type dimension, value_type init = value_type(0)) :
+			m_values(new std::atomic<value_type>[dimension]), m_dimension(dimension)
+		{
+			for (size_type i = 0; i < dimension; ++i) { m_values[i].store(init, std::memory_order_relaxed); }
+		}
+
+		size_type dimension() const { return m_dimension; }
+
+		value_type operator[](size_type i) const {
+			assert(i < m_dimension);
+			return m_values[i].load(std::memory_order_relaxed);
+		}
+
+		void store(size_type i, value_type value) {
+			assert(i < m_dimension);
+			m_values[i].store(value, std::memory_order_relaxed);
+		}
+
+		/* racy x[i] += delta */
+		void add(size_type i, value_type delta) {
+			assert(i < m_dimension);
+			m_values[i].store(m_values[i].load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+		}
+
+		template <typename _OutputIterator>
+		void copy_to(_OutputIterator out) const {
+			for (size_type i = 0; i < m_dimension; ++i, ++out) { *out = (*this)[i]; }
+		}
+
+	private:
+		std::unique_ptr<std::atomic<value_type>[]> m_values;
+		size_type                                   m_dimension;
+	};
+
+	/**
+	 * @note How the samples are dealt to the workers.
+	 *       contiguous  : worker t owns the t-th block of samples.
+	 *       interleaved : worker t owns samples t, t + T, t + 2T, ...
+	 *                     which evens out data sorted by label or time.
+	 */
+	enum class sharding { contiguous, interleaved };
+
+	/**
+	 * @note Lock-free asynchronous SGD (Hogwild!). Every worker walks
+	 *       its own shard, reshuffled each epoch, and applies each
+	 *       sample's update to the shared parameters right away.
+	 *
+	 *       The gradient is a functor type called as
+	 *         gradient(theta, sample, update)
+	 *       theta being the shared_parameters (read with operator[]),
+	 *       and it reports the non-zero components through
+	 *       update(index, value), so sparse models only touch the
+	 *       coordinates their samples use. It is shared by the
+	 *       workers, so its operator() must be const and thread-safe.
+	 *       With one thread this is plain sequential SGD.
+	 */
+	template <typename _Sample, typename _Gradient, typename _Value = double>
+	class hogwild_sgd {
+	public:
+		typedef _Sample                   sample_type;
+		typedef _Gradient                 gradient_type;
+		typedef _Value                    value_type;
+		typedef shared_parameters<_Value> param_type;
+
+		hogwild_sgd(
+			tools::size_t dimension,
+			value_type    alpha,
+			gradient_type gradient = gradient_type()
+		) : m_theta(dimension), m_alpha(alpha), m_gradient(gradient),
+		    m_sharding(sharding::contiguous), m_seed(2019) { }
+
+		param_type&       parameters()       { return m_theta; }
+		const param_type& parameters() const { return m_theta; }
+
+		value_type learning_rate() const { return m_alpha; }
+		void set_learning_rate(value_type new_alpha) { m_alpha = new_alpha; }
+
+		void set_sharding(sharding mode) { m_sharding = mode; }
+		void set_seed(tools::uint64_t seed) { m_seed = seed; }
+
+		/**
+		 * @note Runs `epochs` passes over [first, last) on `threads`
+		 *       workers and returns the number of updates applied.
+		 *       Workers do not wait for each other between epochs.
+		 */
+		template <typename _RandomAccessIterator>
+		tools::size_t train(
+			_RandomAccessIterator first,
+			_RandomAccessIterator last,
+			tools::size_t         epochs,
+			tools::size_t         threads = tools::concurrency()
+		) {
+			const tools::size_t count = (tools::size_t) (last - first);
+			if (0 == count || 0 == epochs) { return 0; }
+			if (0 == threads) { threads = 1; }
+			if (count < threads) { threads = count; }
+
+			auto worker = [&, first, count, epochs, threads](tools::size_t id) {
+				std::vector<tools::size_t> shard = _shard(count, threads, id);
+				std::mt19937_64 engine(m_seed + id);
+
+				const gradient_type& gradient = m_gradient;
+				const value_type     alpha    = m_alpha;
+				auto update = [this, alpha](tools::size_t i, value_type g) { m_theta.add(i, -alpha * g); };
+
+				for (tools::size_t epoch = 0; epoch < epochs; ++epoch) {
+					std::shuffle(shard.begin(), shard.end(), engine);
+					for (tools::size_t index : shard) {
+						gradient(m_theta, first[index], update);
+					}
+				}
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(threads - 1);
+			for (tools::size_t id = 1; id < threads; ++id) { workers.emplace_back(worker, id); }
+			worker(0);
+			for (auto& each : workers) { each.join(); }
+
+			return count * epochs;
+		}
+
+	private:
+		std::vector<tools::size_t> _shard(tools::size_t count, tools::size_t threads, tools::size_t id) const {
+			std::vector<tools::size_t> shard;
+			if (sharding::interleaved == m_sharding) {
+				shard.reserve(count / threads + 1);
+				for (tools::size_t i = id; i < count; i += threads) { shard.push_back(i); }
+			}
+			else {
+				const tools::size_t step = count / threads, rest = count % threads;
+				const tools::size_t begin = id * step + (id < rest ? id : rest);
+				const tools::size_t end   = begin + step + (id < rest ? 1 : 0);
+				shard.reserve(end - begin);
+				for (tools::size_t i = begin; i < end; ++i) { shard.push_back(i); }
+			}
+			return shard;
+		}
+
+		param_type      m_theta;
+		value_type      m_alpha;
+		gradient_type   m_gradient;
+		sharding        m_sharding;
+		tools::uint64_t m_seed;
+	};
+}
+
+#endif //_HOGWILD_H_
@@ -5,10 +5,22 @@
 #ifndef _OPTIMIZER_H_
 #define _OPTIMIZER_H_
 
+#include <cassert>
+#include <cmath>
+#include <vector>
+
 #include "../common/defines.h"
+#include "../common/parallel.h"
+#include "../common/trace.h"
 
 namespace ml {
 
+	/**
+	 * @note Plain gradient descent, theta -= alpha * gradient. The
+	 *       step is the virtual update(), which the adaptive
+	 *       optimizers below override, so a model derives from any of
+	 *       them the same way and only supplies gradient().
+	 */
 	template <
 	    typename _Parameter, typename _Sample, typename _Step = double
 	>
@@ -25,17 +37,43 @@ namespace ml {
 		param_type& optimize(param_type&         theta,
 							_SampleSpaceIterator first,
 							_SampleSpaceIterator last ) {
-			theta -= m_alpha * _delta(theta, first, last);
+			update(theta, _delta(theta, first, last));
 			return theta;
 		}
 
 		param_type& optimize(param_type& theta, const sample_type& sample) {
-			theta -= m_alpha * gradient(theta, sample);
+			update(theta, gradient(theta, sample));
+			return theta;
+		}
+
+		/**
+		 * @note Single-sample step for sparse models. sparse_gradient is
+		 *       called as sparse_gradient(theta, sample, update), the
+		 *       contract of hogwild_sgd: it reports the non-zero
+		 *       components through update(index, value) and only those
+		 *       coordinates of theta move, by -alpha * value. This is
+		 *       the plain step, the adaptive optimizers' state is left
+		 *       out.
+		 */
+		template <typename _SparseGradient>
+		param_type& optimize_sparse(
+			param_type&            theta,
+			const sample_type&     sample,
+			const _SparseGradient& sparse_gradient
+		) {
+			const step_type alpha = m_alpha;
+			auto update = [&theta, alpha](tools::size_t i, step_type g) { theta[i] -= alpha * g; };
+			sparse_gradient(theta, sample, update);
 			return theta;
 		}
 
 		virtual param_type gradient(const param_type&, const sample_type&) = 0;
 
+		/* one step along gradient g, usable with gradients computed elsewhere */
+		virtual void update(param_type& theta, const param_type& g) {
+			theta -= m_alpha * g;
+		}
+
 		step_type learning_rate() const { return m_alpha; }
 		void set_learning_rate(step_type new_alpha) { m_alpha = new_alpha; }
 
@@ -44,7 +82,8 @@ namespace ml {
 		param_type _delta(const param_type&    theta,
 		                  _SampleSpaceIterator first,
 		                  _SampleSpaceIterator last ) {
-			param_type result; result *= 0;
+			TOOLS_TRACE_SCOPE("gradient_descent::_delta");
+			param_type result = param_type();
 			tools::size_t count = 0;
 
 			while (first != last) {
@@ -59,6 +98,315 @@ namespace ml {
 	private:
 		step_type m_alpha;
 	};
+
+	/**
+	 * @note The adaptive update kernels: one pass over the parameters,
+	 *       the gradient and the optimizer state, with no branch or call
+	 *       in the loop so it vectorizes. The sqrt of AdaGrad, RMSProp
+	 *       and Adam only does under -fno-math-errno (gcc and clang
+	 *       otherwise keep the scalar libm call for errno).
+	 */
+	template <typename _Value>
+	void _momentum_step(
+		_Value* theta, _Value* velocity, const _Value* g, tools::size_t n,
+		double alpha, double mu, bool nesterov
+	) {
+		const _Value a = (_Value) alpha, m = (_Value) mu;
+		if (nesterov) {
+			for (tools::size_t i = 0; i < n; ++i) {
+				const _Value v = m * velocity[i] + g[i];
+				velocity[i] = v;
+				theta[i] -= a * (g[i] + m * v);
+			}
+		}
+		else {
+			for (tools::size_t i = 0; i < n; ++i) {
+				const _Value v = m * velocity[i] + g[i];
+				velocity[i] = v;
+				theta[i] -= a * v;
+			}
+		}
+	}
+
+	template <typename _Value>
+	void _adagrad_step(
+		_Value* theta, _Value* squares, const _Value* g, tools::size_t n,
+		double alpha, double epsilon
+	) {
+		const _Value a = (_Value) alpha, e = (_Value) epsilon;
+		for (tools::size_t i = 0; i < n; ++i) {
+			const _Value s = squares[i] + g[i] * g[i];
+			squares[i] = s;
+			theta[i] -= a * g[i] / (std::sqrt(s) + e);
+		}
+	}
+
+	template <typename _Value>
+	void _rmsprop_step(
+		_Value* theta, _Value* squares, const _Value* g, tools::size_t n,
+		double alpha, double rho, double epsilon
+	) {
+		const _Value a = (_Value) alpha, r = (_Value) rho, e = (_Value) epsilon;
+		for (tools::size_t i = 0; i < n; ++i) {
+			const _Value s = r * squares[i] + (_Value(1) - r) * g[i] * g[i];
+			squares[i] = s;
+			theta[i] -= a * g[i] / (std::sqrt(s) + e);
+		}
+	}
+
+	/* alpha and epsilon come with the bias corrections of step t folded in */
+	template <typename _Value>
+	void _adam_step(
+		_Value* theta, _Value* first, _Value* second, const _Value* g, tools::size_t n,
+		double alpha, double beta1, double beta2, double epsilon
+	) {
+		const _Value a = (_Value) alpha, b1 = (_Value) beta1, b2 = (_Value) beta2, e = (_Value) epsilon;
+		for (tools::size_t i = 0; i < n; ++i) {
+			const _Value m = b1 * first[i] + (_Value(1) - b1) * g[i];
+			const _Value v = b2 * second[i] + (_Value(1) - b2) * g[i] * g[i];
+			first[i]  = m;
+			second[i] = v;
+			theta[i] -= a * m / (std::sqrt(v) + e);
+		}
+	}
+
+	/* optimizer state shaped like theta, zeroed the first time it is seen */
+	template <typename _Value>
+	_Value* _state_for(std::vector<_Value>& state, tools::size_t n) {
+		if (state.size() != n) { state.assign(n, _Value(0)); }
+		return state.data();
+	}
+
+	/**
+	 * @note Heavy ball momentum, v = mu * v + g and theta -= alpha * v,
+	 *       or with nesterov theta -= alpha * (g + mu * v), the look
+	 *       ahead form that needs no second gradient evaluation.
+	 *       These optimizers take any parameter type with data(),
+	 *       size() and value_type over contiguous elements.
+	 */
+	template <
+	    typename _Parameter, typename _Sample, typename _Step = double
+	>
+	class momentum : public gradient_descent<_Parameter, _Sample, _Step> {
+		typedef gradient_descent<_Parameter, _Sample, _Step> base_type;
+
+	public:
+		typedef typename base_type::param_type  param_type;
+		typedef typename base_type::step_type   step_type;
+		typedef typename _Parameter::value_type value_type;
+
+		explicit momentum(step_type alpha, double mu = 0.9, bool nesterov = false) :
+			base_type(alpha), m_mu(mu), m_nesterov(nesterov) { }
+
+		void update(param_type& theta, const param_type& g) override {
+			assert(theta.size() == g.size());
+			_momentum_step(
+				theta.data(), _state_for(m_velocity, theta.size()), g.data(), theta.size(),
+				(double) this->learning_rate(), m_mu, m_nesterov
+			);
+		}
+
+		void reset() { m_velocity.clear(); }
+
+	private:
+		double                  m_mu;
+		bool                    m_nesterov;
+		std::vector<value_type> m_velocity;
+	};
+
+	/* per coordinate steps alpha / sqrt(sum of the squared gradients so far) */
+	template <
+	    typename _Parameter, typename _Sample, typename _Step = double
+	>
+	class adagrad : public gradient_descent<_Parameter, _Sample, _Step> {
+		typedef gradient_descent<_Parameter, _Sample, _Step> base_type;
+
+	public:
+		typedef typename base_type::param_type  param_type;
+		typedef typename base_type::step_type   step_type;
+		typedef typename _Parameter::value_type value_type;
+
+		explicit adagrad(step_type alpha, double epsilon = 1e-8) :
+			base_type(alpha), m_epsilon(epsilon) { }
+
+		void update(param_type& theta, const param_type& g) override {
+			assert(theta.size() == g.size());
+			_adagrad_step(
+				theta.data(), _state_for(m_squares, theta.size()), g.data(), theta.size(),
+				(double) this->learning_rate(), m_epsilon
+			);
+		}
+
+		void reset() { m_squares.clear(); }
+
+	private:
+		double                  m_epsilon;
+		std::vector<value_type> m_squares;
+	};
+
+	/* AdaGrad with a decaying average (rate rho) instead of the full sum */
+	template <
+	    typename _Parameter, typename _Sample, typename _Step = double
+	>
+	class rmsprop : public gradient_descent<_Parameter, _Sample, _Step> {
+		typedef gradient_descent<_Parameter, _Sample, _Step> base_type;
+
+	public:
+		typedef typename base_type::param_type  param_type;
+		typedef typename base_type::step_type   step_type;
+		typedef typename _Parameter::value_type value_type;
+
+		explicit rmsprop(step_type alpha, double rho = 0.9, double epsilon = 1e-8) :
+			base_type(alpha), m_rho(rho), m_epsilon(epsilon) { }
+
+		void update(param_type& theta, const param_type& g) override {
+			assert(theta.size() == g.size());
+			_rmsprop_step(
+				theta.data(), _state_for(m_squares, theta.size()), g.data(), theta.size(),
+				(double) this->learning_rate(), m_rho, m_epsilon
+			);
+		}
+
+		void reset() { m_squares.clear(); }
+
+	private:
+		double                  m_rho, m_epsilon;
+		std::vector<value_type> m_squares;
+	};
+
+	/**
+	 * @note Adam: decaying averages of the gradient and of its square,
+	 *       bias corrected. The corrections are folded into the step
+	 *       size and epsilon once per update, as in Kingma & Ba's
+	 *       efficient form, so the loop does no extra division.
+	 */
+	template <
+	    typename _Parameter, typename _Sample, typename _Step = double
+	>
+	class adam : public gradient_descent<_Parameter, _Sample, _Step> {
+		typedef gradient_descent<_Parameter, _Sample, _Step> base_type;
+
+	public:
+		typedef typename base_type::param_type  param_type;
+		typedef typename base_type::step_type   step_type;
+		typedef typename _Parameter::value_type value_type;
+
+		explicit adam(step_type alpha, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8) :
+			base_type(alpha), m_beta1(beta1), m_beta2(beta2), m_epsilon(epsilon),
+			m_power1(1.0), m_power2(1.0) { }
+
+		void update(param_type& theta, const param_type& g) override {
+			assert(theta.size() == g.size());
+			const tools::size_t n = theta.size();
+			if (m_first.size() != n) { reset(); }
+
+			m_power1 *= m_beta1;
+			m_power2 *= m_beta2;
+			const double correction = std::sqrt(1.0 - m_power2);
+
+			_adam_step(
+				theta.data(), _state_for(m_first, n), _state_for(m_second, n), g.data(), n,
+				(double) this->learning_rate() * correction / (1.0 - m_power1),
+				m_beta1, m_beta2, m_epsilon * correction
+			);
+		}
+
+		void reset() { m_first.clear(); m_second.clear(); m_power1 = m_power2 = 1.0; }
+
+	private:
+		double                  m_beta1, m_beta2, m_epsilon;
+		double                  m_power1, m_power2;
+		std::vector<value_type> m_first, m_second;
+	};
+
+	/* samples per partial gradient in batched_gradient_descent */
+	constexpr tools::size_t _gradient_block = 512;
+
+	/**
+	 * @note Gradient descent whose gradient is a functor type,
+	 *       _Gradient()(theta, sample) -> param_type, so it is inlined
+	 *       into the batch loop instead of being a virtual call per
+	 *       sample. A batch is cut into blocks of _gradient_block
+	 *       samples that are summed on the pool's threads, then the
+	 *       block sums are added pairwise in a fixed tree. The block
+	 *       boundaries depend on the batch size only, which makes the
+	 *       result bit-for-bit the same for any number of threads.
+	 */
+	template <
+	    typename _Parameter, typename _Sample, typename _Gradient, typename _Step = double
+	>
+	class batched_gradient_descent {
+	public:
+		typedef _Parameter param_type;
+		typedef _Sample    sample_type;
+		typedef _Gradient  gradient_type;
+		typedef _Step      step_type;
+
+		explicit batched_gradient_descent(
+			step_type     alpha,
+			gradient_type gradient = gradient_type(),
+			tools::size_t threads  = tools::concurrency()
+		) : m_alpha(alpha), m_gradient(gradient), m_pool(threads) { }
+
+		template <typename _RandomAccessIterator>
+		param_type& optimize(param_type&           theta,
+		                     _RandomAccessIterator first,
+		                     _RandomAccessIterator last ) {
+			if (first == last) { return theta; }
+			theta -= m_alpha * _delta(theta, first, last);
+			return theta;
+		}
+
+		param_type& optimize(param_type& theta, const sample_type& sample) {
+			theta -= m_alpha * m_gradient(theta, sample);
+			return theta;
+		}
+
+		param_type gradient(const param_type& theta, const sample_type& sample) const {
+			return m_gradient(theta, sample);
+		}
+
+		step_type learning_rate() const { return m_alpha; }
+		void set_learning_rate(step_type new_alpha) { m_alpha = new_alpha; }
+
+		tools::size_t threads() const { return m_pool.size(); }
+
+	private:
+		template <typename _RandomAccessIterator>
+		param_type _delta(const param_type&     theta,
+		                  _RandomAccessIterator first,
+		                  _RandomAccessIterator last ) {
+			TOOLS_TRACE_SCOPE("batched_gradient_descent::_delta");
+			const tools::size_t count  = (tools::size_t) (last - first);
+			const tools::size_t blocks = (count + _gradient_block - 1) / _gradient_block;
+
+			m_partials.resize(blocks);
+
+			m_pool.run(blocks, [&](tools::size_t block) {
+				_RandomAccessIterator itr = first + block * _gradient_block;
+				_RandomAccessIterator end = (block + 1) * _gradient_block < count ?
+					first + (block + 1) * _gradient_block : last;
+
+				param_type sum = param_type();
+				for (; itr != end; ++itr) { sum += m_gradient(theta, *itr); }
+				m_partials[block] = sum;
+			});
+
+			for (tools::size_t width = 1; width < blocks; width *= 2) {
+				for (tools::size_t i = 0; i + width < blocks; i += 2 * width) {
+					m_partials[i] += m_partials[i + width];
+				}
+			}
+
+			return m_partials[0] / count;
+		}
+
+	private:
+		step_type               m_alpha;
+		gradient_type           m_gradient;
+		tools::thread_pool      m_pool;
+		std::vector<param_type> m_partials;
+	};
 }
 
 #endif //_OPTIMIZER_H_
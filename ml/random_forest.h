@@ -0,0 +1,142 @@
+/*
+ * Created by Maou Lim on 2019/7/24.
+ */
+
+#ifndef _RANDOM_FOREST_H_
+#define _RANDOM_FOREST_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../common/parallel.h"
+#include "decision_tree.h"
+
+namespace ml {
+
+	/**
+	 * @note Bagged decision trees with feature subsampling. The matrix
+	 *       is coded once into a tree_data all the trees read, a tree's
+	 *       bootstrap sample is only a vector of row ids, and the trees
+	 *       are grown concurrently, one per task, each on one thread.
+	 *
+	 *       predict votes: a block of rows is walked through every tree
+	 *       before the next block, so the block stays in cache across
+	 *       the trees, and the blocks are spread over the threads.
+	 */
+	template <typename _Attr, typename _Val>
+	class random_forest {
+	public:
+		typedef _Attr                       attr_type;
+		typedef _Val                        value_type;
+		typedef _Val                        label_type;
+		typedef decision_tree<_Attr, _Val>  tree_type;
+		typedef tree_data<_Val>             data_type;
+
+		random_forest() :
+			m_size(100), m_max_features(0), m_seed(2019), m_threads(tools::concurrency()) { }
+
+		/* trees grown by build */
+		size_t trees() const { return m_size; }
+		void set_trees(size_t trees) { assert(0 < trees); m_size = trees; }
+
+		/* attributes drawn at every node, 0 for the square root of their number */
+		size_t max_features() const { return m_max_features; }
+		void set_max_features(size_t features) { m_max_features = features; }
+
+		void set_seed(tools::uint64_t seed) { m_seed = seed; }
+
+		size_t threads() const { return m_threads; }
+		void set_threads(size_t threads) { m_threads = 0 == threads ? 1 : threads; }
+
+		/* as decision_tree::set_numeric */
+		void set_numeric(attr_type attr, bool numeric = true) {
+			assert(0 <= attr);
+			if (m_numeric.size() <= (size_t) attr) { m_numeric.resize(attr + 1, false); }
+			m_numeric[attr] = numeric;
+		}
+
+		const tree_type& tree(size_t i) const { assert(i < m_trees.size()); return *m_trees[i]; }
+
+		template <typename _Matrix2D>
+		void build(const _Matrix2D& matrix) {
+			build(data_type(matrix, m_numeric));
+		}
+
+		void build(const data_type& data) {
+			const size_t rows = data.rows();
+			const size_t features = 0 != m_max_features ? m_max_features :
+				std::max<size_t>(1, (size_t) std::lround(std::sqrt((double) data.attributes())));
+
+			m_labels = data.labels();
+			m_trees.clear();
+			m_trees.resize(m_size);
+
+			/* a tree's draw depends on its number alone, not on the thread growing it */
+			tools::thread_pool pool(std::min(m_threads, m_size));
+			pool.run(m_size, [this, &data, rows, features](size_t t) {
+				std::mt19937_64 engine(m_seed + t);
+				std::uniform_int_distribution<size_t> draw(0, rows - 1);
+
+				std::vector<row_index> sample(rows);
+				for (auto& each : sample) { each = (row_index) draw(engine); }
+
+				std::unique_ptr<tree_type> tree(new tree_type());
+				tree->set_threads(1);
+				tree->set_max_features(features);
+				tree->set_seed(engine());
+				tree->build(data, sample);
+				m_trees[t] = std::move(tree);
+			});
+		}
+
+		/* the label most trees give, the lowest of the tied ones */
+		template <typename _Matrix2D>
+		std::vector<label_type> predict(const _Matrix2D& matrix) const {
+			assert(!m_trees.empty());
+
+			const size_t rows = matrix.rows(), labels = m_labels.size();
+			const size_t blocks = (rows + _predict_block - 1) / _predict_block;
+			std::vector<label_type> result(rows);
+
+			tools::thread_pool pool(std::max<size_t>(1, std::min(m_threads, blocks)));
+			pool.run(blocks, [this, &matrix, &result, rows, labels](size_t block) {
+				const size_t first = block * _predict_block;
+				const size_t n = std::min(_predict_block, rows - first);
+
+				std::vector<label_type> given(n);
+				std::vector<tools::uint32_t> votes(n * labels, 0);
+				for (const auto& each : m_trees) {
+					each->predict(matrix, first, first + n, given.data());
+					for (size_t k = 0; k < n; ++k) { ++votes[k * labels + m_labels.code(given[k])]; }
+				}
+
+				for (size_t k = 0; k < n; ++k) {
+					const tools::uint32_t* counts = votes.data() + k * labels;
+					result[first + k] = m_labels.value((bin_type) (std::max_element(counts, counts + labels) - counts));
+				}
+			});
+			return result;
+		}
+
+	private:
+		static const size_t _predict_block = 256;
+
+		std::vector<std::unique_ptr<tree_type>> m_trees;
+		value_bins<label_type>                  m_labels;
+
+		size_t            m_size;
+		size_t            m_max_features;
+		tools::uint64_t   m_seed;
+		size_t            m_threads;
+		std::vector<bool> m_numeric;
+	};
+
+	template <typename _Attr, typename _Val>
+	const size_t random_forest<_Attr, _Val>::_predict_block;
+}
+
+#endif //_RANDOM_FOREST_H_
@@ -5,46 +5,614 @@
 #ifndef _TOYBRICKS_TENSOR_H_
 #define _TOYBRICKS_TENSOR_H_
 
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <memory>
+
 #include "../common/defines.h"
-#include "../container/sequence.h"
+#include "../math/math_common.h"
 
 namespace ml {
 
-//	struct shape {
-//
-//
-//	private:
-//		tools::sequence<size_t>
-//	};
+	constexpr tools::size_t max_rank = 8;
 
-	template <typename _Shape, typename _Value>
-	class tensor {
+	/* extents of up to max_rank dimensions, kept inline */
+	class shape {
+	public:
+		typedef tools::size_t size_type;
+
+		shape() : m_rank(0) { }
+
+		shape(std::initializer_list<size_type> dims) : m_rank(0) {
+			assert(dims.size() <= max_rank);
+			for (size_type each : dims) { m_dims[m_rank++] = each; }
+		}
+
+		template <typename _InputIterator>
+		shape(_InputIterator first, _InputIterator last) : m_rank(0) {
+			for (; first != last; ++first) {
+				assert(m_rank < max_rank);
+				m_dims[m_rank++] = *first;
+			}
+		}
+
+		size_type rank() const { return m_rank; }
+
+		/* number of elements, 1 for rank 0 */
+		size_type size() const {
+			size_type result = 1;
+			for (size_type i = 0; i < m_rank; ++i) { result *= m_dims[i]; }
+			return result;
+		}
+
+		size_type operator[](size_type axis) const { assert(axis < m_rank); return m_dims[axis]; }
+		size_type& operator[](size_type axis) { assert(axis < m_rank); return m_dims[axis]; }
+
+		const size_type* begin() const { return m_dims; }
+		const size_type* end()   const { return m_dims + m_rank; }
+
+		void push_back(size_type dim) { assert(m_rank < max_rank); m_dims[m_rank++] = dim; }
+
+		void erase(size_type axis) {
+			assert(axis < m_rank);
+			for (size_type i = axis + 1; i < m_rank; ++i) { m_dims[i - 1] = m_dims[i]; }
+			--m_rank;
+		}
 
-		typedef tensor<_Shape, _Value>  self_type;
-		typedef tools::sequence<_Value> buff_type;
+		bool operator==(const shape& other) const {
+			if (m_rank != other.m_rank) { return false; }
+			for (size_type i = 0; i < m_rank; ++i) {
+				if (m_dims[i] != other.m_dims[i]) { return false; }
+			}
+			return true;
+		}
+
+		bool operator!=(const shape& other) const { return !(*this == other); }
+
+	private:
+		size_type m_dims[max_rank];
+		size_type m_rank;
+	};
+
+	/**
+	 * @note Numpy rules: shapes are aligned on their last axis and each
+	 *       pair of extents must be equal or contain a 1. Returns false
+	 *       when they are not compatible.
+	 */
+	inline bool broadcast_shape(const shape& a, const shape& b, shape& result) {
+		const tools::size_t rank = a.rank() < b.rank() ? b.rank() : a.rank();
+
+		result = shape();
+		for (tools::size_t i = 0; i < rank; ++i) {
+			const tools::size_t da = i + a.rank() < rank ? 1 : a[i + a.rank() - rank];
+			const tools::size_t db = i + b.rank() < rank ? 1 : b[i + b.rank() - rank];
+			if (da != db && 1 != da && 1 != db) { return false; }
+			result.push_back(1 == da ? db : da);
+		}
+		return true;
+	}
+
+	/**
+	 * @note Calls inner(offsets, n, steps) for every innermost row of
+	 *       an iteration space `dims` walked by several operands at
+	 *       once, operand k starting at offsets[k] and moving by
+	 *       strides[k][axis]. Rank 0 is a single row of one element.
+	 */
+	template <tools::size_t _Operands, typename _Inner>
+	void _nd_rows(
+		const shape&        dims,
+		const tools::size_t (&strides)[_Operands][max_rank],
+		tools::size_t       (&offsets)[_Operands],
+		_Inner              inner
+	) {
+		const tools::size_t rank = dims.rank();
+		if (0 == rank) {
+			tools::size_t steps[_Operands] = { 0 };
+			inner(offsets, 1, steps);
+			return;
+		}
+
+		for (tools::size_t axis = 0; axis < rank; ++axis) {
+			if (0 == dims[axis]) { return; }
+		}
+
+		tools::size_t steps[_Operands];
+		for (tools::size_t k = 0; k < _Operands; ++k) { steps[k] = strides[k][rank - 1]; }
+
+		tools::size_t counter[max_rank] = { 0 };
+		tools::size_t cursor[_Operands];
+		for (tools::size_t k = 0; k < _Operands; ++k) { cursor[k] = offsets[k]; }
+
+		while (true) {
+			inner(cursor, dims[rank - 1], steps);
+
+			tools::size_t axis = rank - 1;
+			while (0 < axis) {
+				--axis;
+				++counter[axis];
+				for (tools::size_t k = 0; k < _Operands; ++k) { cursor[k] += strides[k][axis]; }
+				if (counter[axis] < dims[axis]) { break; }
+
+				for (tools::size_t k = 0; k < _Operands; ++k) { cursor[k] -= strides[k][axis] * dims[axis]; }
+				counter[axis] = 0;
+				if (0 == axis) { return; }
+			}
+			if (1 == rank) { return; }
+		}
+	}
+
+	template <typename _Value>
+	class tensor;
+
+	template <typename _Value>
+	void _copy_strides(tools::size_t (&out)[max_rank], const tensor<_Value>& t) {
+		std::copy(t.strides(), t.strides() + t.rank(), out);
+	}
+
+	/**
+	 * @note Dense N-d array: a shared buffer plus an offset, a shape and
+	 *       per-axis strides (in elements). Slicing, selecting,
+	 *       transposing, permuting, broadcasting and reshaping a
+	 *       contiguous tensor all return views sharing the buffer, so
+	 *       writing through a view writes the original. Copying a
+	 *       tensor copies the handle; clone() copies the data.
+	 *
+	 *       Element-wise operations broadcast, allocate a contiguous
+	 *       result, and run a flat loop (or the math_common kernels for
+	 *       exp, log, sigmoid and tanh) when the operands are contiguous
+	 *       and of one shape; otherwise they walk the strides row by row.
+	 */
+	template <typename _Value>
+	class tensor {
+		typedef tensor<_Value> self_type;
 
 	public:
 		typedef _Value        value_type;
-		typedef _Shape        shape_type;
-		typedef shape_type    index_type;
+		typedef _Value&       reference;
+		typedef const _Value& const_reference;
+		typedef _Value*       pointer;
+		typedef const _Value* const_pointer;
 		typedef tools::size_t size_type;
-		typedef size_type     dim_type;
+		typedef ml::shape     shape_type;
+
+		tensor() : m_offset(0) { _set_contiguous_strides(); }
+
+		explicit tensor(const shape_type& dims, value_type init = value_type(0)) :
+			m_buffer(_allocate(dims.size())), m_offset(0), m_shape(dims)
+		{
+			_set_contiguous_strides();
+			std::fill(m_buffer.get(), m_buffer.get() + dims.size(), init);
+		}
+
+		tensor(const shape_type& dims, std::initializer_list<value_type> values) :
+			m_buffer(_allocate(dims.size())), m_offset(0), m_shape(dims)
+		{
+			assert(values.size() == dims.size());
+			_set_contiguous_strides();
+			std::copy(values.begin(), values.end(), m_buffer.get());
+		}
+
+		const shape_type& shape() const { return m_shape; }
+
+		size_type rank() const { return m_shape.rank(); }
+		size_type size() const { return m_shape.size(); }
+		size_type dim(size_type axis) const { return m_shape[axis]; }
+		size_type stride(size_type axis) const { assert(axis < rank()); return m_strides[axis]; }
+		const size_type* strides() const { return m_strides; }
+
+		bool empty() const { return nullptr == m_buffer; }
+
+		/* row-major without gaps, what the flat fast paths need */
+		bool contiguous() const {
+			size_type expected = 1;
+			for (size_type i = rank(); 0 < i; --i) {
+				if (1 != m_shape[i - 1] && m_strides[i - 1] != expected) { return false; }
+				expected *= m_shape[i - 1];
+			}
+			return true;
+		}
+
+		bool shares_storage(const self_type& other) const { return m_buffer == other.m_buffer; }
+
+		/* no other tensor or view holds the buffer, so it can be overwritten freely */
+		bool unique() const { return 1 == m_buffer.use_count(); }
 
-		shape_type shape() const { return m_shape; }
-		dim_type dim() const { return m_shape.size(); }
+		pointer data() { return m_buffer.get() + m_offset; }
+		const_pointer data() const { return m_buffer.get() + m_offset; }
 
-		value_type at(const index_type& index) {
-			return m_buff[index.hash_val()];
+		template <typename... _Index>
+		reference operator()(_Index... index) {
+			assert(sizeof...(_Index) == rank());
+			return data()[_offset_of(index...)];
 		}
 
-		value_type at(const index_type& index) const {
-			return m_buff[index.hash_val()];
+		template <typename... _Index>
+		const_reference operator()(_Index... index) const {
+			assert(sizeof...(_Index) == rank());
+			return data()[_offset_of(index...)];
 		}
 
+		reference at(std::initializer_list<size_type> index) {
+			return data()[_offset_of(index)];
+		}
+
+		const_reference at(std::initializer_list<size_type> index) const {
+			return data()[_offset_of(index)];
+		}
+
+		/* elements first, first + step, ... below last along axis */
+		self_type slice(size_type axis, size_type first, size_type last, size_type step = 1) const {
+			assert(axis < rank() && first <= last && last <= m_shape[axis] && 0 < step);
+			self_type view = *this;
+			view.m_offset += first * m_strides[axis];
+			view.m_shape[axis] = (last - first + step - 1) / step;
+			view.m_strides[axis] *= step;
+			return view;
+		}
+
+		/* the sub-tensor at index along axis, one rank less */
+		self_type select(size_type axis, size_type index) const {
+			assert(axis < rank() && index < m_shape[axis]);
+			self_type view = *this;
+			view.m_offset += index * m_strides[axis];
+			view.m_shape.erase(axis);
+			for (size_type i = axis + 1; i < rank(); ++i) { view.m_strides[i - 1] = m_strides[i]; }
+			return view;
+		}
+
+		/* axis i of the view is axis order[i] of this */
+		self_type permute(std::initializer_list<size_type> order) const {
+			assert(order.size() == rank());
+			self_type view = *this;
+			size_type i = 0;
+			for (size_type axis : order) {
+				assert(axis < rank());
+				view.m_shape[i]   = m_shape[axis];
+				view.m_strides[i] = m_strides[axis];
+				++i;
+			}
+			return view;
+		}
+
+		/* axes reversed, the matrix transpose for rank 2 */
+		self_type transpose() const {
+			self_type view = *this;
+			for (size_type i = 0; i < rank(); ++i) {
+				view.m_shape[i]   = m_shape[rank() - 1 - i];
+				view.m_strides[i] = m_strides[rank() - 1 - i];
+			}
+			return view;
+		}
+
+		/* a view when contiguous, a reshaped copy otherwise */
+		self_type reshape(const shape_type& dims) const {
+			assert(dims.size() == size());
+			self_type result = contiguous() ? *this : clone();
+			result.m_shape = dims;
+			result._set_contiguous_strides();
+			return result;
+		}
+
+		/* read-only use intended: broadcast axes have stride 0 */
+		self_type broadcast_to(const shape_type& dims) const {
+			shape_type common;
+			const bool compatible = broadcast_shape(m_shape, dims, common);
+			assert(compatible && common == dims); (void) compatible;
+
+			self_type view = *this;
+			view.m_shape = dims;
+			const size_type lead = dims.rank() - rank();
+			for (size_type i = 0; i < dims.rank(); ++i) {
+				view.m_strides[i] = i < lead || 1 == m_shape[i - lead] ? 0 : m_strides[i - lead];
+			}
+			return view;
+		}
+
+		self_type clone() const {
+			self_type result(m_shape);
+			result.assign(*this);
+			return result;
+		}
+
+		/* this itself when contiguous, a contiguous copy otherwise */
+		self_type compact() const { return contiguous() ? *this : clone(); }
+
+		void fill(value_type value) {
+			apply([value](value_type& x) { x = value; });
+		}
+
+		/* copies src, broadcast to this shape, into this (and so into the tensors it views) */
+		self_type& assign(const self_type& src) {
+			return apply(src, [](value_type& x, value_type y) { x = y; });
+		}
+
+		/* op(element) on every element in place */
+		template <typename _Op>
+		self_type& apply(_Op op) {
+			if (contiguous()) {
+				pointer p = data();
+				const size_type n = size();
+				for (size_type i = 0; i < n; ++i) { op(p[i]); }
+				return *this;
+			}
+
+			size_type strides[1][max_rank];
+			_copy_strides(strides[0], *this);
+
+			size_type offsets[1] = { 0 };
+			pointer p = data();
+			_nd_rows<1>(m_shape, strides, offsets, [p, &op](const size_type* at, size_type n, const size_type* steps) {
+				for (size_type i = 0; i < n; ++i) { op(p[at[0] + i * steps[0]]); }
+			});
+			return *this;
+		}
+
+		/* op(element, other element) in place, other broadcast to this shape */
+		template <typename _Op>
+		self_type& apply(const self_type& other, _Op op) {
+			if (other.m_shape == m_shape && contiguous() && other.contiguous()) {
+				pointer p = data();
+				const_pointer q = other.data();
+				const size_type n = size();
+				for (size_type i = 0; i < n; ++i) { op(p[i], q[i]); }
+				return *this;
+			}
+
+			const self_type src = other.broadcast_to(m_shape);
+			size_type strides[2][max_rank];
+			_copy_strides(strides[0], *this);
+			_copy_strides(strides[1], src);
+
+			size_type offsets[2] = { 0, 0 };
+			pointer p = data();
+			const_pointer q = src.data();
+			_nd_rows<2>(m_shape, strides, offsets, [p, q, &op](const size_type* at, size_type n, const size_type* steps) {
+				for (size_type i = 0; i < n; ++i) { op(p[at[0] + i * steps[0]], q[at[1] + i * steps[1]]); }
+			});
+			return *this;
+		}
+
+		self_type& operator+=(const self_type& other) { return apply(other, [](value_type& x, value_type y) { x += y; }); }
+		self_type& operator-=(const self_type& other) { return apply(other, [](value_type& x, value_type y) { x -= y; }); }
+		self_type& operator*=(const self_type& other) { return apply(other, [](value_type& x, value_type y) { x *= y; }); }
+		self_type& operator/=(const self_type& other) { return apply(other, [](value_type& x, value_type y) { x /= y; }); }
+
+		self_type& operator+=(value_type s) { return apply([s](value_type& x) { x += s; }); }
+		self_type& operator-=(value_type s) { return apply([s](value_type& x) { x -= s; }); }
+		self_type& operator*=(value_type s) { return apply([s](value_type& x) { x *= s; }); }
+		self_type& operator/=(value_type s) { return apply([s](value_type& x) { x /= s; }); }
+
 	private:
-		shape_type m_shape;
-		buff_type  m_buff;
+		static std::shared_ptr<value_type> _allocate(size_type n) {
+			return std::shared_ptr<value_type>(new value_type[0 == n ? 1 : n], std::default_delete<value_type[]>());
+		}
+
+		void _set_contiguous_strides() {
+			size_type stride = 1;
+			for (size_type i = rank(); 0 < i; --i) {
+				m_strides[i - 1] = stride;
+				stride *= m_shape[i - 1];
+			}
+		}
+
+		size_type _offset_of() const { return 0; }
+
+		template <typename... _Rest>
+		size_type _offset_of(size_type first, _Rest... rest) const {
+			const size_type axis = rank() - 1 - sizeof...(_Rest);
+			assert(first < m_shape[axis]);
+			return first * m_strides[axis] + _offset_of(rest...);
+		}
+
+		size_type _offset_of(std::initializer_list<size_type> index) const {
+			assert(index.size() == rank());
+			size_type result = 0, axis = 0;
+			for (size_type each : index) {
+				assert(each < m_shape[axis]);
+				result += each * m_strides[axis++];
+			}
+			return result;
+		}
+
+		std::shared_ptr<value_type> m_buffer;
+		size_type                   m_offset;
+		shape_type                  m_shape;
+		size_type                   m_strides[max_rank];
 	};
+
+
+	/* f(element) into a new contiguous tensor */
+	template <typename _Value, typename _Fn>
+	tensor<_Value> map(const tensor<_Value>& a, _Fn fn) {
+		tensor<_Value> result(a.shape());
+		_Value* out = result.data();
+
+		if (a.contiguous()) {
+			const _Value* in = a.data();
+			const tools::size_t n = a.size();
+			for (tools::size_t i = 0; i < n; ++i) { out[i] = fn(in[i]); }
+			return result;
+		}
+
+		tools::size_t strides[2][max_rank];
+		_copy_strides(strides[0], result);
+		_copy_strides(strides[1], a);
+
+		tools::size_t offsets[2] = { 0, 0 };
+		const _Value* in = a.data();
+		_nd_rows<2>(a.shape(), strides, offsets, [out, in, &fn](const tools::size_t* at, tools::size_t n, const tools::size_t* steps) {
+			for (tools::size_t i = 0; i < n; ++i) { out[at[0] + i] = fn(in[at[1] + i * steps[1]]); }
+		});
+		return result;
+	}
+
+	/* f(a element, b element) over the broadcast shape into a new tensor */
+	template <typename _Value, typename _Fn>
+	tensor<_Value> zip(const tensor<_Value>& a, const tensor<_Value>& b, _Fn fn) {
+		if (a.shape() == b.shape() && a.contiguous() && b.contiguous()) {
+			tensor<_Value> result(a.shape());
+			_Value* out = result.data();
+			const _Value* pa = a.data();
+			const _Value* pb = b.data();
+			const tools::size_t n = a.size();
+			for (tools::size_t i = 0; i < n; ++i) { out[i] = fn(pa[i], pb[i]); }
+			return result;
+		}
+
+		shape common;
+		const bool compatible = broadcast_shape(a.shape(), b.shape(), common);
+		assert(compatible); (void) compatible;
+
+		tensor<_Value> result(common);
+		const tensor<_Value> va = a.broadcast_to(common);
+		const tensor<_Value> vb = b.broadcast_to(common);
+
+		tools::size_t strides[3][max_rank];
+		_copy_strides(strides[0], result);
+		_copy_strides(strides[1], va);
+		_copy_strides(strides[2], vb);
+
+		tools::size_t offsets[3] = { 0, 0, 0 };
+		_Value* out = result.data();
+		const _Value* pa = va.data();
+		const _Value* pb = vb.data();
+		_nd_rows<3>(common, strides, offsets, [out, pa, pb, &fn](const tools::size_t* at, tools::size_t n, const tools::size_t* steps) {
+			for (tools::size_t i = 0; i < n; ++i) {
+				out[at[0] + i] = fn(pa[at[1] + i * steps[1]], pb[at[2] + i * steps[2]]);
+			}
+		});
+		return result;
+	}
+
+	template <typename _Value>
+	tensor<_Value> operator+(const tensor<_Value>& a, const tensor<_Value>& b) {
+		return zip(a, b, [](_Value x, _Value y) { return x + y; });
+	}
+
+	template <typename _Value>
+	tensor<_Value> operator-(const tensor<_Value>& a, const tensor<_Value>& b) {
+		return zip(a, b, [](_Value x, _Value y) { return x - y; });
+	}
+
+	template <typename _Value>
+	tensor<_Value> operator*(const tensor<_Value>& a, const tensor<_Value>& b) {
+		return zip(a, b, [](_Value x, _Value y) { return x * y; });
+	}
+
+	template <typename _Value>
+	tensor<_Value> operator/(const tensor<_Value>& a, const tensor<_Value>& b) {
+		return zip(a, b, [](_Value x, _Value y) { return x / y; });
+	}
+
+	template <typename _Value>
+	tensor<_Value> operator+(const tensor<_Value>& a, _Value s) { return map(a, [s](_Value x) { return x + s; }); }
+
+	template <typename _Value>
+	tensor<_Value> operator-(const tensor<_Value>& a, _Value s) { return map(a, [s](_Value x) { return x - s; }); }
+
+	template <typename _Value>
+	tensor<_Value> operator*(const tensor<_Value>& a, _Value s) { return map(a, [s](_Value x) { return x * s; }); }
+
+	template <typename _Value>
+	tensor<_Value> operator/(const tensor<_Value>& a, _Value s) { return map(a, [s](_Value x) { return x / s; }); }
+
+	template <typename _Value>
+	tensor<_Value> operator+(_Value s, const tensor<_Value>& a) { return a + s; }
+
+	template <typename _Value>
+	tensor<_Value> operator-(_Value s, const tensor<_Value>& a) { return map(a, [s](_Value x) { return s - x; }); }
+
+	template <typename _Value>
+	tensor<_Value> operator*(_Value s, const tensor<_Value>& a) { return a * s; }
+
+	template <typename _Value>
+	tensor<_Value> operator/(_Value s, const tensor<_Value>& a) { return map(a, [s](_Value x) { return s / x; }); }
+
+	template <typename _Value>
+	tensor<_Value> operator-(const tensor<_Value>& a) { return map(a, [](_Value x) { return -x; }); }
+
+	/* the vectorized math_common kernels on a contiguous copy */
+	template <math::precision _Mode = math::precision::accurate, typename _Value>
+	tensor<_Value> exp(const tensor<_Value>& a) {
+		const tensor<_Value> src = a.compact();
+		tensor<_Value> result(a.shape());
+		math::exp<_Mode>(src.data(), src.size(), result.data());
+		return result;
+	}
+
+	template <math::precision _Mode = math::precision::accurate, typename _Value>
+	tensor<_Value> log(const tensor<_Value>& a) {
+		const tensor<_Value> src = a.compact();
+		tensor<_Value> result(a.shape());
+		math::log<_Mode>(src.data(), src.size(), result.data());
+		return result;
+	}
+
+	template <math::precision _Mode = math::precision::accurate, typename _Value>
+	tensor<_Value> sigmoid(const tensor<_Value>& a) {
+		const tensor<_Value> src = a.compact();
+		tensor<_Value> result(a.shape());
+		math::sigmoid<_Mode>(src.data(), src.size(), result.data());
+		return result;
+	}
+
+	template <math::precision _Mode = math::precision::accurate, typename _Value>
+	tensor<_Value> tanh(const tensor<_Value>& a) {
+		const tensor<_Value> src = a.compact();
+		tensor<_Value> result(a.shape());
+		math::tanh<_Mode>(src.data(), src.size(), result.data());
+		return result;
+	}
+
+	template <typename _Value>
+	_Value sum(const tensor<_Value>& a) {
+		_Value result = _Value(0);
+		tensor<_Value>(a).apply([&result](_Value& x) { result += x; });
+		return result;
+	}
+
+	/* sums along axis, which is kept with extent 1 so the result broadcasts back */
+	template <typename _Value>
+	tensor<_Value> sum(const tensor<_Value>& a, tools::size_t axis) {
+		assert(axis < a.rank());
+
+		shape dims = a.shape();
+		dims[axis] = 1;
+		tensor<_Value> result(dims);
+
+		for (tools::size_t i = 0; i < a.dim(axis); ++i) {
+			result += a.slice(axis, i, i + 1);
+		}
+		return result;
+	}
+
+	/**
+	 * @note Matrix product of rank 2 tensors, i-k-j order over
+	 *       contiguous copies so the inner loop streams both rows.
+	 */
+	template <typename _Value>
+	tensor<_Value> matmul(const tensor<_Value>& a, const tensor<_Value>& b) {
+		assert(2 == a.rank() && 2 == b.rank() && a.dim(1) == b.dim(0));
+
+		const tensor<_Value> lhs = a.compact(), rhs = b.compact();
+		const tools::size_t rows = a.dim(0), inner = a.dim(1), cols = b.dim(1);
+
+		tensor<_Value> result(shape { rows, cols });
+		_Value* out = result.data();
+		const _Value* pa = lhs.data();
+		const _Value* pb = rhs.data();
+
+		for (tools::size_t i = 0; i < rows; ++i) {
+			_Value* row = out + i * cols;
+			for (tools::size_t k = 0; k < inner; ++k) {
+				const _Value scale = pa[i * inner + k];
+				const _Value* brow = pb + k * cols;
+				for (tools::size_t j = 0; j < cols; ++j) { row[j] += scale * brow[j]; }
+			}
+		}
+		return result;
+	}
 }
 
 #endif //TOYBRICKS_TENSOR_H
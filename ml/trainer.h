@@ -6,10 +6,113 @@
 #define _TRAINER_H_
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "data_source.h"
 
 namespace ml {
 
+	/**
+	 * @note Random access iterator over the samples picked by a range
+	 *       of indices, a mini-batch that is a slice of a permutation
+	 *       instead of a copy of the samples.
+	 */
+	template <typename _Container>
+	class batch_iterator {
+		typedef batch_iterator<_Container> self_type;
+
+	public:
+		typedef std::random_access_iterator_tag           iterator_category;
+		typedef typename _Container::value_type           value_type;
+		typedef const value_type&                         reference;
+		typedef const value_type*                         pointer;
+		typedef std::ptrdiff_t                            difference_type;
+
+		batch_iterator() : m_samples(nullptr), m_index(nullptr) { }
+
+		batch_iterator(const _Container& samples, const size_t* index) :
+			m_samples(&samples), m_index(index) { }
+
+		reference operator*() const { return (*m_samples)[*m_index]; }
+		pointer operator->() const { return &operator*(); }
+		reference operator[](difference_type n) const { return (*m_samples)[m_index[n]]; }
+
+		self_type& operator++() { ++m_index; return *this; }
+		self_type operator++(int) { self_type tmp = *this; ++m_index; return tmp; }
+		self_type& operator--() { --m_index; return *this; }
+		self_type operator--(int) { self_type tmp = *this; --m_index; return tmp; }
+
+		self_type& operator+=(difference_type n) { m_index += n; return *this; }
+		self_type& operator-=(difference_type n) { m_index -= n; return *this; }
+		self_type operator+(difference_type n) const { return self_type(*m_samples, m_index + n); }
+		self_type operator-(difference_type n) const { return self_type(*m_samples, m_index - n); }
+
+		difference_type operator-(const self_type& other) const { return m_index - other.m_index; }
+
+		bool operator==(const self_type& other) const { return m_index == other.m_index; }
+		bool operator!=(const self_type& other) const { return m_index != other.m_index; }
+		bool operator<(const self_type& other) const { return m_index < other.m_index; }
+
+	private:
+		const _Container* m_samples;
+		const size_t*     m_index;
+	};
+
+	/* what the trainer reports after each epoch */
+	struct epoch_report {
+		size_t epoch;              // epochs done, starting from 1
+		double error;              // mean trainer::error over the samples
+		double seconds;            // wall time of this epoch
+		double samples_per_second;
+	};
+
+	/**
+	 * @note Stopping conditions, train() keeps going while
+	 *       condition(report) is true. Combine them with either().
+	 *       They are asked before the first epoch too, with epoch 0,
+	 *       so max_epochs(0) trains nothing.
+	 */
+	struct max_epochs {
+		explicit max_epochs(size_t n) : limit(n) { }
+		bool operator()(const epoch_report& report) const { return report.epoch < limit; }
+		size_t limit;
+	};
+
+	struct min_error {
+		explicit min_error(double e) : limit(e) { }
+		bool operator()(const epoch_report& report) const { return limit < report.error; }
+		double limit;
+	};
+
+	struct time_budget {
+		explicit time_budget(double s) : limit(s), spent(0.0) { }
+		bool operator()(const epoch_report& report) { spent += report.seconds; return spent < limit; }
+		double limit, spent;
+	};
+
+	/* stops as soon as one of the two would */
+	template <typename _First, typename _Second>
+	struct _either_condition {
+		bool operator()(const epoch_report& report) {
+			const bool go_on = first(report);
+			return second(report) && go_on;
+		}
+		_First  first;
+		_Second second;
+	};
+
+	template <typename _First, typename _Second>
+	_either_condition<_First, _Second> either(_First first, _Second second) {
+		return _either_condition<_First, _Second> { first, second };
+	}
+
 	template <
 	    typename _Trainee,
 	    typename _Sample,
@@ -27,47 +130,181 @@ namespace ml {
 		typedef double     error_type;
 
 		typedef typename _Container::value_type sample_type;
-		typedef typename _Container::iterator   sample_iterator;
+		typedef batch_iterator<_Container>      sample_iterator;
 
-		static_assert(std::is_same<sample_type, _Sample>::value);
+		typedef std::function<void(const epoch_report&)> reporter_type;
+
+		static_assert(std::is_same<sample_type, _Sample>::value, "sample type mismatch.");
 
 		enum training_mode { one_by_one, random, mini_batch };
 
+		trainer() : m_engine(std::mt19937_64::default_seed) { }
+		virtual ~trainer() = default;
+
+		/**
+		 * @note Runs epochs until condition(report) turns false and
+		 *       returns how many ran. Per epoch:
+		 *         one_by_one : every sample in feeding order.
+		 *         random     : every sample in a fresh random order.
+		 *         mini_batch : the shuffled order cut into batches of
+		 *                      `batch` samples (the last may be short).
+		 *       Batches are views over an index permutation that is
+		 *       reshuffled in place, no sample is ever copied.
+		 */
 		template <typename _Condition>
 		size_t train(
+			trainee_type& trainee  ,
 			_Condition    condition,
 			training_mode mode     ,
 			step_type     rate     ,
 			size_t        batch = 1
 		) {
-			epoch_type epoch = 0;
+			typedef std::chrono::steady_clock clock_type;
 
+			const size_t count = m_samples.size();
+			if (0 == count) { return 0; }
+			if (0 == batch) { batch = 1; }
+
+			if (m_order.size() != count) {
+				m_order.resize(count);
+				for (size_t i = 0; i < count; ++i) { m_order[i] = i; }
+			}
 
 			optimizer_type optimizer(rate);
 
-			//while (condition(epoch, error, time)) {
-			//	switch (mode) {
-			//
-			//	}
-			//}
+			epoch_report report { 0, _mean_error(trainee), 0.0, 0.0 };
+			while (condition(report)) {
+				const auto start = clock_type::now();
+
+				switch (mode) {
+					case one_by_one : {
+						for (size_t i = 0; i < count; ++i) { optimize(optimizer, trainee, m_samples[i]); }
+						break;
+					}
+					case random : {
+						std::shuffle(m_order.begin(), m_order.end(), m_engine);
+						for (size_t i = 0; i < count; ++i) { optimize(optimizer, trainee, m_samples[m_order[i]]); }
+						break;
+					}
+					case mini_batch : {
+						std::shuffle(m_order.begin(), m_order.end(), m_engine);
+						for (size_t i = 0; i < count; i += batch) {
+							const size_t end = std::min(i + batch, count);
+							optimize(
+								optimizer, trainee,
+								sample_iterator(m_samples, m_order.data() + i),
+								sample_iterator(m_samples, m_order.data() + end)
+							);
+						}
+						break;
+					}
+					default : { break; }
+				}
 
-			return epoch;
+				report.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+				report.samples_per_second = 0.0 < report.seconds ? count / report.seconds : 0.0;
+				report.error = _mean_error(trainee);
+				++report.epoch;
+
+				if (m_reporter) { m_reporter(report); }
+			}
+
+			return report.epoch;
+		}
+
+		/**
+		 * @note Training on a data_source instead of the fed samples:
+		 *       every epoch rewinds the source and a prefetcher decodes
+		 *       the following `prefetch` batches on its own thread while
+		 *       the optimizer works on the current one, so loading and
+		 *       training overlap and only those batches are in memory.
+		 *       Batches come in source order; epoch_report::error is the
+		 *       mean error of each batch measured right before its
+		 *       update.
+		 */
+		template <typename _Condition>
+		size_t train_stream(
+			trainee_type&             trainee  ,
+			data_source<sample_type>& source   ,
+			_Condition                condition,
+			step_type                 rate     ,
+			size_t                    batch    ,
+			size_t                    prefetch = 2
+		) {
+			typedef std::chrono::steady_clock clock_type;
+
+			if (0 == batch) { batch = 1; }
+
+			std::vector<size_t> identity(batch);
+			for (size_t i = 0; i < batch; ++i) { identity[i] = i; }
+
+			optimizer_type optimizer(rate);
+
+			/* the error is only measured while training, none is reached before the first epoch */
+			epoch_report report { 0, std::numeric_limits<double>::infinity(), 0.0, 0.0 };
+			while (condition(report)) {
+				if (!source.rewind()) { break; }
+
+				const auto start = clock_type::now();
+
+				size_t     count = 0;
+				error_type sum   = 0.0;
+				{
+					prefetcher<container_type> loader(source, batch, prefetch);
+					while (const container_type* samples = loader.next()) {
+						const size_t size = samples->size();
+						for (size_t i = 0; i < size; ++i) { sum += error(trainee, (*samples)[i]); }
+
+						optimize(
+							optimizer, trainee,
+							sample_iterator(*samples, identity.data()),
+							sample_iterator(*samples, identity.data() + size)
+						);
+						count += size;
+					}
+				}
+
+				report.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+				report.samples_per_second = 0.0 < report.seconds ? count / report.seconds : 0.0;
+				report.error = 0 == count ? 0.0 : sum / count;
+				++report.epoch;
+
+				if (m_reporter) { m_reporter(report); }
+				if (0 == count) { break; }
+			}
+
+			return report.epoch;
 		}
 
 		virtual void optimize(optimizer_type&, trainee_type&, sample_iterator, sample_iterator) { }
 		virtual void optimize(optimizer_type&, trainee_type&, const sample_type&) { }
 
-		//virtual error_type diff(const sample_type&, const )
+		/* per sample error, averaged into epoch_report::error */
+		virtual error_type error(const trainee_type&, const sample_type&) { return 0.0; }
 
 		template <typename _InputItr>
 		void feed(_InputItr first, _InputItr last) {
 			std::copy(first, last, std::back_insert_iterator<container_type>(m_samples));
 		}
 
-		void clear() { m_samples.clear(); }
+		void clear() { m_samples.clear(); m_order.clear(); }
+
+		void set_reporter(reporter_type reporter) { m_reporter = reporter; }
+		void seed(std::mt19937_64::result_type value) { m_engine.seed(value); }
+
+		const container_type& samples() const { return m_samples; }
 
 	private:
-		container_type m_samples;
+		error_type _mean_error(const trainee_type& trainee) {
+			error_type sum = 0.0;
+			for (size_t i = 0; i < m_samples.size(); ++i) { sum += error(trainee, m_samples[i]); }
+			return sum / m_samples.size();
+		}
+
+		container_type      m_samples;
+		std::vector<size_t> m_order;
+		std::mt19937_64     m_engine;
+		reporter_type       m_reporter;
 	};
 }
 